@@ -75,6 +75,11 @@
 // INCLUDE_EXTENDED_FONT					[In development] Should the extended font be made available?  This currently consists of some extra LFO wave shapes that are unused.  So don't turn this on.
 // INCLUDE_CONTROL_BY_NOTE					[In development] Should we allow control of Gizmo by playing notes on the Control channel?
 // INCLUDE_STEP_SEQUENCER_CC_MUTE_TOGGLES	[In development] Should we toggle mutes in the step sequencer?
+// INCLUDE_PROFILER						Time go() and its pieces against the tick budget, viewable in Options and dumpable as sysex.  Costs a little time each tick.
+// INCLUDE_BACKGROUND_SAVE					Save slots, arpeggios, and options to the EEPROM a byte at a time in the background, rather than all at once.  Costs 388 bytes.  See Storage.h
+// INCLUDE_COMPRESSED_SLOTS				Pack slots in the EEPROM so there's room for 15 rather than 9.  Needs INCLUDE_BACKGROUND_SAVE, and costs about 180 more bytes.  See Storage.h
+// INCLUDE_PREFETCH_SEQUENCES				Read the next chained sequence in the background so it's ready on the downbeat.  Costs about 430 bytes.  See Storage.h
+// INCLUDE_TIMED_CLOCK					Send generated MIDI clock bytes from a Timer3 interrupt at each pulse's exact time, rather than on the next tick.  See Timing.h
 
 // -- OPTIONS --
 // USE_ALL_NOTES_OFF						These define how Gizmo kills all sounds.  The Blofeld's Arpeggiated sounds do not respond properly 
@@ -84,6 +89,11 @@
 #define USE_ALL_SOUNDS_OFF
 #define USE_ALL_NOTES_OFF
 
+// TICK_CATCH_UP							What Gizmo does when it has fallen behind its 320us tick: one of TICK_CATCH_UP_BURST,
+//											TICK_CATCH_UP_SKIP, or TICK_CATCH_UP_RESYNC.  See Timing.h.
+
+#define TICK_CATCH_UP TICK_CATCH_UP_BURST
+
 
 
 
@@ -104,6 +114,11 @@
 #define INCLUDE_MEASURE
 
 #define INCLUDE_MEGA_POTS
+//#define INCLUDE_PROFILER
+#define INCLUDE_BACKGROUND_SAVE
+#define INCLUDE_COMPRESSED_SLOTS
+#define INCLUDE_PREFETCH_SEQUENCES
+#define INCLUDE_TIMED_CLOCK
 
 #define MENU_ITEMS()     const char* menuItems[11] = { PSTR("ARPEGGIATOR"), PSTR("STEP SEQUENCER"), PSTR("DRUM SEQUENCER"), PSTR("RECORDER"), PSTR("GAUGE"), PSTR("CONTROLLER"), PSTR("SPLIT"), PSTR("THRU"), PSTR("SYNTH"), PSTR("MEASURE"), options_p };
 #define NUM_MENU_ITEMS  (11)
@@ -232,6 +247,7 @@
 #include "MidiShield.h"
 #include "LEDDisplay.h"
 #include "Division.h"
+#include "Random.h"
 #include "Timing.h"
 #include "Control.h"
 #include "Storage.h"
@@ -246,8 +262,10 @@
 #include "Measure.h"
 #include "Synth.h"
 #include "Sysex.h"
+#include "Profiler.h"
+#include "Scheduler.h"
 
 // This lets everyone have access to the MIDI global, not just
 // the .ino file
-extern midi::MidiInterface<HardwareSerial> MIDI; 
+extern midi::MidiInterface<MidiSerial> MIDI; 
 
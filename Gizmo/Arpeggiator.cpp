@@ -139,7 +139,7 @@ void playArpeggio()
         if (local.arp.number == ARPEGGIATOR_NUMBER_CHORD_REPEAT)
             {
             // we don't call sendAllSoundsOff here because it's too large for the Uno
-            MIDI.sendControlChange(123, 0, options.channelOut);
+            queueMIDI(MIDIChannelControl, 123, 0, options.channelOut);
             }
         else
             {
@@ -225,7 +225,7 @@ void playArpeggio()
                             uint8_t newPosition;
                             do
                                 {
-                                newPosition = random(max + 1);
+                                newPosition = randomBelow(max + 1);
                                 }
                             while(newPosition == local.arp.currentPosition);
                             local.arp.currentPosition = newPosition;
@@ -1000,8 +1000,8 @@ void stateArpeggiatorCreateEdit()
         
         if (lockoutPots ||                                                              // the potUpdated came from NRPN
             local.arp.currentRightPot == -1 ||              // this is the first time data is being updated
-            local.arp.currentRightPot >= newpos && local.arp.currentRightPot - newpos >= 2 ||  // big enough change
-            local.arp.currentRightPot < newpos && newpos - local.arp.currentRightPot >= 2)     // big enough change
+            (local.arp.currentRightPot >= newpos && local.arp.currentRightPot - newpos >= 2) ||  // big enough change
+            (local.arp.currentRightPot < newpos && newpos - local.arp.currentRightPot >= 2))     // big enough change
             {
             local.arp.currentPosition = newpos;
             if (local.arp.currentPosition > data.arp.length)
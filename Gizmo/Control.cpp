@@ -287,27 +287,57 @@ uint32_t computeWaveEndTicks(uint8_t index)
         }
     }
         
+// Returns the current value (0...16383) of the line which goes from startVal at waveStartTicks to endVal
+// at waveEndTicks.  Must only be called while we're between the two.
+//
+// We have no FPU, so rather than compute
+//      currentval = (currenttime - starttime) / (endtime - starttime) * (endval - startval) + startval
+// in floating point every time, we compute the slope (endval - startval) / (endtime - starttime) once per line,
+// as a 16.16 fixed-point number, and add slope * (ticks since last time) to a 16.16 accumulator.  The slope is
+// rounded towards zero by less than 2^-16 a tick, and lines are at most 255 * 195 ticks long, so we're never
+// more than 1 off from the floating-point result.  If the line changes (a new stage, or the pots change the
+// random LFO) we recompute the slope.  Note that |slope * ticks| never exceeds |endval - startval| << 16, which
+// is less than 2^30, so we can't overflow.
+uint16_t interpolateWave(uint16_t startVal, uint16_t endVal)
+    {
+    uint32_t ticks = (options.controlModulationClocked? pulseCount : tickCount);
+    if (startVal != local.control.slopeStartControl || endVal != local.control.slopeEndControl ||
+        local.control.waveStartTicks != local.control.slopeStartTicks || local.control.waveEndTicks != local.control.slopeEndTicks)
+        {
+        // new line
+        local.control.slopeStartControl = startVal;
+        local.control.slopeEndControl = endVal;
+        local.control.slopeStartTicks = local.control.waveStartTicks;
+        local.control.slopeEndTicks = local.control.waveEndTicks;
+        
+        uint32_t length = local.control.waveEndTicks - local.control.waveStartTicks;
+        int32_t delta = ((int32_t)endVal - (int32_t)startVal) << 16;
+        local.control.waveSlope = (length == 0 ? 0 : delta / (int32_t)length);
+        local.control.waveAccumulator = (((int32_t)startVal) << 16) + local.control.waveSlope * (int32_t)(ticks - local.control.waveStartTicks);
+        }
+    else
+        {
+        local.control.waveAccumulator += local.control.waveSlope * (int32_t)(ticks - local.control.waveAccumulatorTicks);
+        }
+    local.control.waveAccumulatorTicks = ticks;
+
+    int32_t val = (local.control.waveAccumulator >> 16);
+    if (val < 0) val = 0;
+    if (val > 16383) val = 16383;
+    return (uint16_t) val;
+    }
+
 uint16_t computeWaveValue(uint8_t startindex, uint8_t endindex)
     {
     // the start wave value is going to be fadeStartControl *if* we're doing FADED, and we just *restarted* (that is,
     // fadeStartControl isn't negative) rather than *started*.  In all other cases, it's just the standard start wave of
     // the given index
-    float _startWaveVal = (options.envelopeMode == ENVELOPE_MODE_FADED && startindex == 0 && local.control.noteOnCount > 0 && local.control.fadeStartControl >= 0 ? 
-        local.control.fadeStartControl : (float)(WAVEVAL(startindex) << 7));
-
-    // (currenttime - starttime) / (endtime - starttime) = (currentval - startval) / (endval - startval)
-    // so currentval = (currenttime - starttime) / (endtime - starttime) * (endval - startval) + startval
-    // Note that the vals are 1 off, so that's why we're subtracting 1
-                                                   
-    float _currentWaveControl = (float)((options.controlModulationClocked? pulseCount : tickCount) - local.control.waveStartTicks) / 
-        (float)(local.control.waveEndTicks - local.control.waveStartTicks) * 
-        (float)((WAVEVAL(endindex) << 7) - _startWaveVal) + _startWaveVal;
-                
-    if (_currentWaveControl < 0) _currentWaveControl = 0;
-    if (_currentWaveControl > 16383) _currentWaveControl = 16383;
-    local.control.fadeWaveControl = _currentWaveControl;                    // we update fadeWaveControl here.  Note: can't be negative.
-        
-    uint16_t currentWaveControl = (uint16_t) _currentWaveControl;
+    uint16_t startWaveVal = (options.envelopeMode == ENVELOPE_MODE_FADED && startindex == 0 && local.control.noteOnCount > 0 && local.control.fadeStartControl >= 0 ? 
+        local.control.fadeStartControl : (WAVEVAL(startindex) << 7));
+
+    uint16_t currentWaveControl = interpolateWave(startWaveVal, WAVEVAL(endindex) << 7);
+    local.control.fadeWaveControl = currentWaveControl;                    // we update fadeWaveControl here.  Note: can't be negative.
+
     if (options.waveControlType == CONTROL_TYPE_CC || 
         options.waveControlType == CONTROL_TYPE_PC ||
         options.waveControlType == CONTROL_TYPE_AFTERTOUCH)  // we're only doing 7 bit, strip off the LSB
@@ -341,6 +371,8 @@ void stateControllerPlayWaveEnvelope()
         local.control.noteOnCount = 0;
         local.control.waveCountDown = WAVE_COUNTDOWN;
         local.control.fadeStartControl = -1;                    // < 0 so FADED works just like GATED the first time around.
+        local.control.fadeWaveControl = -1;                     // likewise, since resetWaveEnvelope(0) copies this into fadeStartControl
+        local.control.slopeEndControl = NO_WAVE_SLOPE;          // so interpolateWave() computes its first line
         entry = false;
         }
 
@@ -349,7 +381,7 @@ void stateControllerPlayWaveEnvelope()
         
     if (newItem && itemType == MIDI_NOTE_OFF)
         {
-        MIDI.sendNoteOff(itemNumber, itemValue, itemChannel);
+        queueMIDI(MIDINoteOff, itemNumber, itemValue, itemChannel);
         if (local.control.noteOnCount > 0)
             {
             local.control.noteOnCount--;
@@ -432,7 +464,7 @@ void stateControllerPlayWaveEnvelope()
     // see hack above
     if (newItem && itemType == MIDI_NOTE_ON)
         {
-        MIDI.sendNoteOn(itemNumber, itemValue, itemChannel); 
+        queueMIDI(MIDINoteOn, itemNumber, itemValue, itemChannel); 
         if (local.control.noteOnCount < 255)
             local.control.noteOnCount++;
         }
@@ -547,7 +579,7 @@ void stateControllerSetWaveEnvelopeValue()
 
 void seedRandomWalk()
     {
-    randomSeed((uint16_t) (currentTime & 0xFFFF));
+    seedRandom(currentTime);
     }
 
 // only generates random walk samples with 2^14 precision, for purposes of MIDI
@@ -560,7 +592,7 @@ uint16_t randomWalkSample(uint16_t current, uint16_t range)
                 
     if (range >= 16256)     // we got a 127 as our range value
         {
-        return random(0, 16384);  // yes, I note the 16384, not 16383.  It's exclusive, not inclusive.
+        return randomBelow(16384);  // yes, I note the 16384, not 16383.  It's exclusive, not inclusive.
         }
                 
     int16_t rand = 0;
@@ -576,7 +608,7 @@ uint16_t randomWalkSample(uint16_t current, uint16_t range)
         // since we're only dealing with numbers 0..2^14
         // the 32768 trick lets us find a random number in a safe region,
         // then make it signed in an easy fashion
-        rand = ((int16_t) random(current + 32768 - range, current + 32768 + (range + 1))) - (int16_t) 32768;
+        rand = ((int16_t) RANDOM_RANGE(current + 32768 - range, current + 32768 + (range + 1))) - (int16_t) 32768;
         if (rand >= 0 && rand < 16384)
             {
             return (uint16_t)(rand);
@@ -587,7 +619,7 @@ uint16_t randomWalkSample(uint16_t current, uint16_t range)
     // take a sample of a range up to 16383.  If we're out of bounds, we subtract the random value instead.
     if (range > 16383)
         range = 16383;
-    rand = ((int16_t) random(current + 32768 - range, current + 32768 + (range + 1))) - (int16_t) 32768;
+    rand = ((int16_t) RANDOM_RANGE(current + 32768 - range, current + 32768 + (range + 1))) - (int16_t) 32768;
     if (rand >= 0 && rand < 16384)
         return (uint16_t)(rand);
     else if ((current - rand + current) >= 0 && (current - rand + current) < 16384)
@@ -626,18 +658,7 @@ uint32_t computeRandomEndTicks()
 
 uint16_t computeRandomValue(uint16_t startVal, uint16_t endVal)
     {
-    // (currenttime - starttime) / (endtime - starttime) = (currentval - startval) / (endval - startval)
-    // so currentval = (currenttime - starttime) / (endtime - starttime) * (endval - startval) + startval
-    // Note that the vals are 1 off, so that's why we're subtracting 1
-    float _currentWaveControl = (float)((options.controlModulationClocked? pulseCount : tickCount) - local.control.waveStartTicks) / 
-        ((float)local.control.waveEndTicks - local.control.waveStartTicks) * 
-        (float)(endVal - (float)startVal) +
-        (float)startVal;
-                
-    if (_currentWaveControl < 0) _currentWaveControl = 0;
-    if (_currentWaveControl > 16383) _currentWaveControl = 16383;
-        
-    uint16_t currentWaveControl = (uint16_t) _currentWaveControl;
+    uint16_t currentWaveControl = interpolateWave(startVal, endVal);
     if (options.waveControlType == CONTROL_TYPE_CC || 
         options.waveControlType == CONTROL_TYPE_PC ||
         options.waveControlType == CONTROL_TYPE_AFTERTOUCH)  // we're only doing 7 bit, strip off the LSB
@@ -659,6 +680,7 @@ void stateControllerPlayRandom()
         local.control.noteOnCount = 0;
         local.control.waveCountDown = WAVE_COUNTDOWN;
         local.control.randomKeyDownOnce = 0;
+        local.control.slopeEndControl = NO_WAVE_SLOPE;          // so interpolateWave() computes its first line
         seedRandomWalk();
         backupOptions = options;  // cause we'll be fiddling with the options
         entry = false;
@@ -669,7 +691,7 @@ void stateControllerPlayRandom()
         
     if (potUpdated[LEFT_POT])
         {
-        options.randomRange = pot[LEFT_POT] >> 3 + 1;  //  / 8
+        options.randomRange = pot[LEFT_POT] >> (3 + 1);  //  / 16, as it has always been, though "/ 8" was perhaps meant
         if (options.randomRange > 127)
             options.randomRange = 127;
         local.control.endWaveControl = randomWalkSample(local.control.endWaveControl, options.randomRange << 7);
@@ -683,7 +705,7 @@ void stateControllerPlayRandom()
 
     if (newItem && itemType == MIDI_NOTE_OFF)
         {
-        MIDI.sendNoteOff(itemNumber, itemValue, itemChannel);
+        queueMIDI(MIDINoteOff, itemNumber, itemValue, itemChannel);
         if (local.control.noteOnCount > 0)
             {
             local.control.noteOnCount--;
@@ -746,7 +768,7 @@ void stateControllerPlayRandom()
     // see hack above
     if (newItem && itemType == MIDI_NOTE_ON)
         {
-        MIDI.sendNoteOn(itemNumber, itemValue, itemChannel); 
+        queueMIDI(MIDINoteOn, itemNumber, itemValue, itemChannel); 
         if (local.control.noteOnCount < 255)
             local.control.noteOnCount++;
         }
@@ -135,8 +135,8 @@ struct _controlLocal
     int8_t wavePosition;
     uint8_t noteOnCount;
     uint16_t currentWaveControl;
-    float fadeWaveControl;		// current wave control so we can set it to start if we're doing FADED
-    float fadeStartControl;		// the very last wave control done prior to resetting the index to 0 for FADED 
+    int16_t fadeWaveControl;		// current wave control so we can set it to start if we're doing FADED
+    int16_t fadeStartControl;		// the very last wave control done prior to resetting the index to 0 for FADED 
     uint32_t waveStartTicks;
     uint32_t waveEndTicks;
     uint8_t waveCountDown;
@@ -144,6 +144,13 @@ struct _controlLocal
     uint16_t startWaveControl;
     uint16_t endWaveControl;
     uint8_t randomKeyDownOnce;
+	int32_t waveSlope;				// 16.16 change in wave control per tick (or pulse) of the current line.  See interpolateWave()
+	int32_t waveAccumulator;		// 16.16 current wave control along the current line
+	uint32_t waveAccumulatorTicks;	// when waveAccumulator was last updated
+	uint16_t slopeStartControl;		// the line waveSlope was computed for...
+	uint16_t slopeEndControl;
+	uint32_t slopeStartTicks;
+	uint32_t slopeEndTicks;
 	uint16_t potUpdateValue[4];
 	uint32_t potUpdateTime[4];
 	uint8_t potWaiting[4];
@@ -162,6 +169,8 @@ struct _controlLocal
 
 #define MAX_RANDOM_TRIES (6)
 
+#define NO_WAVE_SLOPE (16384)			// an impossible wave control value
+
 #define RANDOM_LENGTH_FOREVER (255)
 
 #define RANDOM_MODE_GATED 0
@@ -105,6 +105,16 @@ void setNote(uint8_t group, uint8_t track, uint8_t note, uint8_t val)
         notes &= ~(((unsigned char) 1) << rem);
         }
     SET_NOTES(group, track, div, notes);
+
+    // keep the playback cache up to date
+    if (group == local.drumSequencer.playbackGroup)
+        {
+        uint32_t bit = ((uint32_t) 1) << track;
+        if (val)
+            local.drumSequencer.playbackSteps[note] |= bit;
+        else
+            local.drumSequencer.playbackSteps[note] &= ~bit;
+        }
     }
  
 // Toggle a note from data.slot.data.drumSequencer.data
@@ -129,6 +139,8 @@ void clearNote(uint8_t group, uint8_t track, uint8_t note)
 void clearNotes(uint8_t group, uint8_t track)
     {
     memset(&(data.slot.data.drumSequencer.data[GET_NOTE_OFFSET(group, track)]), 0, (local.drumSequencer.numNotes >> 3));  // / 8
+    if (group == local.drumSequencer.playbackGroup)
+        local.drumSequencer.playbackGroup = DRUM_SEQUENCER_NO_PLAYBACK_GROUP;   // rebuild it next time we play
     }
         
 // Return the pattern (0...15) for a given group and track from data.slot.data.drumSequencer.data
@@ -192,7 +204,7 @@ uint8_t getGroupLength(uint8_t group)
         return local.drumSequencer.numNotes;
     if (gl > local.drumSequencer.numNotes)      /// uh... that's an error
         gl = local.drumSequencer.numNotes;
-    else return gl;
+    return gl;
     }
 
 // Get the note speed (0, 1, 2, 3)
@@ -212,6 +224,8 @@ void setNoteSpeed(uint8_t group, uint8_t noteSpeed)
     // note speed is the low 2 bits
     gt = (gt & (63 << 2)) | noteSpeed;
     SET_GROUP(group, gt);
+    if (group == local.drumSequencer.playbackGroup)
+        local.drumSequencer.playbackGroup = DRUM_SEQUENCER_NO_PLAYBACK_GROUP;   // its speeds have changed
     }
 
 // Get the MIDI channel for a track.  Channels are 0 = Off, 1...16, 17 = Default
@@ -229,6 +243,7 @@ void setMIDIChannel(uint8_t track, uint8_t channel)
     // MIDI Channel is the high 5 bits of byte 0
     gt = (gt & 7) | (channel << 3);
     SET_TRACK0(track, gt);
+    local.drumSequencer.playbackChannel[track] = channel;
     }
 
 // Get the note velocity (volume) for a track.  Legal values are 0, 1, 2, 3, 4, 5, 6, 7 representing MIDI 15, 31, 47, 63, 79, 95, 111, 127
@@ -253,6 +268,7 @@ void setNoteVelocity(uint8_t track, uint8_t velocity)
     // Note Velocity is the low 3 bits of byte 0
     gt = (gt & 0xF8) | velocity;                                            // 0xF8 is 11111000
     SET_TRACK0(track, gt);
+    local.drumSequencer.playbackVelocity[track] = getNoteMIDIVelocity(track);
     }
 
 // Get the note pitch for a track.  Legal values are 0...127
@@ -270,6 +286,7 @@ void setNotePitch(uint8_t track, uint8_t pitch)
     // Note Pitch is the high 7 bits of byte 1
     gt = (gt & 1) | (pitch << 1);
     SET_TRACK1(track, gt);
+    local.drumSequencer.playbackPitch[track] = pitch;
     }
 
 // Get the mute for a track (0 or 1)
@@ -328,6 +345,76 @@ void clearCurrentTrackInGroup()
 
 
 
+///// A NOTE ON THE PLAYBACK CACHE
+/////
+///// Digging a note out of the packed data takes several multiplies (see GET_NOTE_OFFSET), and
+///// playDrumSequencer() would have to do it for every track on every step.  So instead we keep
+///// the current group's notes in local.drumSequencer.playbackSteps, one 32-bit mask of tracks per step,
+///// along with each track's channel, pitch, and MIDI velocity.  Playing a step is then just ANDing
+///// its mask with local.drumSequencer.shouldPlay and sending a note for each bit that's left.
+/////
+///// The cache also holds, for each speed (see SPEEDS in DrumSequencer.h), a mask of the tracks
+///// at that speed and the speed's ratio times the group's ratio, so the tracks at one speed can
+///// all be stepped together.
+/////
+///// setNote(), setMIDIChannel(), setNoteVelocity(), and setNotePitch() keep the cache up to date.
+///// clearNotes(), setNoteSpeed(), and changing a track's speed instead set playbackGroup to 
+///// DRUM_SEQUENCER_NO_PLAYBACK_GROUP, and playDrumSequencer() rebuilds the cache whenever 
+///// playbackGroup isn't the current group.  If you change the note or track data any other way, 
+///// call buildDrumSequencerPlaybackCache().
+
+// The speed ratios, numerator over denominator.  The first four are the group note speeds.
+GLOBAL static const uint8_t drumSequencerSpeedNumerator[DRUM_SEQUENCER_NUM_SPEEDS] = { 1, 2, 4, 1, 3, 3, 5, 2 };
+GLOBAL static const uint8_t drumSequencerSpeedDenominator[DRUM_SEQUENCER_NUM_SPEEDS] = { 1, 1, 1, 2, 2, 4, 8, 3 };
+
+void buildDrumSequencerPlaybackCache()
+    {
+    uint8_t group = local.drumSequencer.currentGroup;
+    uint8_t numNoteBytes = NUM_NOTE_BYTES;
+    uint16_t offset = GET_NOTE_OFFSET(group, 0);
+
+    uint8_t groupSpeed = getNoteSpeed(group);
+    local.drumSequencer.playbackSwingSpeeds = 0;
+    for(uint8_t speed = 0; speed < DRUM_SEQUENCER_NUM_SPEEDS; speed++)
+        {
+        uint8_t increment = drumSequencerSpeedNumerator[groupSpeed] * drumSequencerSpeedNumerator[speed];
+        uint8_t period = drumSequencerSpeedDenominator[groupSpeed] * drumSequencerSpeedDenominator[speed];
+        local.drumSequencer.playbackSpeedTracks[speed] = 0;
+        local.drumSequencer.playbackSpeedIncrement[speed] = increment;
+        local.drumSequencer.playbackSpeedPeriod[speed] = period;
+
+        // is the ratio a power of two?
+        uint8_t ratio = (increment >= period ? increment / period : period / increment);
+        if ((increment % period == 0 || period % increment == 0) && (ratio & (ratio - 1)) == 0)
+            local.drumSequencer.playbackSwingSpeeds |= (1 << speed);
+        }
+
+    memset(local.drumSequencer.playbackSteps, 0, sizeof(local.drumSequencer.playbackSteps));
+    for(uint8_t track = 0; track < local.drumSequencer.numTracks; track++)
+        {
+        uint32_t bit = ((uint32_t) 1) << track;
+        for(uint8_t i = 0; i < numNoteBytes; i++)
+            {
+            uint8_t notes = data.slot.data.drumSequencer.data[offset++];
+            uint8_t step = i << 3;          // * 8
+            while(notes)
+                {
+                if (notes & 1)
+                    local.drumSequencer.playbackSteps[step] |= bit;
+                notes = notes >> 1;
+                step++;
+                }
+            }
+        local.drumSequencer.playbackChannel[track] = getMIDIChannel(track);
+        local.drumSequencer.playbackPitch[track] = getNotePitch(track);
+        local.drumSequencer.playbackVelocity[track] = getNoteMIDIVelocity(track);
+        local.drumSequencer.playbackSpeedTracks[local.drumSequencer.trackSpeed[track]] |= bit;
+        }
+    local.drumSequencer.playbackGroup = group;
+    }
+
+
+
 
 
 
@@ -367,6 +454,7 @@ void initDrumSequencer(uint8_t format)
     local.drumSequencer.markPosition = DRUM_SEQUENCER_NO_MARK;
     local.drumSequencer.markTrack = DRUM_SEQUENCER_NO_MARK;
     local.drumSequencer.markTransition = DRUM_SEQUENCER_NO_MARK;
+    memset(local.drumSequencer.trackSpeed, DRUM_SEQUENCER_TRACK_SPEED_DEFAULT, MAX_DRUM_SEQUENCER_TRACKS);
     
     for(uint8_t t = 0; t < numFormatTracks(format); t++)
         {
@@ -419,8 +507,9 @@ void initDrumSequencer(uint8_t format)
     for(uint8_t i = 0; i < local.drumSequencer.numTracks; i++)
         {
         local.drumSequencer.muted[i] = (getMute(i) ? DRUM_SEQUENCER_MUTED : DRUM_SEQUENCER_NOT_MUTED);
-        local.drumSequencer.shouldPlay[i] = 1;  // doesn't matter
         }
+    local.drumSequencer.shouldPlay = 0xFFFFFFFF;  // doesn't matter
+    buildDrumSequencerPlaybackCache();
     }
 
 
@@ -581,6 +670,7 @@ void unpackDrumSequenceData()
     local.drumSequencer.markPosition = DRUM_SEQUENCER_NO_MARK;
     local.drumSequencer.markTrack = DRUM_SEQUENCER_NO_MARK;
     local.drumSequencer.markTransition = DRUM_SEQUENCER_NO_MARK;
+    memset(local.drumSequencer.trackSpeed, DRUM_SEQUENCER_TRACK_SPEED_DEFAULT, MAX_DRUM_SEQUENCER_TRACKS);         // not saved
 
     // unpacking
     local.drumSequencer.nextSequence = (data.slot.data.drumSequencer.repeat & 0x0F);
@@ -593,8 +683,9 @@ void unpackDrumSequenceData()
     for(uint8_t i = 0; i < local.drumSequencer.numTracks; i++)
         {
         local.drumSequencer.muted[i] = (getMute(i) ? DRUM_SEQUENCER_MUTED : DRUM_SEQUENCER_NOT_MUTED);
-        local.drumSequencer.shouldPlay[i] = 1;  // doesn't matter
         }
+    local.drumSequencer.shouldPlay = 0xFFFFFFFF;  // doesn't matter
+    buildDrumSequencerPlaybackCache();
     }
 
 
@@ -607,7 +698,7 @@ void loadDrumSequence(uint8_t slot)
         }
     else
         {
-        loadSlot(slot);
+        loadPrefetchedSlot(slot);
         unpackDrumSequenceData();               // will this reset too much stuff?
         resetDrumSequencerSequenceCountdown();          // do I need this?
         }
@@ -658,12 +749,24 @@ int16_t drumSequencerGetNewCursorXPos(uint8_t trackLen)
 
 
 
+// Restarts the speed clocks so that every speed steps to position 0 together, 
+// on the next step of speed 0.  See SPEEDS in DrumSequencer.h
+static void resetDrumSequencerClocks()
+    {
+    memset(local.drumSequencer.speedAccumulator, 0, sizeof(local.drumSequencer.speedAccumulator));
+    memset(local.drumSequencer.speedPlayPosition, getGroupLength(local.drumSequencer.currentGroup) - 1, DRUM_SEQUENCER_NUM_SPEEDS);
+    local.drumSequencer.clocksReset = true;
+    local.drumSequencer.clocksOnNotePulse = true;       // playDrumSequencer() checks when speed 0 next steps
+    local.drumSequencer.swinging = 0;
+    }
+
 // Resets the sequence playing
 void resetDrumSequencer()
     {
     // reset drum sequencer
     local.drumSequencer.currentPlayPosition = getGroupLength(local.drumSequencer.currentGroup) - 1;
     resetDrumSequencerTransitionCountdown();
+    resetDrumSequencerClocks();
     }
 
 
@@ -764,11 +867,11 @@ void goNextTransition()
             local.drumSequencer.transitionRepeat[local.drumSequencer.currentTransition] != DRUM_SEQUENCER_TRANSITION_OTHER_END)
             {
             // Groups are going to be either 1-2, 1-3, or 1-4
-            uint8_t grouptype = div5(local.drumSequencer.transitionRepeat - 1);             // remove END
+            uint8_t grouptype = div5(local.drumSequencer.transitionRepeat[local.drumSequencer.currentTransition] - 1);             // remove END
             // repeats are LOOP, 1, 2, 3, or 4
-            uint8_t repeat = DIV5_REMAINDER(grouptype, local.drumSequencer.transitionRepeat - 1);           // remove END
+            uint8_t repeat = DIV5_REMAINDER(grouptype, local.drumSequencer.transitionRepeat[local.drumSequencer.currentTransition] - 1);           // remove END
             // Pick a group
-            uint8_t group = random(0, grouptype + 2);
+            uint8_t group = randomBelow(grouptype + 2);
             drumSequencerUpdateGroup(group);
             // override the countdown which was set by resetDrumSequencerTransitionCountdown() called by drumSequencerUpdateGroup()
             if (repeat == 0)                // LOOP
@@ -794,9 +897,9 @@ void goNextTransition()
             local.drumSequencer.transitionRepeat[local.drumSequencer.currentTransition] != DRUM_SEQUENCER_TRANSITION_OTHER_END)
             {
             // gotta pick a new random group
-            uint8_t grouptype = div5(local.drumSequencer.transitionRepeat);
-            uint8_t group = random(0, grouptype + 2);
-            drumSequencerUpdateGroup(local.drumSequencer.transitionGroup[local.drumSequencer.currentTransition]);
+            uint8_t grouptype = div5(local.drumSequencer.transitionRepeat[local.drumSequencer.currentTransition] - 1);      // remove END
+            uint8_t group = randomBelow(grouptype + 2);
+            drumSequencerUpdateGroup(group);
             }
         }
     else if (local.drumSequencer.performanceMode && local.drumSequencer.transitionCountdown == 255 && 
@@ -1127,10 +1230,12 @@ void stateDrumSequencerMenuSwapTracks()
         uint8_t toNotePitch = getNotePitch(toTrack);
         setNotePitch(toTrack, fromNotePitch);
         setNotePitch(fromTrack, toNotePitch);
-        uint8_t fromMute = local.drumSequencer.muted[fromTrack];
-        uint8_t toMute = local.drumSequencer.muted[toTrack];
         local.drumSequencer.muted[toTrack] = fromNotePitch;
         local.drumSequencer.muted[fromTrack] = toNotePitch;
+        uint8_t fromSpeed = local.drumSequencer.trackSpeed[fromTrack];
+        local.drumSequencer.trackSpeed[fromTrack] = local.drumSequencer.trackSpeed[toTrack];
+        local.drumSequencer.trackSpeed[toTrack] = fromSpeed;
+        buildDrumSequencerPlaybackCache();
 
         goUpState(STATE_DRUM_SEQUENCER_PLAY);
         }
@@ -1170,8 +1275,9 @@ void stateDrumSequencerMenuCopyTrack()
         setNoteVelocity(toTrack, fromNoteVelocity);
         uint8_t fromNotePitch = getNotePitch(fromTrack);
         setNotePitch(toTrack, fromNotePitch);
-        uint8_t fromMute = local.drumSequencer.muted[fromTrack];
         local.drumSequencer.muted[toTrack] = fromNotePitch;
+        local.drumSequencer.trackSpeed[toTrack] = local.drumSequencer.trackSpeed[fromTrack];
+        buildDrumSequencerPlaybackCache();
 
         goUpState(STATE_DRUM_SEQUENCER_PLAY);
         }
@@ -1604,9 +1710,9 @@ void stateDrumSequencerMenuPerformanceRepeat()
         
 void stateDrumSequencerMenuPerformanceNext()
     {
-// The values are END, 0, 1, ..., 8
-// These correspond with stored values (in the high 4 bits of repeat) of 0...9
-    uint8_t result = doNumericalDisplay(-1, 8, ((int16_t)(local.drumSequencer.nextSequence - 1)), true, GLYPH_NONE);
+// The values are END, 0, 1, ..., NUM_SLOTS - 1
+// These correspond with stored values (in the low 4 bits of repeat) of 0...NUM_SLOTS
+    uint8_t result = doNumericalDisplay(-1, NUM_SLOTS - 1, ((int16_t)(local.drumSequencer.nextSequence - 1)), true, GLYPH_NONE);
     playDrumSequencer();
     switch (result)
         {
@@ -1737,6 +1843,39 @@ void stateDrumSequencerMenuDefaultVelocity()
     }
 
 
+// Sets the current track's speed relative to its group.  Track speeds aren't saved.
+void stateDrumSequencerTrackSpeed()
+    {
+    uint8_t result;
+    if (entry) 
+        {
+        defaultMenuValue = local.drumSequencer.trackSpeed[local.drumSequencer.currentTrack];
+        }
+    const char* menuItems[DRUM_SEQUENCER_NUM_SPEEDS] = { PSTR("1"), PSTR("2"), PSTR("4"), PSTR("1/2"), PSTR("3/2"), PSTR("3/4"), PSTR("5/8"), PSTR("2/3") };
+    result = doMenuDisplay(menuItems, DRUM_SEQUENCER_NUM_SPEEDS, STATE_NONE, STATE_NONE, 1);
+    switch (result)
+        {
+        case NO_MENU_SELECTED:
+            {
+            }
+        break;
+        case MENU_SELECTED:
+            {
+            local.drumSequencer.trackSpeed[local.drumSequencer.currentTrack] = currentDisplay;
+            local.drumSequencer.playbackGroup = DRUM_SEQUENCER_NO_PLAYBACK_GROUP;   // rebuild it next time we play
+            goUpState(immediateReturn ? immediateReturnState : STATE_DRUM_SEQUENCER_MENU);
+            }
+        break;
+        case MENU_CANCELLED:
+            {
+            goUpState(immediateReturn ? immediateReturnState : STATE_DRUM_SEQUENCER_MENU);
+            }
+        break;
+        }
+    playDrumSequencer();
+    }
+
+
 // Writes to the screen the current note.  Useful for quickly determining the current note of a track
 void stateDrumSequencerPitchBack()
     {
@@ -2220,7 +2359,6 @@ void drawDrumSequencer(uint8_t trackLen, uint8_t numTracks, uint8_t skip)
         for (uint8_t d = 0; d < trackLen; d++)
             {
             uint8_t shouldDrawMuted = drumSequencerShouldMuteTrack(t);
-            uint16_t pos = (t * (uint16_t) trackLen + d) * 2;
             uint8_t vel = getNote(local.drumSequencer.currentGroup, t, d);
                 
             if (shouldDrawMuted)
@@ -2332,7 +2470,7 @@ void drawDrumSequencer(uint8_t trackLen, uint8_t numTracks, uint8_t skip)
         }       
         
     // is our track scheduled to play?
-    if (local.drumSequencer.shouldPlay[local.drumSequencer.currentTrack])
+    if ((local.drumSequencer.shouldPlay >> local.drumSequencer.currentTrack) & 1)
         setPoint(led, 4, 1);
                 
     // draw drum region
@@ -2380,9 +2518,9 @@ void drawDrumSequencer(uint8_t trackLen, uint8_t numTracks, uint8_t skip)
 // Sends a Note ON to the appropriate MIDI channel at the appropriate pitch and velocity
 void sendTrackNote(uint8_t track)
     {
-    uint8_t velocity = getNoteMIDIVelocity(track);
-    uint8_t out = getMIDIChannel(track);                        
-    uint8_t note = getNotePitch(track);
+    uint8_t velocity = local.drumSequencer.playbackVelocity[track];
+    uint8_t out = local.drumSequencer.playbackChannel[track];                        
+    uint8_t note = local.drumSequencer.playbackPitch[track];
     if (out == DRUM_SEQUENCER_MIDI_OUT_DEFAULT)         // 17 
         out = options.channelOut;
     if (out != DRUM_SEQUENCER_NO_MIDI_OUT)
@@ -2391,148 +2529,301 @@ void sendTrackNote(uint8_t track)
         }
     }
 
-// Plays the current sequence
+// Does the given speed step on the note pulse (and swing with it)?  It must be exactly the note
+// speed, and the clocks must have been reset on a note pulse.
+#define DRUM_SEQUENCER_STRAIGHT_SPEED(speed) (local.drumSequencer.clocksOnNotePulse && \
+    local.drumSequencer.playbackSpeedIncrement[speed] == local.drumSequencer.playbackSpeedPeriod[speed])
+
+// Returns the clock period of the given speed of the current group: it steps every period / increment pulses.
+// A speed can't step more than once a pulse, so faster ones are slowed down to that.
+static uint16_t getDrumSequencerSpeedPeriod(uint8_t speed)
+    {
+    uint16_t period = notePulseRate * (uint16_t) local.drumSequencer.playbackSpeedPeriod[speed];
+    uint8_t increment = local.drumSequencer.playbackSpeedIncrement[speed];
+    return (period < increment ? increment : period);
+    }
+
+// Returns how many pulses the given number of steps at the given group's own speed take
+static uint32_t getDrumSequencerGroupPulses(uint8_t group, uint16_t steps)
+    {
+    uint8_t speed = getNoteSpeed(group);
+    uint8_t increment = drumSequencerSpeedNumerator[speed];
+    uint16_t period = notePulseRate * (uint16_t) drumSequencerSpeedDenominator[speed];
+    if (period < increment) period = increment;
+    return (steps * (uint32_t) period) / increment;
+    }
+
+// Returns true if we're past the midpoint between the group's current step and its next one
+static uint8_t drumSequencerNearNextStep()
+    {
+    if (DRUM_SEQUENCER_STRAIGHT_SPEED(0))
+        return (notePulseCountdown <= (notePulseRate >> 1));
+    else
+        return (local.drumSequencer.speedAccumulator[0] * 2 <= getDrumSequencerSpeedPeriod(0));
+    }
+
+// Decides which tracks play this time through the current group, according to their
+// patterns and local.drumSequencer.patternCountup.  Called at position 0.
+static void chooseDrumSequencerPatterns()
+    {
+    uint8_t numTracks = local.drumSequencer.numTracks;
+        
+    // pick an exclusive random track
+    uint8_t exclusiveTrack = 0;
+    uint8_t trkcount = 0;
+    for(uint8_t track = 0; track < numTracks; track++)
+        {
+        if (getPattern(local.drumSequencer.currentGroup, track) == DRUM_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
+            {
+            if ((trkcount == 0) || (randomBelow(trkcount + 1) == 0))  // this could work without the trakcount == 0 but I save a call to randomBelow() here 
+                {
+                exclusiveTrack = track;
+                }
+            trkcount++;
+            }
+        }
+                        
+    uint32_t shouldPlay = 0;
+    for(uint8_t track = 0; track < numTracks; track++)
+        {
+        uint8_t pattern = getPattern(local.drumSequencer.currentGroup, track);
+        uint8_t play;
+        // pick a random track                          
+        if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
+            {
+            play = (track == exclusiveTrack);
+            }
+        else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_3_4)
+            {
+            play = (random16() < RANDOM_PROBABILITY_3_4);
+            }
+        else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_1_2)
+            {
+            play = (random16() < RANDOM_PROBABILITY_1_2);
+            }
+        else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_1_4)
+            {
+            play = (random16() < RANDOM_PROBABILITY_1_4);
+            }
+        else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_1_8)
+            {
+            play = (random16() < RANDOM_PROBABILITY_1_8);
+            }
+        else
+            {
+            play = ((pattern >> (local.drumSequencer.patternCountup & 3)) & 1);                        
+            }
+        if (play)
+            shouldPlay |= ((uint32_t) 1) << track;
+        }
+    local.drumSequencer.shouldPlay = shouldPlay;
+    }
+
+// Plays the notes the given tracks have, if their patterns let them play this time round 
+// and they're not muted
+static void playDrumSequencerTracks(uint32_t tracks)
+    {
+    // Only the tracks with a note here that the pattern lets play are left, so we only check mute/solo for them
+    tracks &= local.drumSequencer.shouldPlay;
+    for(uint8_t track = 0; tracks != 0; track++)
+        {
+        if ((tracks & 1) && !drumSequencerShouldMuteTrack(track))
+            {
+            sendTrackNote(track);         
+            }
+        tracks = tracks >> 1;
+        }
+    }
+
+// Returns the tracks at the given speed with a note at its play position
+static uint32_t getDrumSequencerSpeedTracks(uint8_t speed)
+    {
+    uint8_t position = (speed == 0 ? local.drumSequencer.currentPlayPosition : local.drumSequencer.speedPlayPosition[speed]);
+    return local.drumSequencer.playbackSteps[position] & local.drumSequencer.playbackSpeedTracks[speed];
+    }
+
+// Called when a speed which doesn't step on the note pulse has just stepped to POSITION.  If
+// it swings, holds the step back (every other one, starting with the second) by the swing's 
+// fraction of a step, just as updateTimers() holds back the note pulse, and returns true.
+static uint8_t swingDrumSequencerStep(uint8_t speed, uint8_t position)
+    {
+    if ((position & 1) && options.swing > 0 && NOTE_SPEED_SWINGS(options.noteSpeedType) &&
+        ((local.drumSequencer.playbackSwingSpeeds >> speed) & 1))
+        {
+        local.drumSequencer.speedSwingTime[speed] = currentTime + 
+            div100(getDrumSequencerSpeedPeriod(speed) * getMicrosecsPerPulse() * options.swing) / local.drumSequencer.playbackSpeedIncrement[speed];
+        local.drumSequencer.swinging |= (1 << speed);
+        return true;
+        }
+    return false;
+    }
+
+// Plays the held-back steps which are due, and those of the speeds in FORCE whether they're due or not
+static void playDrumSequencerSwings(uint8_t force)
+    {
+    for(uint8_t speed = 0; speed < DRUM_SEQUENCER_NUM_SPEEDS; speed++)
+        {
+        if (((local.drumSequencer.swinging >> speed) & 1) &&
+            (((force >> speed) & 1) || TIME_GREATER_THAN_OR_EQUAL(currentTime, local.drumSequencer.speedSwingTime[speed])))
+            {
+            local.drumSequencer.swinging &= ~(1 << speed);
+            playDrumSequencerTracks(getDrumSequencerSpeedTracks(speed));
+            }
+        }
+    }
+
+// Plays the current sequence.  Each speed's clock (see SPEEDS in DrumSequencer.h) is a 
+// fractional pulse accumulator: on each pulse it steps if it's below the speed's increment, 
+// adding the speed's period, and then subtracts the increment.  Speed 0 is stepped first, 
+// since it may change the group and so everyone's speeds.
 void playDrumSequencer()
     {
     // we redo this rather than take it from stateDrumSequencerPlay because we may be 
     // called from other methods as well 
         
-    uint8_t trackLen = getGroupLength(local.drumSequencer.currentGroup);
     uint8_t numTracks = local.drumSequencer.numTracks;
         
     if ((local.drumSequencer.playState == PLAY_STATE_WAITING) && beat)
         local.drumSequencer.playState = PLAY_STATE_PLAYING;
         
-    if (notePulse && (local.drumSequencer.playState == PLAY_STATE_PLAYING))
+    if ((pulse || notePulse || local.drumSequencer.swinging) && (local.drumSequencer.playState == PLAY_STATE_PLAYING))
         {
-        uint8_t oldPlayPosition = local.drumSequencer.currentPlayPosition;
-        local.drumSequencer.currentPlayPosition = incrementAndWrap(local.drumSequencer.currentPlayPosition, trackLen);
+        if (local.drumSequencer.playbackGroup != local.drumSequencer.currentGroup)
+            buildDrumSequencerPlaybackCache();
+        
+        if (local.drumSequencer.swinging)
+            playDrumSequencerSwings(0);
         
-        if (local.drumSequencer.currentPlayPosition == 0)
+        uint8_t straight = notePulse;               // do the speeds which step on the note pulse step?
+        uint8_t clocked = !DRUM_SEQUENCER_STRAIGHT_SPEED(0);
+        uint8_t stepped = (clocked ? 
+            pulse && local.drumSequencer.speedAccumulator[0] < local.drumSequencer.playbackSpeedIncrement[0] :
+            notePulse);
+        uint32_t tracks = 0;
+        
+        if (stepped)
             {
-            if (local.drumSequencer.performanceMode)
-                goNextTransition();
+            uint8_t trackLen = getGroupLength(local.drumSequencer.currentGroup);
+            
+            // A step still held back plays before we move on, and all of them before a new pass,
+            // which may change the group
+            if (local.drumSequencer.swinging)
+                playDrumSequencerSwings(local.drumSequencer.currentPlayPosition + 1 >= trackLen ? 0xFF : 1);
                 
-            uint8_t noteSpeed = getNoteSpeed(local.drumSequencer.currentGroup);
-            uint8_t expectedRate = getNotePulseRateFor(options.noteSpeedType);
-            if (noteSpeed == 1)     // x2
-                {
-                local.drumSequencer.invalidNoteSpeed = (((expectedRate >> 1) * 2) != expectedRate);  // uh oh
-                expectedRate = expectedRate >> 1;       // divide by two
-                if (expectedRate == 0) expectedRate = 1;
-                }
-            else if (noteSpeed == 2)        // x2
+            local.drumSequencer.currentPlayPosition = incrementAndWrap(local.drumSequencer.currentPlayPosition, trackLen);
+
+#ifdef INCLUDE_PREFETCH_SEQUENCES
+            // get the next sequence ready ahead of time
+            if (local.drumSequencer.performanceMode && local.drumSequencer.nextSequence != DRUM_SEQUENCER_NEXT_SEQUENCE_END)
+                prefetchSlot(local.drumSequencer.nextSequence - 1);
+#endif INCLUDE_PREFETCH_SEQUENCES
+        
+            if (local.drumSequencer.currentPlayPosition == 0)
                 {
-                local.drumSequencer.invalidNoteSpeed = (((expectedRate >> 2) * 4) != expectedRate);  // uh oh
-                expectedRate = expectedRate >> 2;       // divide by four
-                if (expectedRate == 0) expectedRate = 1;
+                if (local.drumSequencer.performanceMode)
+                    goNextTransition();
+                
+                if (local.drumSequencer.playbackGroup != local.drumSequencer.currentGroup)
+                    buildDrumSequencerPlaybackCache();
+                        
+                // is some speed too fast to play at this note speed?
+                local.drumSequencer.invalidNoteSpeed = false;
+                for(uint8_t speed = 0; speed < DRUM_SEQUENCER_NUM_SPEEDS; speed++)
+                    {
+                    if ((speed == 0 || local.drumSequencer.playbackSpeedTracks[speed] != 0) &&
+                        notePulseRate * (uint16_t) local.drumSequencer.playbackSpeedPeriod[speed] < local.drumSequencer.playbackSpeedIncrement[speed])
+                        local.drumSequencer.invalidNoteSpeed = true;            // uh oh
+                    }
                 }
-            else if (noteSpeed == 3)        // /2
+        
+            // change scheduled mute?
+            if (local.drumSequencer.performanceMode && local.drumSequencer.currentPlayPosition == 0)
                 {
-                local.drumSequencer.invalidNoteSpeed = (expectedRate >= 144);   // uh oh
-                if (expectedRate < 144)
-                    expectedRate = expectedRate << 1;       // multiply by two
+                for(uint8_t track = 0; track < numTracks; track++)
+                    {
+                    if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_ON_SCHEDULED)
+                        local.drumSequencer.muted[track] = DRUM_SEQUENCER_MUTED;
+                    else if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_OFF_SCHEDULED)
+                        local.drumSequencer.muted[track] = DRUM_SEQUENCER_NOT_MUTED;
+                    else if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_ON_SCHEDULED_ONCE)
+                        local.drumSequencer.muted[track] = DRUM_SEQUENCER_MUTE_OFF_SCHEDULED;
+                    else if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_OFF_SCHEDULED_ONCE)
+                        local.drumSequencer.muted[track] = DRUM_SEQUENCER_MUTE_ON_SCHEDULED;
+                    }
+                
+                if (local.drumSequencer.solo == DRUM_SEQUENCER_SOLO_ON_SCHEDULED)
+                    local.drumSequencer.solo = DRUM_SEQUENCER_SOLO;
+                else if (local.drumSequencer.solo == DRUM_SEQUENCER_SOLO_OFF_SCHEDULED)
+                    local.drumSequencer.solo = DRUM_SEQUENCER_NO_SOLO;
                 }
-                        
-            //// FIXME: this will divide some rates by two that don't exist.
-            //// For example, 36 can't be divided by 4 (there is no 9)
-            //// and 8 can't be divided by 2 (there is no 9) and
-            //// 6 can't be divided by 4 (there is no 1.5) and
-            //// 3 can't be divided by 2 or 4 and
-            //// 2 can't be divided by 2 and
-            //// 1 can't be divided by 2 or 4 and
-            //// 144 and 192 can't be multiplied against 2
-            //// We'll make sure it doesn't go to 0 but beyond that we have
-            //// to figure out what the appropriate behavior should be
-                        
-            if (notePulseRate != expectedRate)      // gotta change it
+
+            if (local.drumSequencer.currentPlayPosition == 0)
                 {
-                setRawNotePulseRate(expectedRate, false);
+                local.drumSequencer.patternCountup++;
                 }
-            }
-        
-        // change scheduled mute?
-        if (local.drumSequencer.performanceMode && local.drumSequencer.currentPlayPosition == 0)
-            {
-            for(uint8_t track = 0; track < numTracks; track++)
+
+            if (local.drumSequencer.currentPlayPosition == 0)
                 {
-                if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_ON_SCHEDULED)
-                    local.drumSequencer.muted[track] = DRUM_SEQUENCER_MUTED;
-                else if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_OFF_SCHEDULED)
-                    local.drumSequencer.muted[track] = DRUM_SEQUENCER_NOT_MUTED;
-                else if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_ON_SCHEDULED_ONCE)
-                    local.drumSequencer.muted[track] = DRUM_SEQUENCER_MUTE_OFF_SCHEDULED;
-                else if (local.drumSequencer.muted[track] == DRUM_SEQUENCER_MUTE_OFF_SCHEDULED_ONCE)
-                    local.drumSequencer.muted[track] = DRUM_SEQUENCER_MUTE_ON_SCHEDULED;
+                chooseDrumSequencerPatterns();
                 }
+                        
+            // If the clocks were just restarted, the speeds which are exactly the note speed can
+            // only step on the note pulse if this step is on one too.  Else they're clocked like
+            // the rest until the clocks are next restarted.  We never move the note pulse.
+            if (local.drumSequencer.clocksReset)
+                local.drumSequencer.clocksOnNotePulse = (!clocked || (notePulse && notePulseCountdown == notePulseRate));
+            local.drumSequencer.clocksReset = false;
                 
-            if (local.drumSequencer.solo == DRUM_SEQUENCER_SOLO_ON_SCHEDULED)
-                local.drumSequencer.solo = DRUM_SEQUENCER_SOLO;
-            else if (local.drumSequencer.solo == DRUM_SEQUENCER_SOLO_OFF_SCHEDULED)
-                local.drumSequencer.solo = DRUM_SEQUENCER_NO_SOLO;
+            if (DRUM_SEQUENCER_STRAIGHT_SPEED(0) || !swingDrumSequencerStep(0, local.drumSequencer.currentPlayPosition))
+                tracks = getDrumSequencerSpeedTracks(0);
             }
 
-        if (local.drumSequencer.currentPlayPosition == 0)
+        // If we changed group, this is now the new group's clock, which has just been reset
+        if (DRUM_SEQUENCER_STRAIGHT_SPEED(0))
             {
-            local.drumSequencer.patternCountup++;
+            local.drumSequencer.speedAccumulator[0] = 0;                // not used
             }
-
-// pick an exclusive random track
-        uint8_t exclusiveTrack = 0;
-        if (local.drumSequencer.currentPlayPosition == 0)
+        else
             {
-            uint8_t trkcount = 0;
-            for(uint8_t track = 0; track < numTracks; track++)
-                {
-                if (getPattern(local.drumSequencer.currentGroup, track) == DRUM_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
-                    {
-                    if ((trkcount == 0) || (random() < RANDOM_MAX / (trkcount + 1)))  // this could work without the trakcount == 0 but I save a call to random() here 
-                        {
-                        exclusiveTrack = track;
-                        }
-                    trkcount++;
-                    }
-                }
+            local.drumSequencer.speedAccumulator[0] = local.drumSequencer.speedAccumulator[0] + 
+                (stepped ? getDrumSequencerSpeedPeriod(0) : 0) - (pulse ? local.drumSequencer.playbackSpeedIncrement[0] : 0);
             }
-                        
-        for(uint8_t track = 0; track < numTracks; track++)
+                
+        // The other speeds wait for speed 0 after they've been reset
+        if (!local.drumSequencer.clocksReset)
             {
-            if (local.drumSequencer.currentPlayPosition == 0)
+            uint8_t trackLen = getGroupLength(local.drumSequencer.currentGroup);
+            for(uint8_t speed = 1; speed < DRUM_SEQUENCER_NUM_SPEEDS; speed++)
                 {
-                uint8_t pattern = getPattern(local.drumSequencer.currentGroup, track);
-                // pick a random track                          
-                if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
-                    {
-                    local.drumSequencer.shouldPlay[track] = (track == exclusiveTrack);
-                    }
-                else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_3_4)
+                uint8_t speedStepped;
+                if (DRUM_SEQUENCER_STRAIGHT_SPEED(speed))
                     {
-                    local.drumSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 4) * 3);
+                    speedStepped = straight;
+                    local.drumSequencer.speedAccumulator[speed] = 0;        // not used
                     }
-                else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_1_2)
+                else if (pulse)
                     {
-                    local.drumSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 2));
+                    uint8_t increment = local.drumSequencer.playbackSpeedIncrement[speed];
+                    speedStepped = (local.drumSequencer.speedAccumulator[speed] < increment);
+                    local.drumSequencer.speedAccumulator[speed] = local.drumSequencer.speedAccumulator[speed] + 
+                        (speedStepped ? getDrumSequencerSpeedPeriod(speed) : 0) - increment;
                     }
-                else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_1_4)
-                    {
-                    local.drumSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 4));
-                    }
-                else if (pattern == DRUM_SEQUENCER_PATTERN_RANDOM_1_8)
-                    {
-                    local.drumSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 8));
-                    }
-                else
+                else continue;
+                                
+                if (speedStepped)
                     {
-                    local.drumSequencer.shouldPlay[track] = ((pattern >> (local.drumSequencer.patternCountup & 3)) & 1);                        
+                    if ((local.drumSequencer.swinging >> speed) & 1)
+                        playDrumSequencerSwings(1 << speed);
+                    // we keep every speed's position moving, even with no tracks, so a track can join it later
+                    local.drumSequencer.speedPlayPosition[speed] = incrementAndWrap(local.drumSequencer.speedPlayPosition[speed], trackLen);
+                    if (local.drumSequencer.playbackSpeedTracks[speed] != 0 && 
+                        (DRUM_SEQUENCER_STRAIGHT_SPEED(speed) || !swingDrumSequencerStep(speed, local.drumSequencer.speedPlayPosition[speed])))
+                        tracks |= getDrumSequencerSpeedTracks(speed);
                     }
                 }
-                                                            
-            if (getNote(local.drumSequencer.currentGroup, track, local.drumSequencer.currentPlayPosition) && 
-                local.drumSequencer.shouldPlay[track] && !drumSequencerShouldMuteTrack(track))
-                {
-                sendTrackNote(track);         
-                }
             }
+        
+        playDrumSequencerTracks(tracks);
         }
 
     // click track
@@ -2552,8 +2843,8 @@ void playDrumSequencer()
 
 
 
-/// Stops the drum sequencer and resets it to its start position.
-void stopDrumSequencer()
+/// Puts the drum sequencer back at its start position, without changing whether it's playing.
+static void rewindDrumSequencer()
     {
     if (local.drumSequencer.performanceMode)
         {
@@ -2566,10 +2857,156 @@ void stopDrumSequencer()
         
     local.drumSequencer.currentPlayPosition = getGroupLength(local.drumSequencer.currentGroup) - 1;
     resetDrumSequencerSequenceCountdown();          // this will call resetDrumSequencerTransitionCountdown();
+    resetDrumSequencerClocks();
+    }
+
+/// Stops the drum sequencer and resets it to its start position.
+void stopDrumSequencer()
+    {
+    rewindDrumSequencer();
     local.drumSequencer.playState = PLAY_STATE_STOPPED;
     sendAllSoundsOff();
     }
 
+
+/// Moves the drum sequencer to where it'd be had it played POSITION pulses from its start position.
+/// In performance mode we walk forward through the transitions, adding up how long each one
+/// plays, until we find the one holding the position; then the sequence repeats, transition
+/// countdown, pattern countup, and play position all fall out by division.  The walk is at most
+/// DRUM_SEQUENCER_NUM_TRANSITIONS long however far into the song we are.
+void seekDrumSequencer(uint32_t position)
+    {
+    if (local.drumSequencer.playState == PLAY_STATE_STOPPED)
+        return;
+                
+    rewindDrumSequencer();
+    if (local.drumSequencer.playState == PLAY_STATE_WAITING)
+        local.drumSequencer.playState = PLAY_STATE_PLAYING;
+        
+    // at 0 we're where Start would put us
+    if (position == 0)
+        return;
+        
+    uint32_t offset = position - 1;                 // the last pulse played, from the start of the current pass through the sequence
+        
+    if (local.drumSequencer.performanceMode)
+        {
+        uint32_t start = 0;                         // where transition t starts
+        uint8_t t = 0;
+        uint8_t found = false;
+        while(true)
+            {
+            if (t >= DRUM_SEQUENCER_NUM_TRANSITIONS ||
+                (local.drumSequencer.transitionGroup[t] == DRUM_SEQUENCER_TRANSITION_GROUP_OTHER &&
+                local.drumSequencer.transitionRepeat[t] == DRUM_SEQUENCER_TRANSITION_OTHER_END))
+                {
+                // We've reached the end, so START is the length of the sequence, and we figure
+                // how many times it's been repeated.  See goNextTransition().
+                if (t == 0) 
+                    break;                              // END as the first transition, handled below
+                                
+                uint32_t repeats = offset / start;
+                if (local.drumSequencer.sequenceCountdown != 255)
+                    {
+                    if (repeats > local.drumSequencer.sequenceCountdown)
+                        {
+                        if (local.drumSequencer.nextSequence == DRUM_SEQUENCER_NEXT_SEQUENCE_END)  // STOP
+                            {
+                            stopDrumSequencer();
+                            return;
+                            }
+                        // We can't follow a chain into the next sequence without loading it, so 
+                        // we keep looping this one
+                        repeats = repeats % (local.drumSequencer.sequenceCountdown + 1);
+                        }
+                    local.drumSequencer.sequenceCountdown -= (uint8_t) repeats;
+                    }
+                offset = offset % start;
+                start = 0;
+                t = 0;
+                continue;
+                }
+                                
+            // Random groups can't be predicted, so we stop here too
+            if (local.drumSequencer.transitionGroup[t] == DRUM_SEQUENCER_TRANSITION_GROUP_OTHER)
+                break;
+                                
+            local.drumSequencer.currentTransition = t;
+            resetDrumSequencerTransitionCountdown();
+            uint8_t group = local.drumSequencer.transitionGroup[t];
+            uint16_t steps = getGroupLength(group);
+            if (local.drumSequencer.transitionCountdown != 255)
+                steps = steps * (local.drumSequencer.transitionCountdown + 1);
+            uint32_t length = getDrumSequencerGroupPulses(group, steps);
+                                
+            if (offset < start + length ||
+                (local.drumSequencer.transitionCountdown == 255 &&
+                local.drumSequencer.transitionRepeat[t] != DRUM_SEQUENCER_TRANSITION_REPEAT_BIG_LOOP))              // loops forever
+                {
+                // Found it
+                drumSequencerUpdateGroup(group);            // this resets the transition countdown again
+                local.drumSequencer.goNextTransition = false;
+                offset -= start;
+                found = true;
+                break;
+                }
+            else if (local.drumSequencer.transitionCountdown == 255)
+                {
+                // A big loop plays once and goes back to the transition after the last loop.
+                // There can't be one before this (we'd have stopped there), so that's transition 0.
+                offset = offset % (start + length);
+                start = 0;
+                t = 0;
+                continue;
+                }
+                                
+            start += length;
+            t++;
+            }
+                        
+        if (!found)
+            {
+            // We can't compute this transition.  Instead we have goNextTransition() jump
+            // to its start on the very next pulse, by clocking speed 0 until it does.
+            local.drumSequencer.goNextTransition = t + 2;
+            local.drumSequencer.clocksOnNotePulse = false;
+            return;
+            }
+        }
+
+    // OFFSET now counts from the last time the clocks were reset.  Each speed has stepped 
+    // ceil((offset + 1) * increment / period) times since then, which is what its accumulator 
+    // would have worked out.  See playDrumSequencer().
+    if (local.drumSequencer.playbackGroup != local.drumSequencer.currentGroup)
+        buildDrumSequencerPlaybackCache();
+    uint8_t trackLen = getGroupLength(local.drumSequencer.currentGroup);
+    uint32_t passes = 0;
+    // setSongPosition() has already put the note pulse where it belongs.  The speeds which are exactly 
+    // the note speed step on it only if the clocks were reset on a note pulse.
+    local.drumSequencer.clocksOnNotePulse = ((position - 1 - offset) % notePulseRate == 0);
+    for(uint8_t speed = 0; speed < DRUM_SEQUENCER_NUM_SPEEDS; speed++)
+        {
+        uint8_t increment = local.drumSequencer.playbackSpeedIncrement[speed];
+        uint16_t period = getDrumSequencerSpeedPeriod(speed);
+        uint32_t elapsed = (offset + 1) * increment;
+        uint32_t steps = (elapsed + period - 1) / period;
+        uint8_t pos = (uint8_t)((steps - 1) % trackLen);
+        local.drumSequencer.speedAccumulator[speed] = (DRUM_SEQUENCER_STRAIGHT_SPEED(speed) ? 0 : (uint16_t)(steps * period - elapsed));
+        local.drumSequencer.speedPlayPosition[speed] = pos;
+        if (speed == 0)
+            {
+            passes = (steps - 1) / trackLen;
+            local.drumSequencer.currentPlayPosition = pos;
+            }
+        }
+    local.drumSequencer.clocksReset = false;
+        
+    if (local.drumSequencer.performanceMode && local.drumSequencer.transitionCountdown != 255)
+        local.drumSequencer.transitionCountdown -= (uint8_t) passes;
+    local.drumSequencer.patternCountup = (uint8_t) passes;
+    chooseDrumSequencerPatterns();
+    }
+
 void goNextGroup()
     {
     uint8_t g = local.drumSequencer.currentGroup + 1;
@@ -2672,18 +3109,8 @@ void stateDrumSequencerPlay()
                 {
                 local.drumSequencer.playState = PLAY_STATE_WAITING;
 
-                if (local.drumSequencer.performanceMode)
-                    {
-                    local.drumSequencer.currentGroup = 0;
-                    // for performance mode
-                    local.drumSequencer.currentTransition = DRUM_SEQUENCER_TRANSITION_START;                        // gotta make sure this is drawn right
-                    local.drumSequencer.goNextTransition = true;                       // should be enough to trigger going to the next transition?
-                    local.drumSequencer.goNextSequence = false;
-                    }
-                                        
                 // Though this is done in stopDrumSequencer we have to do it again because we may be in a different group now. 
-                local.drumSequencer.currentPlayPosition = getGroupLength(local.drumSequencer.currentGroup) - 1;
-                resetDrumSequencerSequenceCountdown();          // this will call resetDrumSequencerTransitionCountdown();
+                rewindDrumSequencer();
 
                 if (1) //if (options.drumSequencerSendClock)
                     {
@@ -2827,8 +3254,8 @@ void stateDrumSequencerPlay()
             int16_t newPos = drumSequencerGetNewCursorXPos(trackLen);
             if (lockoutPots ||      // using an external NRPN device, which is likely accurate
                 local.drumSequencer.currentRightPot == DRUM_SEQUENCER_CURRENT_RIGHT_POT_UNDEFINED ||   // nobody's been entering data
-                local.drumSequencer.currentRightPot >= newPos && local.drumSequencer.currentRightPot - newPos >= 2 ||
-                local.drumSequencer.currentRightPot < newPos && newPos - local.drumSequencer.currentRightPot >= 2)
+                (local.drumSequencer.currentRightPot >= newPos && local.drumSequencer.currentRightPot - newPos >= 2) ||
+                (local.drumSequencer.currentRightPot < newPos && newPos - local.drumSequencer.currentRightPot >= 2))
                 {
                 local.drumSequencer.currentEditPosition = newPos;
                 local.drumSequencer.currentRightPot = DRUM_SEQUENCER_CURRENT_RIGHT_POT_UNDEFINED;
@@ -3328,7 +3755,7 @@ void stateDrumSequencerPlay()
                     local.drumSequencer.drumRegion = DRUM_OPERATION_TOGGLE;
                                         
                 // Try to add some slop so the user can come in at the right time
-                uint8_t pos = local.drumSequencer.currentPlayPosition + (notePulseCountdown <= (notePulseRate >> 1) ? 1 : 0);
+                uint8_t pos = local.drumSequencer.currentPlayPosition + (drumSequencerNearNextStep() ? 1 : 0);
                 if (pos >= len) pos = 0;
 
                 //// We're in PLAY POSITION MODE or RIGHT mode
@@ -461,10 +461,6 @@ Menus
 #define P0111 (14)			// DRUM_SEQUENCER_PATTERN_RANDOM_3_4
 #define P1111 (15)			// DRUM_SEQUENCER_PATTERN_ALL
 
-#define NUM_POTS (2)
-#define LEFT_POT (0)
-#define RIGHT_POT (1)
-
 #define MIDDLE_C 								(60)
 
 #define DRUM_SEQUENCER_NOT_MUTED (0)
@@ -481,6 +477,7 @@ Menus
 
 #define MAX_DRUM_SEQUENCER_TRACKS 								(20)
 #define MAX_DRUM_SEQUENCER_GROUPS 								(15)
+#define MAX_DRUM_SEQUENCER_NOTES 								(64)
 #define DRUM_SEQUENCER_DEFAULT_FORMAT 							(8)			// 16 note 11 group 12 track
 #define DRUM_SEQUENCER_NUM_FORMATS 							(16)
 #define DRUM_SEQUENCER_NUM_TRANSITIONS 						(20)
@@ -507,6 +504,37 @@ Menus
 												// Values 1...16: performance notes are routed to this channel number
 
 #define DRUM_SEQUENCER_NO_MARK					(255)
+#define DRUM_SEQUENCER_NO_PLAYBACK_GROUP		(255)
+
+
+// SPEEDS
+//
+// Each group plays at a speed relative to the note speed (its stored note speed, 0...3), and each
+// track plays at a speed relative to its group.  Both are indexes into the same table of ratios:
+//
+//		0 = 1,  1 = 2,  2 = 4,  3 = 1/2,  4 = 3/2 (triplets),  5 = 3/4,  6 = 5/8,  7 = 2/3
+//
+// So a track's steps come every (note pulse rate * group denominator * track denominator) /
+// (group numerator * track numerator) pulses, which needn't be a whole number.  Each speed has its
+// own clock, a fractional pulse accumulator, and its own play position, so the tracks at different
+// speeds drift against one another (polymeter) until the group changes or a new transition starts,
+// which restarts all the clocks.
+// Speed 0 is the group's own speed: its play position is currentPlayPosition, which drives the
+// group length, transitions, and patterns.  Tracks are stepped a whole speed at a time using
+// 32-bit masks, so the cost per pulse depends on the number of speeds, not tracks.
+//
+// A clock whose speed works out to exactly the note speed steps on the NOTE PULSE instead,
+// so it swings, as long as the clocks were last restarted on a note pulse.  The others step on
+// PULSES, and we never move the note pulse to suit them.  When the note speed swings, those
+// whose speed is the note speed times a power of two (2, 4, 1/2, ...) swing on their own: every
+// other step is held back by the swing's fraction of a step, as the note pulse would be.  So a
+// group at 2x, 4x, or 1/2x swings as it did when the group's speed changed the note pulse rate.
+//
+// Track speeds are not saved: there's no room for them in the slot (the largest format fills
+// DRUM_SEQUENCER_DATA_LENGTH exactly).  They reset to 1 when a sequence is loaded.
+
+#define DRUM_SEQUENCER_NUM_SPEEDS				(8)
+#define DRUM_SEQUENCER_TRACK_SPEED_DEFAULT		(0)
 
 struct _drumSequencerLocal
     {
@@ -526,7 +554,7 @@ struct _drumSequencerLocal
 	uint8_t muted[MAX_DRUM_SEQUENCER_TRACKS];						// Whether a given track is muted, and in which mute state.
 	uint8_t solo;													// Whether we're in solo mode (the given track is being soloed)
     uint8_t playState;                                              // Is the sequencer playing, paused, or stopped?
-    uint8_t shouldPlay[MAX_DRUM_SEQUENCER_TRACKS];					// Should we play the given track [due to pattern]?  Determined when we start note 0 of the sequence, based on the current pattern.  Used throughout the sequence afterwards to determine if we should play or mute the track that time around.
+    uint32_t shouldPlay;											// Bit t: should we play track t [due to pattern]?  Determined when we start note 0 of the sequence, based on the current pattern.  Used throughout the sequence afterwards to determine if we should play or mute the track that time around.
     uint8_t performanceMode;										// Are we in performance mode?
     uint8_t transitionCountdown;									// Current countdown for repeats in the current transition
     uint8_t sequenceCountdown;										// Current countdown for repeats in whole sequence
@@ -534,7 +562,7 @@ struct _drumSequencerLocal
     uint8_t backup;   												// A temp variable used to backup stuff in TopLevel menus
     uint8_t transitionGroupBackup;									// A second temp variable used to backup stuff in TopLevel menus
     uint8_t transitionOperationBackup;								// A third temp variable used to backup stuff in TopLevel menus
-    uint16_t pots[NUM_POTS];										// Previous pot positions.  Used in performance mode: we must exceed these positions by 32 to cause the sequencer to switch to using them as tempo etc.
+    uint16_t pots[2];												// Previous pot positions (left and right).  Used in performance mode: we must exceed these positions by 32 to cause the sequencer to switch to using them as tempo etc.
     int16_t currentRightPot;  										// The previous on-screen position of the right pot.  Used to create a slop that the user must overcome to change positions (so as to prevent jumps due to noise).
     																// I think we only did it for the right pot because of lots of note positions, but with 32 tracks, maybe the left pot should do it too...
     uint8_t returnState;                                            // Used by stateDrumSequencerTransitions and stateDrumSequencerRepeat to determine where to go when cancelled
@@ -545,7 +573,27 @@ struct _drumSequencerLocal
     uint8_t markGroup;												// Mark position for the group
     int8_t markPosition;											// Mark position for the step
     uint8_t markTransition;											// Mark for the transitions
-    uint8_t invalidNoteSpeed;										// Note speed is not legitimate
+    uint8_t invalidNoteSpeed;										// Some speed needs more than one step per pulse, so it's been slowed down
+	uint8_t trackSpeed[MAX_DRUM_SEQUENCER_TRACKS];					// Each track's speed relative to its group (see SPEEDS above)
+
+	// The speed clocks.  See resetDrumSequencerClocks()
+	uint16_t speedAccumulator[DRUM_SEQUENCER_NUM_SPEEDS];			// Each speed steps on a pulse when this is below its increment, and then adds its period
+	uint8_t speedPlayPosition[DRUM_SEQUENCER_NUM_SPEEDS];			// Each speed's play position.  Speed 0 uses currentPlayPosition instead.
+	uint8_t clocksReset;											// Have the clocks been reset since speed 0 last stepped?
+	uint8_t clocksOnNotePulse;										// Were the clocks last reset on a note pulse, so the speeds which are exactly the note speed can step on it?
+	uint8_t swinging;												// Bit s: has speed s held back its last step to swing it?
+	uint32_t speedSwingTime[DRUM_SEQUENCER_NUM_SPEEDS];				// When each speed's held-back step is due
+
+	// The playback cache.  See buildDrumSequencerPlaybackCache()
+	uint32_t playbackSteps[MAX_DRUM_SEQUENCER_NOTES];				// Bit t of step s: does track t have a note at step s of playbackGroup?
+	uint8_t playbackChannel[MAX_DRUM_SEQUENCER_TRACKS];				// Each track's MIDI channel (0 = Off, 1...16, 17 = Default)
+	uint8_t playbackPitch[MAX_DRUM_SEQUENCER_TRACKS];				// Each track's note pitch
+	uint8_t playbackVelocity[MAX_DRUM_SEQUENCER_TRACKS];			// Each track's MIDI velocity
+	uint32_t playbackSpeedTracks[DRUM_SEQUENCER_NUM_SPEEDS];		// Bit t of speed s: does track t play at speed s?
+	uint8_t playbackSpeedIncrement[DRUM_SEQUENCER_NUM_SPEEDS];		// Numerator of each speed times the group's speed
+	uint8_t playbackSpeedPeriod[DRUM_SEQUENCER_NUM_SPEEDS];			// Denominator of each speed times the group's speed
+	uint8_t playbackSwingSpeeds;									// Bit s: is speed s the note speed times a power of two, so it can swing?
+	uint8_t playbackGroup;											// The group in playbackSteps, or DRUM_SEQUENCER_NO_PLAYBACK_GROUP
 
     };
 
@@ -561,9 +609,9 @@ struct _drumSequencer
     };
 
 
-// Turns off all notes as appropriate (rests and ties aren't cleared),
-// unless clearAbsolutely is true, in which case absolutely everything gets cleared regardless
-void clearNotesOnTracks(uint8_t clearEvenIfNoteNotFinished);
+// Turns off all notes as appropriate (notes about to be continued by ties aren't cleared).
+// Notes shorter than a step are turned off by the scheduler instead (see Scheduler.h).
+void clearNotesOnTracks();
 
 // Draws the sequence with the given track length, number of tracks, and skip size
 void drawDrumSequencer(uint8_t tracklen, uint8_t numTracks, uint8_t skip);
@@ -578,11 +626,17 @@ void stateDrumSequencerPlay();
 // Plays the current sequence
 void playDrumSequencer();
 
+// Rebuilds the playback cache from the current group
+void buildDrumSequencerPlaybackCache();
+
 // Gives other options
 void stateDrumSequencerMenu();
 
 void stopDrumSequencer();
 
+// Moves the sequencer to where it'd be after POSITION pulses from its start.  See setSongPosition().
+void seekDrumSequencer(uint32_t position);
+
 void resetDrumSequencer();
 
 
@@ -602,6 +656,7 @@ void stateDrumSequencerPitch();
 void stateDrumSequencerGroup();
 void stateDrumSequencerGroupLength();
 void stateDrumSequencerGroupSpeed();
+void stateDrumSequencerTrackSpeed();
 void stateDrumSequencerTransitionEdit();
 void stateDrumSequencerTransitionEditGroup();
 void stateDrumSequencerTransitionEditRepeat();
@@ -98,7 +98,7 @@ void setup()
 	// a moderate amount of entropy but is tiny.  analogRead(A0) is actually
 	// pretty crummy.  There are lots of high-entropy libraries but they're 
 	// big code.  Here's my simple approach
-	randomSeed(analogRead(A0) ^ (analogRead(A2) << 8) ^ (analogRead(A4) << 16) ^ (analogRead(A5) << 24));
+	seedRandom(analogRead(A0) ^ (analogRead(A2) << 8) ^ ((uint32_t)analogRead(A4) << 16) ^ ((uint32_t)analogRead(A5) << 24));
 
     // prepare the pots
     setupPots();
@@ -109,6 +109,9 @@ void setup()
 	
     // load the options from flash
     loadOptions();
+    
+    // find out where the slots are
+    setupSlots();
 
     // Show the welcome message
     write8x5Glyph(led2, GLYPH_8x5_GIZMO_PT1);
@@ -143,6 +146,9 @@ void setup()
 #endif INCLUDE_SYSEX
     
     MIDI.begin(MIDI_CHANNEL_OMNI);
+#ifdef INCLUDE_TIMED_CLOCK
+    setupTimedClock();
+#endif INCLUDE_TIMED_CLOCK
 #ifdef TOPLEVEL_BYPASS
     MIDI.turnThruOn();
 #else
@@ -154,6 +160,15 @@ void setup()
     // start clock
     //startClock(true);
     initializeClock();
+    resetScheduledNoteOffs();
+#ifdef INCLUDE_STEP_SEQUENCER
+    stepSequencerNoteOffs = reserveNoteOffs(MAX_STEP_SEQUENCER_TRACKS);
+#endif INCLUDE_STEP_SEQUENCER
+    clickNoteOff = reserveNoteOffs(1);
+    
+#ifdef INCLUDE_PROFILER
+    resetProfile();
+#endif INCLUDE_PROFILER
      
     // reset ticks and pulses
     uint32_t m = micros();
@@ -13,23 +13,18 @@
 #include "Division.h"
 
 #if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_8x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
-#include <Wire.h>
+#include <avr/interrupt.h>
+#include <util/twi.h>
 
-//// MODIFING THE I2C BUFFERS
-//// Wire uses 217 bytes!!!
-//// The I2C buffers are very large.  We need them to be 16 in size at most (for the 
-//// 16x8 backpack) and 8 in size (for the 8x8 backpack).
-
-// We might need some memory from them.  To do this we can reduce their
-// size by changing the following defines (in the include files):
-
-// BUFFER_LENGTH        In Wire.h
-// TWI_BUFFER_LENGTH    In twi.h
-
-// Changing this from 32 to 16 would save us 80 bytes!
+//// WE DON'T USE WIRE
+//// Wire uses 217 bytes!!!  And even with endTransmissionNonblocking(), we had to
+//// fill its buffer ourselves, and everything else it did was blocking.  So instead
+//// we drive the TWI hardware directly, from its interrupt.  See "THE I2C ENGINE" below.
 
 #define I2C_ADDRESS     ((uint8_t) 0x70)
 #define LED_BRIGHTNESS_I2C  ((uint8_t) 0xE0)
+#define LED_OSCILLATOR_ON_I2C   ((uint8_t) 0x21)
+#define LED_DISPLAY_ON_I2C      ((uint8_t) 0x81)                // display on, blinking off
 
 #endif
 
@@ -1144,6 +1139,89 @@ void sendMatrix(unsigned char* matrix, unsigned char* matrix2)
 GLOBAL uint8_t rotation = DIR_NONE;
 
 
+/// How each screen is mounted: the direction we must rotate our matrices to
+/// display them, and whether the two 8x8 halves of the 16x8 screens are swapped.
+/// ROTATE_WHOLE_SCREEN turns everything a further 180 degrees.  Directions are
+/// in quarter turns clockwise, so they add modulo 4.
+#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK)
+#define LED_DEVICE_DIR DIR_CLOCKWISE_90
+#define LED_DEVICE_SWAPPED false
+#elif defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
+#define LED_DEVICE_DIR DIR_180
+#define LED_DEVICE_SWAPPED true
+#else
+#define LED_DEVICE_DIR DIR_NONE
+#define LED_DEVICE_SWAPPED false
+#endif
+
+#ifdef ROTATE_WHOLE_SCREEN
+#define LED_DEVICE_EXTRA_DIR DIR_180
+#else
+#define LED_DEVICE_EXTRA_DIR DIR_NONE
+#endif ROTATE_WHOLE_SCREEN
+
+
+// Rotates the matrix IN in the given direction, writing the result to every
+// STRIDE'th byte of OUT, so we can rotate straight into the display RAM, where 
+// the two matrices of the 16x8 screens are interleaved.  IN and OUT may not overlap.
+//
+// There are lots of clever rotation code snippets out there, many derived
+// from Hacker's Delight, but they're largely all 16- or 32-bit, and their
+// tricks don't scale down to 8-bit.  But note that on the AVR a shift by a
+// variable amount is a loop, so rather than picking out each bit with
+// (in[j] >> shift), we shift each column out a bit at a time into the rows.
+static void rotateInto(const unsigned char* in, unsigned char* out, uint8_t stride, uint8_t dir)
+    {
+    unsigned char t[LED_WIDTH] = { 0 };
+    if (dir == DIR_CLOCKWISE_90)
+        {
+        // bit j of t[i] is bit (7 - i) of in[j]
+        for(int8_t j = LED_WIDTH - 1; j >= 0; j--)
+            {
+            uint8_t c = in[j];
+            for(uint8_t i = 0; i < LED_WIDTH; i++)
+                {
+                t[i] = (t[i] << 1) | (c >> 7);
+                c = c << 1;
+                }
+            }
+        }
+    else if (dir == DIR_COUNTERCLOCKWISE_90)
+        {     
+        // bit (7 - j) of t[i] is bit i of in[j]
+        for(uint8_t j = 0; j < LED_WIDTH; j++)
+            {
+            uint8_t c = in[j];
+            for(uint8_t i = 0; i < LED_WIDTH; i++)
+                {
+                t[i] = (t[i] << 1) | (c & 0x01);
+                c = c >> 1;
+                }
+            }
+        }
+    else if (dir == DIR_180)
+        {
+        // t[i] is in[7 - i] reversed
+        for(uint8_t i = 0; i < LED_WIDTH; i++)
+            {
+            uint8_t c = in[LED_WIDTH - 1 - i];
+            for(uint8_t j = 0; j < 8; j++)
+                {
+                t[i] = (t[i] << 1) | (c & 0x01);
+                c = c >> 1;
+                }
+            }
+        }
+    else
+        {
+        memcpy(t, in, LED_WIDTH);
+        }
+
+    for(uint8_t i = 0; i < LED_WIDTH; i++)
+        out[i * stride] = t[i];
+    }
+
+
 // Sets the rotation of the screen.  For a single 8x8 matrix, all four rotations
 // make sense.  For a 16x8 matrix, only DIR_180 and DIR_NONE make sense; other
 // rotations will be ignored.
@@ -1154,97 +1232,223 @@ void setRotation(uint8_t dir)
 
 
 
-// Sends an the matrix to the LED  [that is, matrix must be 8 bytes]
-// matrix2 can be NULL only if we're using the 8x8 screens
-#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_8x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
-void sendMatrix(unsigned char* matrix, unsigned char* matrix2)
-    {
-    // rotate as necessary
-#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
-    uint8_t mat[8];
-    uint8_t mat2[8];
+#ifdef INCLUDE_PROFILER
+GLOBAL uint32_t ledBytesSaved = 0;
+#endif INCLUDE_PROFILER
 
-#ifdef ROTATE_WHOLE_SCREEN
-	// swap the two matrices. We'll rotate each one 180 later. This results in a full rotation of the combined screen
-	unsigned char* temp = matrix;
-	matrix = matrix2;
-	matrix2 = temp;
-#endif ROTATE_WHOLE_SCREEN
+#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_8x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
 
-    // the display of the matrices is rotated 90 degrees, so we need to tweak here
-    if (rotation >= DIR_180)  // rotate to 180 if we're DIR_180 or DIR_COUNTERCLOCKWISE_90, nothing else
+//// THE I2C ENGINE
+////
+//// The HT16K33 is written to by the TWI interrupt, one byte per interrupt, so sendMatrix()
+//// and setScreenBrightness() just hand over their data and return.  There are two buffers.
+//// ledFrame is the latest frame we've been given, as it should appear in the HT16K33's
+//// display RAM, and ledFrameFirst...ledFrameLast is the range of it which hasn't been
+//// sent yet.  twiBuffer holds the transaction which is in flight.  When a transaction
+//// finishes, the interrupt starts the next one: first any queued commands (brightness
+//// and so on), then the unsent range of ledFrame.  If a new frame arrives while an
+//// older one is still waiting, the older one is simply overwritten: the latest wins.
+////
+//// If the HT16K33 doesn't acknowledge, we stop and mark the whole frame as unsent,
+//// to be tried again at the next sendMatrix().
+
+/// The HT16K33's display RAM is 16 bytes, two per row
+#define LED_FRAME_LENGTH 16
+#define LED_NO_FRAME 255
+#define LED_MAX_COMMANDS 3
+
+/// The latest frame, as it should appear in the HT16K33's display RAM
+GLOBAL static uint8_t ledFrame[LED_FRAME_LENGTH];
+/// The range of ledFrame not yet sent, or LED_NO_FRAME if it's all been sent
+GLOBAL static volatile uint8_t ledFrameFirst = LED_NO_FRAME;
+GLOBAL static volatile uint8_t ledFrameLast;
+
+/// Single-byte commands waiting to be sent, oldest first
+GLOBAL static volatile uint8_t twiCommands[LED_MAX_COMMANDS];
+GLOBAL static volatile uint8_t twiNumCommands = 0;
+
+/// The transaction in flight: the register address followed by the data
+GLOBAL static volatile uint8_t twiBuffer[LED_FRAME_LENGTH + 1];
+GLOBAL static volatile uint8_t twiLength;
+GLOBAL static volatile uint8_t twiPosition;
+GLOBAL static volatile uint8_t twiBusy = false;
+
+#define TWI_CONTINUE (_BV(TWINT) | _BV(TWEN) | _BV(TWIE))
+
+// Loads the next transaction into twiBuffer.  Returns false if there's
+// nothing to send.  Must be called with interrupts off.
+static uint8_t twiLoadNext()
+    {
+    if (twiNumCommands > 0)
         {
-        memcpy(mat, matrix, 8);
-        memcpy(mat2, matrix2, 8);
-#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK)
-        rotateMatrix(mat, DIR_COUNTERCLOCKWISE_90);
-        rotateMatrix(mat2, DIR_COUNTERCLOCKWISE_90);
-#else // SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK
-        rotateMatrix(mat, DIR_NONE);
-        rotateMatrix(mat2, DIR_NONE);
-#endif
-        matrix2 = mat;  // note we're flipping them
-        matrix = mat2;
+        twiBuffer[0] = twiCommands[0];
+        twiLength = 1;
+        twiNumCommands--;
+        for(uint8_t i = 0; i < twiNumCommands; i++)
+            twiCommands[i] = twiCommands[i + 1];
         }
-    else    // other rotations are considered DIR_NONE
+    else if (ledFrameFirst != LED_NO_FRAME)
         {
-        memcpy(mat, matrix, 8);
-        memcpy(mat2, matrix2, 8);
-#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK)
-        rotateMatrix(mat, DIR_CLOCKWISE_90);
-        rotateMatrix(mat2, DIR_CLOCKWISE_90);
-#else // SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK
-        rotateMatrix(mat, DIR_180);
-        rotateMatrix(mat2, DIR_180);
-#endif
-
-#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK)    // note we're NOT flipping them
-        matrix = mat;  
-        matrix2 = mat2;
-#else                                                                   // here we ARE flipping them
-        matrix2 = mat;  
-        matrix = mat2;
-#endif
+        uint8_t first = ledFrameFirst;
+        uint8_t len = ledFrameLast - first + 1;
+        twiBuffer[0] = first;
+        for(uint8_t i = 0; i < len; i++)
+            twiBuffer[i + 1] = ledFrame[first + i];
+        twiLength = len + 1;
+        ledFrameFirst = LED_NO_FRAME;
         }
-#else
-    uint8_t mat[8];
-    if (rotation != DIR_NONE)
+    else return false;
+
+    twiPosition = 0;
+    return true;
+    }
+
+// Starts a transaction if there's something to send and the bus is idle.
+// Must be called with interrupts off.
+static void twiStart()
+    {
+    if (twiBusy || !twiLoadNext())
+        return;
+    twiBusy = true;
+    // the previous STOP may not have gone out yet
+    while(TWCR & _BV(TWSTO));
+    TWCR = TWI_CONTINUE | _BV(TWSTA);
+    }
+
+// Queues a single-byte command to the HT16K33 and starts sending it if we can.
+// A command replaces any queued command of the same kind (the same high nybble),
+// so for example only the most recent brightness is sent.
+static void twiCommand(uint8_t command)
+    {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t i = 0;
+    for( ; i < twiNumCommands; i++)
+        if ((twiCommands[i] & 0xF0) == (command & 0xF0))
+            break;
+    if (i < LED_MAX_COMMANDS)
         {
-        memcpy(mat, matrix, 8);
-        rotateMatrix(mat, rotation);
-        matrix = mat;
-        }       
-#endif
+        twiCommands[i] = command;
+        if (i == twiNumCommands)
+            twiNumCommands++;
+        }
+    twiStart();
+    SREG = sreg;
+    }
 
-#ifdef ROTATE_WHOLE_SCREEN
-	// rotate the two matrices. We swapped them earlier. This results in a full rotation of the combined screen
-	rotateMatrix(matrix, DIR_180);
-	rotateMatrix(matrix2, DIR_180);
-#endif ROTATE_WHOLE_SCREEN
+ISR(TWI_vect)
+    {
+    switch(TW_STATUS)
+        {
+        case TW_START:
+        case TW_REP_START:
+            {
+            TWDR = (I2C_ADDRESS << 1) | TW_WRITE;
+            TWCR = TWI_CONTINUE;
+            }
+        break;
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            {
+            if (twiPosition < twiLength)
+                {
+                TWDR = twiBuffer[twiPosition++];
+                TWCR = TWI_CONTINUE;
+                }
+            else if (twiLoadNext())
+                {
+                // STOP followed by START
+                TWCR = TWI_CONTINUE | _BV(TWSTO) | _BV(TWSTA);
+                }
+            else
+                {
+                TWCR = TWI_CONTINUE | _BV(TWSTO);
+                twiBusy = false;
+                }
+            }
+        break;
+        default:                // NACK, lost arbitration, or bus error
+            {
+            ledFrameFirst = 0;
+            ledFrameLast = LED_FRAME_LENGTH - 1;
+            TWCR = TWI_CONTINUE | _BV(TWSTO);
+            twiBusy = false;
+            }
+        break;
+        }
+    }
 
+#endif
 
-    Wire.beginTransmission(I2C_ADDRESS);
-    Wire.write(0);
 
+// Sends an the matrix to the LED  [that is, matrix must be 8 bytes]
+// matrix2 can be NULL only if we're using the 8x8 screens
+// Only the part of the frame which differs from the last one sent is written
+// to the screen, and nothing at all is written if the frame hasn't changed.
+#if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_8x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
+void sendMatrix(unsigned char* matrix, unsigned char* matrix2)
+    {
+    // Rotate straight into the frame as it will appear in the HT16K33's display RAM
+    uint8_t frame[LED_FRAME_LENGTH];
 #if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
-    for (uint8_t i=0; i<8; i++) 
+    // only DIR_180 makes sense for the 16x8 screens: DIR_COUNTERCLOCKWISE_90 is considered DIR_180, and DIR_CLOCKWISE_90 is considered DIR_NONE
+    uint8_t extra = (LED_DEVICE_EXTRA_DIR + (rotation >= DIR_180 ? DIR_180 : DIR_NONE)) & 3;
+    
+    // Turning the whole screen 180 degrees also swaps the two matrices
+    if ((extra == DIR_180) != LED_DEVICE_SWAPPED)
         {
-        Wire.write(matrix2[i]);    
-        Wire.write(matrix[i]);    
+        unsigned char* temp = matrix;
+        matrix = matrix2;
+        matrix2 = temp;
         }
+    uint8_t dir = (LED_DEVICE_DIR + extra) & 3;
+    rotateInto(matrix2, frame, 2, dir);
+    rotateInto(matrix, frame + 1, 2, dir);
 #else
+    // A misfeature in the 8x8 display is said to require that we do a full 
+    // left shift of one bit, but we've never done so
+    rotateInto(matrix, frame + 1, 2, (LED_DEVICE_EXTRA_DIR + rotation) & 3);
     for (uint8_t i=0; i<8; i++) 
-        {
-        // A misfeature in the 8x8 display requires that we do a full left shift
-        // of one bit
-        uint8_t c = matrix[i];
-        c = (c << 7) | (c >> 1);
-
-        Wire.write(0);   
-        Wire.write(matrix[i]); 
-        }        
+        frame[i * 2] = 0;   
 #endif  // defined(SCREEN_TYPE_ADAFRUIT_8x8_BACKPACK)
-    Wire.endTransmissionNonblocking();  
+
+    // Find the range of display RAM that has changed since the last frame we were given
+    uint8_t first = 0;
+    uint8_t last = LED_FRAME_LENGTH - 1;
+    while(first < LED_FRAME_LENGTH && frame[first] == ledFrame[first]) first++;
+    if (first < LED_FRAME_LENGTH)
+        while(frame[last] == ledFrame[last]) last--;
+
+    uint8_t sreg = SREG;
+    cli();
+#ifdef INCLUDE_PROFILER
+    // what sending the unsent range would cost us before and after this frame,
+    // counting the I2C address and the register address
+    uint8_t before = (ledFrameFirst == LED_NO_FRAME ? 0 : ledFrameLast - ledFrameFirst + 3);
+#endif INCLUDE_PROFILER
+    if (first < LED_FRAME_LENGTH)
+        {
+        // The HT16K33 auto-increments its display RAM address, so we just
+        // add the changed range to whatever range hasn't gone out yet
+        memcpy(ledFrame + first, frame + first, last - first + 1);
+        if (ledFrameFirst == LED_NO_FRAME)
+            {
+            ledFrameFirst = first;
+            ledFrameLast = last;
+            }
+        else
+            {
+            if (first < ledFrameFirst) ledFrameFirst = first;
+            if (last > ledFrameLast) ledFrameLast = last;
+            }
+        }
+#ifdef INCLUDE_PROFILER
+    uint8_t after = (ledFrameFirst == LED_NO_FRAME ? 0 : ledFrameLast - ledFrameFirst + 3);
+    ledBytesSaved += LED_FRAME_LENGTH + 2 - (after - before);
+#endif INCLUDE_PROFILER
+    twiStart();
+    SREG = sreg;
+
     blinkToggle++;
     if (blinkToggle > blinkOff)
         blinkToggle = 0;
@@ -1260,18 +1464,23 @@ void sendMatrix(unsigned char* matrix, unsigned char* matrix2)
 void initLED()
     {
 #if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_8x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
-    Wire.begin();
-    // Make I2C go faster (by default it's 100Hz).  The screens can handle it.
-    Wire.setClock(400000L);
-    //TWBR = 12; // 400 khz
-
-    // It appears that all of the below is critical to get the screen up and running
-    Wire.beginTransmission(I2C_ADDRESS);
-    Wire.write(0x21);  // Turn on the oscillator
-    Wire.endTransmission();
-    Wire.beginTransmission(I2C_ADDRESS);
-    Wire.write(0x81);  // Turn on the screen and turn OFF blinking
-    Wire.endTransmission();
+    // internal pullups, as Wire does
+    digitalWrite(SDA, HIGH);
+    digitalWrite(SCL, HIGH);
+    // Run I2C at 400KHz (the default is 100KHz).  The screens can handle it.
+    TWSR = 0;           // prescaler 1
+    TWBR = ((F_CPU / 400000L) - 16) / 2;
+    TWCR = _BV(TWEN) | _BV(TWIE);
+
+    // It appears that all of the below is critical to get the screen up and running.
+    // We don't know what's in the display RAM, so the whole frame must be sent too.
+    twiCommand(LED_OSCILLATOR_ON_I2C);
+    twiCommand(LED_DISPLAY_ON_I2C);
+    uint8_t sreg = SREG;
+    cli();
+    ledFrameFirst = 0;
+    ledFrameLast = LED_FRAME_LENGTH - 1;
+    SREG = sreg;
         
     // Let's be dimmer
     setScreenBrightness(1);
@@ -1303,65 +1512,10 @@ void initLED()
 
 
 // Rotates a matrix in the given direction.
-// There are lots of clever rotation code snippets out there, many derived
-// from Hacker's Delight, but they're largely all 16- or 32-bit, and their
-// tricks don't scale down to 8-bit in any speed improvement (that I know 
-// of) over the brute-force approach below.
 void rotateMatrix(unsigned char* in, uint8_t dir)
     {
     unsigned char rotateTemp[LED_WIDTH];
-    if (dir == DIR_CLOCKWISE_90)
-        {
-        for(uint8_t i = 0; i < LED_WIDTH; i++)
-            {
-            uint8_t shift = (LED_WIDTH - 1 - i);
-            rotateTemp[i] =  
-                (((in[0] >> shift) & 0x01) << 0) |
-                (((in[1] >> shift) & 0x01) << 1) |
-                (((in[2] >> shift) & 0x01) << 2) |
-                (((in[3] >> shift) & 0x01) << 3) |
-                (((in[4] >> shift) & 0x01) << 4) |
-                (((in[5] >> shift) & 0x01) << 5) |
-                (((in[6] >> shift) & 0x01) << 6) |
-                (((in[7] >> shift) & 0x01) << 7); 
-            }
-        }
-    else if (dir == DIR_COUNTERCLOCKWISE_90)
-        {     
-        for(uint8_t i = 0; i < LED_WIDTH; i++)
-            rotateTemp[i] =  
-                (((in[0] >> i) & 0x01) << 7) |
-                (((in[1] >> i) & 0x01) << 6) |
-                (((in[2] >> i) & 0x01) << 5) |
-                (((in[3] >> i) & 0x01) << 4) |
-                (((in[4] >> i) & 0x01) << 3) |
-                (((in[5] >> i) & 0x01) << 2) |
-                (((in[6] >> i) & 0x01) << 1) |
-                (((in[7] >> i) & 0x01) << 0);
-        }
-    else if (dir == DIR_180)
-        {
-        for(uint8_t i = 0; i < LED_WIDTH; i++)
-            {
-            uint8_t shifted = in[LED_WIDTH - 1 - i];
-            rotateTemp[i] =  
-                (((shifted >> 0) & 0x01) << 7) |
-                (((shifted >> 1) & 0x01) << 6) |
-                (((shifted >> 2) & 0x01) << 5) |
-                (((shifted >> 3) & 0x01) << 4) |
-                (((shifted >> 4) & 0x01) << 3) |
-                (((shifted >> 5) & 0x01) << 2) |
-                (((shifted >> 6) & 0x01) << 1) |
-                (((shifted >> 7) & 0x01) << 0);
-            }
-        }
-    else
-        {
-        // do nothing
-        return;
-        }
-      
-    // copy back
+    rotateInto(in, rotateTemp, 1, dir);
     memcpy(in, rotateTemp, LED_WIDTH);
     }
 
@@ -1633,16 +1787,15 @@ void writeNumber(unsigned char* mat1, unsigned char* mat2, int16_t val)
     {
     char b[6];
     numberToString(b, val);
-    uint8_t neg = 0;
         
     if (b[0] == '1')
         memcpy_P(mat2, font_4x5[GLYPH_4x5_10 + b[1] - '0'], 4);
     else if (b[0] == '-')
-        { memcpy_P(mat2, font_4x5[GLYPH_4x5_NEGATIVE_1 + b[1] - '0' - 1], 4); neg = 1; }
+        memcpy_P(mat2, font_4x5[GLYPH_4x5_NEGATIVE_1 + b[1] - '0' - 1], 4);
     else if (b[1] >= '0' && b[1] <= '9')
         memcpy_P(mat2 + 1, font_3x5[GLYPH_3x5_0 + b[1] - '0'], 3);
     else if (b[1] == '-')
-        { memcpy_P(mat2 + 1, font_3x5[GLYPH_3x5_MINUS], 3); neg = 1; }
+        memcpy_P(mat2 + 1, font_3x5[GLYPH_3x5_MINUS], 3);
 
     if (b[2] >= '0' && b[2] <= '9')
         memcpy_P(mat2 + 5, font_3x5[GLYPH_3x5_0 + b[2] - '0'], 3);
@@ -2117,7 +2270,7 @@ void addToBuffer(const char* val, uint8_t extra) //  = 0)
         // compute padding
         
         uint8_t len = 0;
-        uint8_t lastWasSpace;
+        uint8_t lastWasSpace = 0;
         for(uint8_t i = 0; val[i] != '\0'; i++)
             {
             char c = val[i];
@@ -2270,9 +2423,7 @@ void setScreenBrightness(uint8_t brightness)
     if (brightness > 15) return;
         
 #if defined(SCREEN_TYPE_ADAFRUIT_16x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_8x8_BACKPACK) || defined(SCREEN_TYPE_ADAFRUIT_16x8_FEATHERWING_BACKPACK)
-    Wire.beginTransmission(I2C_ADDRESS);
-    Wire.write(LED_BRIGHTNESS_I2C | brightness);
-    Wire.endTransmissionNonblocking();  
+    twiCommand(LED_BRIGHTNESS_I2C | brightness);
 #endif
 
 #ifdef SCREEN_TYPE_SPARKFUN_8x8_KIT
@@ -192,7 +192,7 @@
 #define GLYPH_8x5_TRIPLET       5
 #define GLYPH_8x5_EIGHTH                6
 #define GLYPH_8x5_QUARTER_NOTE_TRIPLET	7
-#define GLYPH_8x5_DOTTED_HALF	8
+#define GLYPH_8x5_DOTTED_EIGHTH	8
 #define GLYPH_8x5_QUARTER       9
 //#define GLYPH_8x5_QUARTER_TIED_TO_TRIPLET       ----
 #define GLYPH_8x5_DOTTED_QUARTER    10    
@@ -264,6 +264,13 @@ void setRotation(uint8_t dir);
 // matrix2 can be NULL only if we're using the 8x8 screens
 void sendMatrix(unsigned char* matrix, unsigned char* matrix2);
 
+#ifdef INCLUDE_PROFILER
+// How many bytes sendMatrix() has avoided putting on the I2C bus by sending
+// only the changed rows, compared to sending every frame in full (address plus
+// 17 bytes).  Always 0 for the Sparkfun kit.  Shown by the Profiler.
+extern uint32_t ledBytesSaved;
+#endif INCLUDE_PROFILER
+
 // Rotates a matrix in the given direction.
 void rotateMatrix(unsigned char* in, uint8_t dir);
 
@@ -379,7 +386,7 @@ void writeNotePitchLong(unsigned char* mat, unsigned char* mat2, unsigned char n
 #define NOTE_SPEED_SIXTEENTH 4
 #define NOTE_SPEED_TRIPLET 5
 #define NOTE_SPEED_EIGHTH 6
-#define NOTE_SPEED_QUARTER_TRIPLET 7
+#define NOTE_SPEED_QUARTER_NOTE_TRIPLET 7
 #define NOTE_SPEED_DOTTED_EIGHTH 8
 #define NOTE_SPEED_QUARTER 9
 #define NOTE_SPEED_DOTTED_QUARTER 10
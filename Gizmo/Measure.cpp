@@ -79,6 +79,15 @@ void resetMeasure()
     local.measure.beatsSoFar = 0;
     }
         
+void seekMeasure(uint32_t position)
+    {
+    if (!local.measure.running)
+        return;
+    // a beat falls on pulse 0, 24, 48, ...
+    local.measure.beatsSoFar = (uint16_t)((position + PULSES_PER_BEAT - 1) / PULSES_PER_BEAT);
+    local.measure.initialTime = currentTime - position * getMicrosecsPerPulse();
+    }
+        
 void playMeasure()
     {
     if (beat && local.measure.running)
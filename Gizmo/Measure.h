@@ -20,5 +20,7 @@ void stateMeasure();
 void playMeasure();
 void stateMeasureMenu();
 void resetMeasure();
+// Counts the beats as if we'd been running for POSITION pulses.  See setSongPosition().
+void seekMeasure(uint32_t position);
 
 #endif
@@ -14,6 +14,57 @@ GLOBAL uint8_t leftPotParameterEquivalent = false;
 
 
 
+////////// INCOMING MIDI QUEUE
+
+GLOBAL static struct _midiItem midiItemQueue[MIDI_ITEM_QUEUE_SIZE];
+GLOBAL static uint8_t midiItemQueueHead = 0;            // where the next item will be popped
+GLOBAL static uint8_t midiItemQueueCount = 0;
+
+void clearMIDIQueue()
+    {
+    midiItemQueueCount = 0;
+    }
+
+void readMIDI()
+    {
+    // When we get here, go() has already cleared out the last item,
+    // so anything appearing in newItem came from the handlers below
+    for(uint8_t i = 0; i < MIDI_READ_BUDGET && midiItemQueueCount < MIDI_ITEM_QUEUE_SIZE; i++)
+        {
+        if (!Serial.available()) break;
+        
+        MIDI.read();
+        if (newItem != NO_NEW_ITEM)
+            {
+            struct _midiItem* item = &midiItemQueue[(midiItemQueueHead + midiItemQueueCount) & (MIDI_ITEM_QUEUE_SIZE - 1)];
+            item->newItem = newItem;
+            item->type = itemType;
+            item->channel = itemChannel;
+            item->number = itemNumber;
+            item->value = itemValue;
+            midiItemQueueCount++;
+            newItem = NO_NEW_ITEM;
+            itemChannel = CHANNEL_OFF;
+            }
+        
+        if (pulse) break;           // don't let a second pulse overwrite the first
+        }
+        
+    if (midiItemQueueCount > 0)
+        {
+        struct _midiItem* item = &midiItemQueue[midiItemQueueHead];
+        newItem = item->newItem;
+        itemType = item->type;
+        itemChannel = item->channel;
+        itemNumber = item->number;
+        itemValue = item->value;
+        midiItemQueueHead = (midiItemQueueHead + 1) & (MIDI_ITEM_QUEUE_SIZE - 1);
+        midiItemQueueCount--;
+        }
+    }
+
+
+
 ////////// MIDI HANDLERS  
 
 
@@ -259,7 +310,7 @@ void handleNoteOff(byte channel, byte note, byte velocity)
                     {
                     if (state != STATE_THRU_PLAY || !options.thruBlockOtherChannels)
                         {
-                        MIDI.sendNoteOff(note, velocity, channel);
+                        queueMIDI(MIDINoteOff, note, velocity, channel);
                         TOGGLE_OUT_LED();
                         }
                     }
@@ -277,7 +328,7 @@ void handleNoteOff(byte channel, byte note, byte velocity)
                 {
                 if (!bypass)
                     {
-                    MIDI.sendNoteOff(note, velocity, channel);
+                    queueMIDI(MIDINoteOff, note, velocity, channel);
                     }
                 TOGGLE_OUT_LED();
                 }
@@ -413,7 +464,7 @@ void handleNoteOn(byte channel, byte note, byte velocity)
                     {
                     if (state != STATE_THRU_PLAY || !options.thruBlockOtherChannels)
                         {
-                        MIDI.sendNoteOn(note, velocity, channel);
+                        queueMIDI(MIDINoteOn, note, velocity, channel);
                         TOGGLE_OUT_LED();
                         }
                     }
@@ -431,7 +482,7 @@ void handleNoteOn(byte channel, byte note, byte velocity)
                 {
                 if (!bypass)
                     {
-                    MIDI.sendNoteOn(note, velocity, channel);
+                    queueMIDI(MIDINoteOn, note, velocity, channel);
                     }
                 TOGGLE_OUT_LED();
                 }
@@ -489,7 +540,7 @@ void handleAfterTouchPoly(byte channel, byte note, byte pressure)
                 {
                 if (state != STATE_THRU_PLAY || !options.thruBlockOtherChannels)
                     {
-                    MIDI.sendPolyPressure(note, pressure, channel);
+                    queueMIDI(MIDIAfterTouchPoly, note, pressure, channel);
                     TOGGLE_OUT_LED();
                     }
                 }
@@ -510,7 +561,7 @@ void handleAfterTouchPoly(byte channel, byte note, byte pressure)
 #ifdef INCLUDE_THRU
                 if (state != STATE_THRU_PLAY || !options.thruBlockOtherChannels)
 #endif
-                    MIDI.sendPolyPressure(note, pressure, channel);
+                    queueMIDI(MIDIAfterTouchPoly, note, pressure, channel);
                 }
             TOGGLE_OUT_LED();
             }
@@ -1228,10 +1279,10 @@ void handleGeneralControlChange(byte channel, byte number, byte value)
             if (application == STATE_SPLIT && local.split.playing)
                 {
                 if ((options.splitControls == SPLIT_CONTROLS_RIGHT) || (options.splitControls == SPLIT_MIX))
-                    MIDI.sendControlChange(number, value, options.channelOut);
+                    queueMIDI(MIDIChannelControl, number, value, options.channelOut);
                 else
                     {
-                    MIDI.sendControlChange(number, value, options.splitChannel);
+                    queueMIDI(MIDIChannelControl, number, value, options.splitChannel);
                     }
                 TOGGLE_OUT_LED();
                 }
@@ -1246,13 +1297,13 @@ void handleGeneralControlChange(byte channel, byte number, byte value)
                         uint8_t channelOut = options.arpeggiatorPlayAlongChannel;
                         if (channelOut == 0)
                             channelOut = options.channelOut;
-                        MIDI.sendControlChange(number, value, channelOut);  // generally pass through control changes
+                        queueMIDI(MIDIChannelControl, number, value, channelOut);  // generally pass through control changes
                         TOGGLE_OUT_LED();
                         }
                     // If we're not playing along, route to Midi Out
                     else
                         {
-                        MIDI.sendControlChange(number, value, options.channelOut);  // generally pass through control changes
+                        queueMIDI(MIDIChannelControl, number, value, options.channelOut);  // generally pass through control changes
                         TOGGLE_OUT_LED();
                         }
                     }
@@ -1269,7 +1320,7 @@ void handleGeneralControlChange(byte channel, byte number, byte value)
                 if (!options.thruBlockOtherChannels)
                     {
                     // Note this does NOT include the merge channel
-                    MIDI.sendControlChange(number, value, channel);  // generally pass through control changes
+                    queueMIDI(MIDIChannelControl, number, value, channel);  // generally pass through control changes
                     TOGGLE_OUT_LED();
                     }
                 }
@@ -1277,7 +1328,7 @@ void handleGeneralControlChange(byte channel, byte number, byte value)
 #endif
                 // In general we pass through everything else
                 {
-                MIDI.sendControlChange(number, value, channel);
+                queueMIDI(MIDIChannelControl, number, value, channel);
                 TOGGLE_OUT_LED();
                 }
         }
@@ -1313,13 +1364,13 @@ void handleProgramChange(byte channel, byte number)
                 uint8_t channelOut = options.arpeggiatorPlayAlongChannel;
                 if (channelOut == 0)
                     channelOut = options.channelOut;
-                MIDI.sendProgramChange(number, channelOut);
+                queueMIDI(MIDIProgramChange, number, 0, channelOut);
                 TOGGLE_OUT_LED();
                 }
             // If we're not playing along, route to Midi Out
             else
                 {
-                MIDI.sendProgramChange(number, options.channelOut);
+                queueMIDI(MIDIProgramChange, number, 0, options.channelOut);
                 TOGGLE_OUT_LED();
                 }
             }
@@ -1330,9 +1381,9 @@ void handleProgramChange(byte channel, byte number)
             if (application == STATE_SPLIT && local.split.playing && (channel == options.channelIn || options.channelIn == CHANNEL_OMNI))
                 {
                 if ((options.splitControls == SPLIT_CONTROLS_RIGHT) || (options.splitControls == SPLIT_MIX))
-                    MIDI.sendProgramChange(number, options.channelOut);
+                    queueMIDI(MIDIProgramChange, number, 0, options.channelOut);
                 else
-                    MIDI.sendProgramChange(number, options.splitChannel);
+                    queueMIDI(MIDIProgramChange, number, 0, options.splitChannel);
                 TOGGLE_OUT_LED();
                 }
             else
@@ -1344,7 +1395,7 @@ void handleProgramChange(byte channel, byte number)
                     if ((channel != options.channelIn) && (options.channelIn != CHANNEL_OMNI)
                         && channel != options.thruMergeChannelIn)
                         {
-                        MIDI.sendProgramChange(number, channel);
+                        queueMIDI(MIDIProgramChange, number, 0, channel);
                         TOGGLE_OUT_LED();
                         }
                     else if (channel == options.thruMergeChannelIn)  //  merge hasn't been sent to newitem yet
@@ -1364,7 +1415,7 @@ void handleProgramChange(byte channel, byte number)
                         if (state != STATE_THRU_PLAY || !options.thruBlockOtherChannels)
 #endif
                             {
-                            MIDI.sendProgramChange(number, channel);
+                            queueMIDI(MIDIProgramChange, number, 0, channel);
                             TOGGLE_OUT_LED();
                             }
                         }
@@ -1384,7 +1435,7 @@ void handleAfterTouchChannel(byte channel, byte pressure)
             uint8_t channelOut = options.arpeggiatorPlayAlongChannel;
             if (channelOut == 0)
                 channelOut = options.channelOut;
-            MIDI.sendAfterTouch(pressure, channelOut);
+            queueMIDI(MIDIAfterTouchChannel, pressure, 0, channelOut);
             }
         else
 #endif
@@ -1394,9 +1445,9 @@ void handleAfterTouchChannel(byte channel, byte pressure)
             if (application == STATE_SPLIT && local.split.playing && (channel == options.channelIn || options.channelIn == CHANNEL_OMNI))
                 {
                 if ((options.splitControls == SPLIT_CONTROLS_RIGHT) || (options.splitControls == SPLIT_MIX))
-                    MIDI.sendAfterTouch(pressure, options.channelOut);
+                    queueMIDI(MIDIAfterTouchChannel, pressure, 0, options.channelOut);
                 else
-                    MIDI.sendAfterTouch(pressure, options.splitChannel);
+                    queueMIDI(MIDIAfterTouchChannel, pressure, 0, options.splitChannel);
                 TOGGLE_OUT_LED();
                 }
             else
@@ -1408,7 +1459,7 @@ void handleAfterTouchChannel(byte channel, byte pressure)
                     if ((channel != options.channelIn) && (options.channelIn != CHANNEL_OMNI)
                         && channel != options.thruMergeChannelIn)
                         {
-                        MIDI.sendAfterTouch(pressure, channel);
+                        queueMIDI(MIDIAfterTouchChannel, pressure, 0, channel);
                         TOGGLE_OUT_LED();
                         }
                     else if (channel == options.thruMergeChannelIn)  //  merge hasn't been sent to newitem yet
@@ -1428,7 +1479,7 @@ void handleAfterTouchChannel(byte channel, byte pressure)
                         if (state != STATE_THRU_PLAY || !options.thruBlockOtherChannels)
 #endif
                             {
-                            MIDI.sendAfterTouch(pressure, channel);
+                            queueMIDI(MIDIAfterTouchChannel, pressure, 0, channel);
                             TOGGLE_OUT_LED();
                             }
                         }
@@ -1451,12 +1502,12 @@ void handlePitchBend(byte channel, int bend)
                 uint8_t channelOut = options.arpeggiatorPlayAlongChannel;
                 if (channelOut == 0)
                     channelOut = options.channelOut;
-                MIDI.sendPitchBend(bend, channelOut);
+                queuePitchBend(bend, channelOut);
                 TOGGLE_OUT_LED();
                 }
             else if (channel == options.channelIn || options.channelIn == CHANNEL_OMNI)
                 {
-                MIDI.sendPitchBend(bend, options.channelOut);
+                queuePitchBend(bend, options.channelOut);
                 TOGGLE_OUT_LED();
                 }
             }
@@ -1469,15 +1520,15 @@ void handlePitchBend(byte channel, int bend)
                 if ((options.splitLayerNote == NO_NOTE) && (options.splitControls != SPLIT_MIX))
                     {
                     if (options.splitControls == SPLIT_CONTROLS_RIGHT)
-                        MIDI.sendPitchBend(bend, options.channelOut);
+                        queuePitchBend(bend, options.channelOut);
                     else
-                        MIDI.sendPitchBend(bend, options.splitChannel);
+                        queuePitchBend(bend, options.splitChannel);
                     TOGGLE_OUT_LED();
                     }
                 else    // send to both
                     {
-                    MIDI.sendPitchBend(bend, options.channelOut);
-                    MIDI.sendPitchBend(bend, options.splitChannel);
+                    queuePitchBend(bend, options.channelOut);
+                    queuePitchBend(bend, options.splitChannel);
                     TOGGLE_OUT_LED();
                     }
                 }
@@ -1490,7 +1541,7 @@ void handlePitchBend(byte channel, int bend)
                     if ((channel != options.channelIn) && (options.channelIn != CHANNEL_OMNI)
                         && channel != options.thruMergeChannelIn)
                         {
-                        MIDI.sendPitchBend(bend, channel);
+                        queuePitchBend(bend, channel);
                         TOGGLE_OUT_LED();
                         }
                     else if (channel == options.thruMergeChannelIn)  //  merge hasn't been sent to newitem yet
@@ -1510,7 +1561,7 @@ void handlePitchBend(byte channel, int bend)
                         if (state != STATE_THRU_PLAY || !options.thruBlockOtherChannels)
 #endif
                             {
-                            MIDI.sendPitchBend(bend, channel);
+                            queuePitchBend(bend, channel);
                             TOGGLE_OUT_LED();
                             }
                         }
@@ -1525,6 +1576,7 @@ void handleTimeCodeQuarterFrame(byte data)
     //itemType = MIDI_TIME_CODE;
 
     // always pass through.
+    flushMIDI();
     MIDI.sendTimeCodeQuarterFrame(data);
     }
   
@@ -1535,6 +1587,7 @@ void handleSystemExclusive(byte* array, unsigned size)
     //itemType = MIDI_SYSTEM_EXCLUSIVE;
 
     // always pass through
+    flushMIDI();
     MIDI.sendSysEx(size, array);
     }
   
@@ -1543,7 +1596,12 @@ void handleSongPosition(unsigned beats)
     toggleLEDsAndSetNewItem(MIDI_SONG_POSITION);
     //itemType = MIDI_SONG_POSITION;
 
+    // MIDI says SPP only comes while the clock is stopped
+    if (USING_EXTERNAL_CLOCK() && getClockState() == CLOCK_STOPPED)
+        setSongPosition(beats);
+
     // always pass through
+    flushMIDI();
     MIDI.sendSongPosition(beats);
     }
 
@@ -1553,6 +1611,7 @@ void handleSongSelect(byte songnumber)
     //itemType = MIDI_SONG_SELECT;
 
     // always pass through
+    flushMIDI();
     MIDI.sendSongSelect(songnumber);
     }
   
@@ -1562,6 +1621,7 @@ void handleTuneRequest()
     //itemType = MIDI_TUNE_REQUEST;
 
     // always pass through
+    flushMIDI();
     MIDI.sendTuneRequest();
     }
   
@@ -1571,7 +1631,7 @@ void handleActiveSensing()
     //itemType = MIDI_ACTIVE_SENSING;
         
     // always pass through
-    MIDI.sendRealTime(MIDIActiveSensing);
+    queueMIDI(MIDIActiveSensing, 0, 0, 0);
     }
   
 void handleSystemReset()
@@ -1580,7 +1640,7 @@ void handleSystemReset()
     //itemType = MIDI_SYSTEM_RESET;
 
     // always pass through
-    MIDI.sendRealTime(MIDISystemReset);
+    queueMIDI(MIDISystemReset, 0, 0, 0);
     }
 
 
@@ -1588,6 +1648,153 @@ void handleSystemReset()
 
 
 
+/// OUTGOING MIDI QUEUE
+
+GLOBAL static struct _midiOut midiOutQueue[NUM_MIDI_OUT_QUEUES][MIDI_OUT_QUEUE_SIZE];
+GLOBAL static uint8_t midiOutQueueHead[NUM_MIDI_OUT_QUEUES];
+GLOBAL static uint8_t midiOutQueueCount[NUM_MIDI_OUT_QUEUES];
+GLOBAL static uint8_t midiOutTotal = 0;
+GLOBAL uint8_t midiOutMaxDepth = 0;
+GLOBAL uint16_t midiOutDropped = 0;
+
+// The largest a single message can be (a channel message with no running status)
+#define MIDI_OUT_MAX_MESSAGE_SIZE 3
+
+void sendMIDINow(uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel)
+    {
+    if (type >= MIDIClock)
+        MIDI.sendRealTime((midi::MidiType)type);
+    else
+        {
+        if (options.midiOutRunningStatus == MIDI_OUT_NO_RUNNING_STATUS)
+            {
+            // Sending to an invalid channel sends nothing but makes the library forget its running status
+            MIDI.send(MIDINoteOn, 0, 0, MIDI_CHANNEL_OFF);
+            }
+        else if (options.midiOutRunningStatus == MIDI_OUT_RUNNING_STATUS_NOTE_OFF && type == MIDINoteOff)
+            {
+            type = MIDINoteOn;
+            data2 = 0;
+            }
+        MIDI.send((midi::MidiType)type, data1, data2, channel);
+        }
+    }
+
+void writeMIDI()
+    {
+    for(uint8_t q = 0; q < NUM_MIDI_OUT_QUEUES; q++)
+        {
+        while (midiOutQueueCount[q] > 0)
+            {
+            if (Serial.availableForWrite() < MIDI_OUT_MAX_MESSAGE_SIZE) 
+                return;
+            struct _midiOut* m = &midiOutQueue[q][midiOutQueueHead[q]];
+            sendMIDINow(m->type, m->data1, m->data2, m->channel);
+            midiOutQueueHead[q] = (midiOutQueueHead[q] + 1) & (MIDI_OUT_QUEUE_SIZE - 1);
+            midiOutQueueCount[q]--;
+            midiOutTotal--;
+            }
+        }
+    }
+
+void flushMIDI()
+    {
+    while (midiOutTotal > 0)
+        writeMIDI();
+    }
+
+uint8_t realtimeMIDIQueued()
+    {
+    return (midiOutQueueCount[MIDI_OUT_REALTIME] > 0);
+    }
+
+// Returns true if a Note On for the given note and channel is waiting
+uint8_t noteOnQueued(uint8_t note, uint8_t channel)
+    {
+    for(uint8_t i = 0; i < midiOutQueueCount[MIDI_OUT_NOTE_ON]; i++)
+        {
+        struct _midiOut* m = &midiOutQueue[MIDI_OUT_NOTE_ON][(midiOutQueueHead[MIDI_OUT_NOTE_ON] + i) & (MIDI_OUT_QUEUE_SIZE - 1)];
+        if (m->type == MIDINoteOn && m->data1 == note && m->channel == channel)
+            return true;
+        }
+    return false;
+    }
+
+// Throws away any waiting Note Ons on the given channel
+void removeQueuedNoteOns(uint8_t channel)
+    {
+    uint8_t head = midiOutQueueHead[MIDI_OUT_NOTE_ON];
+    uint8_t count = midiOutQueueCount[MIDI_OUT_NOTE_ON];
+    uint8_t kept = 0;
+    for(uint8_t i = 0; i < count; i++)
+        {
+        struct _midiOut* m = &midiOutQueue[MIDI_OUT_NOTE_ON][(head + i) & (MIDI_OUT_QUEUE_SIZE - 1)];
+        if (m->type == MIDINoteOn && m->channel == channel)
+            continue;
+        midiOutQueue[MIDI_OUT_NOTE_ON][(head + kept) & (MIDI_OUT_QUEUE_SIZE - 1)] = *m;
+        kept++;
+        }
+    midiOutQueueCount[MIDI_OUT_NOTE_ON] = kept;
+    midiOutTotal -= (count - kept);
+    }
+
+void queueMIDI(midi::MidiType type, uint8_t data1, uint8_t data2, uint8_t channel)
+    {
+    uint8_t q;
+    if (type >= MIDIClock)
+        q = MIDI_OUT_REALTIME;
+    else if (type == MIDINoteOn)
+        q = MIDI_OUT_NOTE_ON;
+    else if (type == MIDINoteOff)
+        q = (noteOnQueued(data1, channel) ? MIDI_OUT_NOTE_ON : MIDI_OUT_NOTE_OFF);     // don't pass a waiting Note On
+    else if (type == MIDIChannelControl && data1 >= 120)
+        {
+        removeQueuedNoteOns(channel);
+        q = MIDI_OUT_NOTE_OFF;
+        }
+    else
+        q = MIDI_OUT_OTHER;
+
+    // Get rid of what we can first so we stay in order
+    if (midiOutTotal > 0)
+        writeMIDI();
+    
+    if (midiOutTotal == 0 && Serial.availableForWrite() >= MIDI_OUT_MAX_MESSAGE_SIZE)
+        {
+        sendMIDINow(type, data1, data2, channel);
+        return;
+        }
+        
+    if (midiOutQueueCount[q] == MIDI_OUT_QUEUE_SIZE)
+        {
+        if (q == MIDI_OUT_REALTIME || type == MIDINoteOff)
+            {
+            flushMIDI();            // we can't lose these, so we have to wait
+            sendMIDINow(type, data1, data2, channel);
+            }
+        else
+            {
+            midiOutDropped++;
+            }
+        return;
+        }
+        
+    midiOutQueue[q][(midiOutQueueHead[q] + midiOutQueueCount[q]) & (MIDI_OUT_QUEUE_SIZE - 1)] = { (uint8_t)type, data1, data2, channel };
+    midiOutQueueCount[q]++;
+    midiOutTotal++;
+    if (midiOutTotal > midiOutMaxDepth)
+        midiOutMaxDepth = midiOutTotal;
+    }
+
+void queuePitchBend(int bend, uint8_t channel)
+    {
+    // See MIDI.sendPitchBend(...)
+    uint16_t b = bend - MIDI_PITCHBEND_MIN;
+    queueMIDI(MIDIPitchBend, b & 0x7F, (b >> 7) & 0x7F, channel);
+    }
+
+
+
 /// MIDI OUT SUPPORT
 ///
 /// The following functions foo(...) are called instead of the MIDI.foo(...)
@@ -1603,7 +1810,7 @@ void sendPolyPressure(uint8_t note, uint8_t pressure, uint8_t channel)
 
     int16_t n = note + (uint16_t)options.transpose;
     n = bound(n, 0, 127);
-    MIDI.sendPolyPressure((uint8_t) n, pressure, channel);
+    queueMIDI(MIDIAfterTouchPoly, (uint8_t) n, pressure, channel);
     TOGGLE_OUT_LED();
     }
             
@@ -1622,7 +1829,7 @@ void sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel)
     else if (options.volume > 3)
         v = v << (options.volume - 3);
     if (v > 127) v = 127;
-    MIDI.sendNoteOn((uint8_t) n, (uint8_t) v, channel);
+    queueMIDI(MIDINoteOn, (uint8_t) n, (uint8_t) v, channel);
 
     TOGGLE_OUT_LED();
     }
@@ -1634,7 +1841,7 @@ void sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel)
 
     int16_t n = note + (uint16_t)options.transpose;
     n = bound(n, 0, 127);
-    MIDI.sendNoteOff((uint8_t) n, velocity, channel);
+    queueMIDI(MIDINoteOff, (uint8_t) n, velocity, channel);
     // dont' toggle the LED because if we're going really fast it toggles
     // the LED ON and OFF for a noteoff/noteon pair and you can't see the LED
     }
@@ -1649,20 +1856,20 @@ void sendAllSoundsOffDisregardBypass(uint8_t channel)
         for(uint8_t i = LOWEST_MIDI_CHANNEL; i <= HIGHEST_MIDI_CHANNEL; i++)
             {
 #ifdef USE_ALL_NOTES_OFF
-            MIDI.sendControlChange(123, 0, i);          // All Notes Off
+            queueMIDI(MIDIChannelControl, 123, 0, i);          // All Notes Off
 #endif
 #ifdef USE_ALL_SOUNDS_OFF
-            MIDI.sendControlChange(120, 0, i);              // All Sound Off
+            queueMIDI(MIDIChannelControl, 120, 0, i);              // All Sound Off
 #endif
             }
         }
     else
         {
 #ifdef USE_ALL_NOTES_OFF
-        MIDI.sendControlChange(123, 0, channel);        // All Notes Off
+        queueMIDI(MIDIChannelControl, 123, 0, channel);        // All Notes Off
 #endif
 #ifdef USE_ALL_SOUNDS_OFF
-        MIDI.sendControlChange(120, 0, channel);        // All Sound Off
+        queueMIDI(MIDIChannelControl, 120, 0, channel);        // All Sound Off
 #endif
         }
     }
@@ -1750,13 +1957,13 @@ void sendControllerCommand(uint8_t commandType, uint16_t commandNumber, uint16_t
             // and ones with an MSB + [optional] LSB.  The second kind are messages whose
             // command number is 0...31.  The first kind are messages > 31.
             
-            MIDI.sendControlChange(commandNumber, msb, channel);
+            queueMIDI(MIDIChannelControl, commandNumber, msb, channel);
 #ifdef DONT_SEND_14_BIT_CC
 // do nothing
 #else
             if (commandNumber < 32 && lsb != 0)             // send optional lsb if appropriate
                 {
-                MIDI.sendControlChange(commandNumber + 32, lsb, channel);
+                queueMIDI(MIDIChannelControl, commandNumber + 32, lsb, channel);
                 }
 #endif
             TOGGLE_OUT_LED(); 
@@ -1765,25 +1972,25 @@ void sendControllerCommand(uint8_t commandType, uint16_t commandNumber, uint16_t
         case CONTROL_TYPE_NRPN:
             {
             // Send 99 for NRPN, or 101 for RPN
-            MIDI.sendControlChange(99, commandNumber >> 7, channel);
-            MIDI.sendControlChange(98, commandNumber & 127, channel);  // LSB
+            queueMIDI(MIDIChannelControl, 99, commandNumber >> 7, channel);
+            queueMIDI(MIDIChannelControl, 98, commandNumber & 127, channel);  // LSB
             if (msb == CONTROL_VALUE_INCREMENT)
                 {
-                MIDI.sendControlChange(96, lsb, channel);
+                queueMIDI(MIDIChannelControl, 96, lsb, channel);
                 }
             else if (msb == CONTROL_VALUE_DECREMENT)
                 {
-                MIDI.sendControlChange(97, lsb, channel);
+                queueMIDI(MIDIChannelControl, 97, lsb, channel);
                 }
             else
                 {
-                MIDI.sendControlChange(6, msb, channel);  // MSB
+                queueMIDI(MIDIChannelControl, 6, msb, channel);  // MSB
                 if (lsb != 0)
-                    MIDI.sendControlChange(38, lsb, channel);  // LSB
+                    queueMIDI(MIDIChannelControl, 38, lsb, channel);  // LSB
                 }
 #ifdef INCLUDE_SEND_NULL_RPN
-            MIDI.sendControlChange(101, 127, channel);  // MSB of NULL command
-            MIDI.sendControlChange(100, 127, channel);  // LSB of NULL command
+            queueMIDI(MIDIChannelControl, 101, 127, channel);  // MSB of NULL command
+            queueMIDI(MIDIChannelControl, 100, 127, channel);  // LSB of NULL command
 #endif
             TOGGLE_OUT_LED(); 
             }
@@ -1791,25 +1998,25 @@ void sendControllerCommand(uint8_t commandType, uint16_t commandNumber, uint16_t
         // note merging these actually loses bytes.  I tried.
         case CONTROL_TYPE_RPN:
             {
-            MIDI.sendControlChange(101, commandNumber >> 7, channel);
-            MIDI.sendControlChange(100, commandNumber & 127, channel);  // LSB
+            queueMIDI(MIDIChannelControl, 101, commandNumber >> 7, channel);
+            queueMIDI(MIDIChannelControl, 100, commandNumber & 127, channel);  // LSB
             if (msb == CONTROL_VALUE_INCREMENT)
                 {
-                MIDI.sendControlChange(96, lsb, channel);
+                queueMIDI(MIDIChannelControl, 96, lsb, channel);
                 }
             else if (msb == CONTROL_VALUE_DECREMENT)
                 {
-                MIDI.sendControlChange(97, lsb, channel);
+                queueMIDI(MIDIChannelControl, 97, lsb, channel);
                 }
             else
                 {
-                MIDI.sendControlChange(6, msb, channel);  // MSB
+                queueMIDI(MIDIChannelControl, 6, msb, channel);  // MSB
                 if (lsb != 0)
-                    MIDI.sendControlChange(38, lsb, channel);  // LSB
+                    queueMIDI(MIDIChannelControl, 38, lsb, channel);  // LSB
                 }
 #ifdef INCLUDE_SEND_NULL_RPN
-            MIDI.sendControlChange(101, 127, channel);  // MSB of NULL command
-            MIDI.sendControlChange(100, 127, channel);  // LSB of NULL command
+            queueMIDI(MIDIChannelControl, 101, 127, channel);  // MSB of NULL command
+            queueMIDI(MIDIChannelControl, 100, 127, channel);  // LSB of NULL command
 #endif
             TOGGLE_OUT_LED(); 
             }
@@ -1817,19 +2024,19 @@ void sendControllerCommand(uint8_t commandType, uint16_t commandNumber, uint16_t
         case CONTROL_TYPE_PC:
             {
             if (msb <= MAXIMUM_PC_VALUE)
-                MIDI.sendProgramChange(msb, channel);
+                queueMIDI(MIDIProgramChange, msb, 0, channel);
             TOGGLE_OUT_LED(); 
             }
         break;
         case CONTROL_TYPE_PITCH_BEND:
             {
             // move from 0...16k to -8k...8k
-            MIDI.sendPitchBend(((int)fullValue) - MIDI_PITCHBEND_MIN, channel);
+            queuePitchBend(((int)fullValue) - MIDI_PITCHBEND_MIN, channel);
             }
         break;
         case CONTROL_TYPE_AFTERTOUCH:
             {
-            MIDI.sendAfterTouch(msb, channel);
+            queueMIDI(MIDIAfterTouchChannel, msb, 0, channel);
             }
         break;
         }
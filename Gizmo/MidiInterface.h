@@ -133,6 +133,42 @@ extern uint16_t itemValue;              // Note on/off use this for NOTE VELOCIT
 extern uint8_t itemChannel;				// Channel of the incoming item.  One of 1...16
 
 
+//// INCOMING MIDI QUEUE
+////
+//// The five variables above are really a view on the front of a queue.  Each tick, readMIDI()
+//// parses as many incoming bytes as it can (up to MIDI_READ_BUDGET), and every item the
+//// handlers produce is pushed onto the queue rather than overwriting the one before.  Then
+//// the oldest item is popped into newItem, itemType, etc. for the applications to look at
+//// as they always have.  So you don't need to do anything special: you just see one item per tick.
+////
+//// If the queue fills up, readMIDI() stops parsing and leaves the remaining bytes in the
+//// serial buffer until the next tick.  readMIDI() also stops after a MIDI clock pulse, because 
+//// pulses are only consumed once per tick by updateTimers().
+
+#if defined(__MEGA__)
+#define MIDI_ITEM_QUEUE_SIZE 16                 // must be a power of 2
+#else
+#define MIDI_ITEM_QUEUE_SIZE 4                  // must be a power of 2
+#endif
+
+#define MIDI_READ_BUDGET 8                      // maximum bytes parsed per tick
+
+struct _midiItem
+    {
+    uint8_t newItem;
+    uint8_t type;
+    uint8_t channel;
+    uint16_t number;
+    uint16_t value;
+    };
+
+// Reads incoming MIDI, fills the queue, and pops the next item into newItem etc.  Called once per tick by go().
+void readMIDI();
+
+// Throws away everything in the queue
+void clearMIDIQueue();
+
+
 
 //// REMOTE CONTROL VIA NRPN or CC
 
@@ -279,6 +315,106 @@ void handleActiveSensing();
 void handleSystemReset();
 
 
+//// MIDI SERIAL PORT
+////
+//// With INCLUDE_TIMED_CLOCK, a Timer3 interrupt may write a clock byte straight into the
+//// USART (see Timing.h).  HardwareSerial::write() checks that the USART is free before writing to it,
+//// but doesn't block interrupts in between, so if the timer slipped in there, one of the two bytes
+//// would be lost.  So in this case the MIDI library writes through MidiSerial, which holds off
+//// the timer interrupt while it writes.
+
+#ifdef INCLUDE_TIMED_CLOCK
+class MidiSerial
+    {
+    public:
+    void begin(unsigned long baud) { Serial.begin(baud); }
+    int available() { return Serial.available(); }
+    int read() { return Serial.read(); }
+    size_t write(uint8_t b);                            // in Timing.cpp
+    };
+#else
+#define MidiSerial HardwareSerial
+#endif INCLUDE_TIMED_CLOCK
+
+
+//// OUTGOING MIDI QUEUE
+////
+//// The serial port's transmit buffer is only 64 bytes, and if we fill it, MIDI.sendFoo(...) blocks
+//// until there's room, and we stop reading incoming MIDI in the meantime.  So instead of calling
+//// MIDI.sendFoo(...) directly, Gizmo calls queueMIDI(...), which sends the message immediately if
+//// nothing is waiting and there's room, and otherwise holds it in one of four queues, in order
+//// of priority:
+////
+//// MIDI_OUT_REALTIME     Clock, Start, Stop, Continue
+//// MIDI_OUT_NOTE_OFF     Note Off, and All Sounds Off / All Notes Off (CC 120 and up)
+//// MIDI_OUT_NOTE_ON      Note On
+//// MIDI_OUT_OTHER        Everything else (CC, NRPN, RPN, PC, Bend, Aftertouch)
+////
+//// writeMIDI() is called every tick to move as much as will fit into the serial buffer, highest
+//// priority first.  A Note Off never overtakes a waiting Note On for the same note (it waits behind
+//// it instead), and All Sounds/Notes Off throws away any waiting Note Ons on its channel.  But
+//// note that a Program Change may be overtaken by Note Ons queued after it: if it must arrive first,
+//// send it a tick earlier.
+////
+//// If a queue is full, Note Ons and OTHER messages are dropped (and counted in midiOutDropped).
+//// Realtime messages and Note Offs are never dropped: instead we wait for room, as we used to.
+//// Sysex and system common messages aren't queued: call flushMIDI() before sending them so they
+//// stay in order.
+
+#define MIDI_OUT_REALTIME 0
+#define MIDI_OUT_NOTE_OFF 1
+#define MIDI_OUT_NOTE_ON 2
+#define MIDI_OUT_OTHER 3
+#define NUM_MIDI_OUT_QUEUES 4
+
+#if defined(__MEGA__)
+#define MIDI_OUT_QUEUE_SIZE 16                  // per queue, must be a power of 2
+#else
+#define MIDI_OUT_QUEUE_SIZE 4                   // per queue, must be a power of 2
+#endif
+
+struct _midiOut
+    {
+    uint8_t type;
+    uint8_t data1;
+    uint8_t data2;
+    uint8_t channel;
+    };
+
+extern uint8_t midiOutMaxDepth;                 // the most messages we've had waiting at one time
+extern uint16_t midiOutDropped;                 // how many messages we've had to drop
+
+// Sends or queues a channel or realtime message.  Data bytes are as in MIDI.send(...)
+void queueMIDI(midi::MidiType type, uint8_t data1, uint8_t data2, uint8_t channel);
+// Sends or queues a pitch bend (-8192 ... 8191)
+void queuePitchBend(int bend, uint8_t channel);
+// Moves as many waiting messages into the serial buffer as will fit without blocking.  Called every tick by go().
+void writeMIDI();
+// Sends all waiting messages, blocking if need be.
+void flushMIDI();
+// Returns true if a realtime message (Clock, Start, Continue, Stop) is waiting
+uint8_t realtimeMIDIQueued();
+
+
+//// RUNNING STATUS
+////
+//// The MIDI library leaves out the status byte of a channel message if it's the same as that of the
+//// last one it sent (running status), and forgets it when a sysex or system common message goes out.
+//// Realtime messages don't disturb running status.  So a drum hit of many notes on one channel, or the
+//// four CCs of an NRPN, costs two bytes a message rather than three.  options.midiOutRunningStatus
+//// (Options > RUNNING STATUS on the Mega) picks one of:
+////
+//// MIDI_OUT_RUNNING_STATUS               The default.
+//// MIDI_OUT_RUNNING_STATUS_NOTE_OFF      As above, but Note Offs are sent as Note Ons of velocity 0,
+////                                       so they share running status with the Note Ons around them.
+////                                       Release velocity is lost.
+//// MIDI_OUT_NO_RUNNING_STATUS            Every message gets its status byte, for picky synths.
+
+#define MIDI_OUT_RUNNING_STATUS 0
+#define MIDI_OUT_RUNNING_STATUS_NOTE_OFF 1
+#define MIDI_OUT_NO_RUNNING_STATUS 2
+
+
 //// SENDING MIDI
 void sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel);
 void sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel);
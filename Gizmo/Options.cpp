@@ -28,6 +28,21 @@ uint32_t lastTempoTapTime;
 void loadOptions() 
     { 
     loadData((char*)(&options), OPTIONS_OFFSET, sizeof(options));
+    if (options.magic != OPTIONS_MAGIC)
+        {
+        // Saved by a Gizmo from before the options had a version.  Its tempo was in whole
+        // BPM, and it never wrote the options after gaugeMidiInProvideRawCC.  Upgrade it once.
+        options.tempo = (options.tempo > MAXIMUM_TEMPO / 10 ? MAXIMUM_TEMPO : options.tempo * 10);
+        options.midiOutRunningStatus = MIDI_OUT_RUNNING_STATUS;
+        options.magic = OPTIONS_MAGIC;
+        options.version = OPTIONS_VERSION;
+        saveOptions();
+        finishSaving();
+        }
+    // Out of range, the menu would index past the end of its items.
+    if (options.midiOutRunningStatus > MIDI_OUT_NO_RUNNING_STATUS)
+        options.midiOutRunningStatus = MIDI_OUT_RUNNING_STATUS;
+    options.tempo = max(min(options.tempo, MAXIMUM_TEMPO), MINIMUM_TEMPO);
     setPulseRate(options.tempo);
     setNotePulseRate(options.noteSpeedType);
     setScreenBrightness(options.screenBrightness);
@@ -52,7 +67,9 @@ void resetOptions()
     
     // now just set the ones that aren't zero
     options.screenBrightness = 3;  // not too dim, not mind-numbingly bright
-    options.tempo = 120;
+    options.tempo = 1200;  // 120 BPM
+    options.magic = OPTIONS_MAGIC;
+    options.version = OPTIONS_VERSION;
     options.noteSpeedType = NOTE_SPEED_SIXTEENTH;  // default.  This also allows swing
     options.channelIn = 1;
     options.channelOut = 1;
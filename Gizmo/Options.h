@@ -26,7 +26,7 @@ extern uint32_t lastTempoTapTime;
 struct _options
     {
     // 16-bit stuff first
-    uint16_t tempo ;                             // in Beats Per Minute
+    uint16_t tempo ;                             // in tenths of a Beat Per Minute (see MINIMUM_TEMPO and MAXIMUM_TEMPO in Timing.h)
 
 #ifdef INCLUDE_CONTROLLER
     uint16_t leftKnobControlNumber;
@@ -135,8 +135,18 @@ struct _options
 #ifdef INCLUDE_GAUGE
 	uint8_t gaugeMidiInProvideRawCC;
 #endif
+
+    uint8_t midiOutRunningStatus;                   // one of MIDI_OUT_RUNNING_STATUS etc. (see MidiInterface.h)
+
+    // Options saved by a Gizmo from before these existed don't have them (see loadOptions()).
+    // New options go after them, and bump OPTIONS_VERSION.
+    uint8_t magic;                                  // OPTIONS_MAGIC
+    uint8_t version;                                // OPTIONS_VERSION
     };
 
+#define OPTIONS_MAGIC 'O'
+#define OPTIONS_VERSION 1                           // tempo in tenths of a BPM, and midiOutRunningStatus
+
 // The options struct which is saved and loaded and used
 extern struct _options options;
 
@@ -0,0 +1,248 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#include "All.h"
+
+
+
+#ifdef INCLUDE_PROFILER
+
+// Histogram buckets are 32us wide, so 10 buckets cover a tick and an 11th counts overruns
+#define PROFILE_BUCKET_SHIFT            5
+#define PROFILE_BUCKET_WIDTH            (1 << PROFILE_BUCKET_SHIFT)
+#define NUM_PROFILE_BUCKETS             ((TARGET_TICK_TIMESTEP >> PROFILE_BUCKET_SHIFT) + 1)
+
+// Per-state maxima are stored in units of 4us (the resolution of micros()), saturating at 1020us
+#define PROFILE_STATE_SHIFT             2
+
+struct _profile
+    {
+    uint16_t min;
+    uint16_t max;
+    uint16_t count;
+    uint32_t total;                     // sum of the last count times, halved along with count when count fills up
+    };
+
+struct _profileData
+    {
+    struct _profile section[NUM_PROFILE_SECTIONS];
+    uint16_t histogram[NUM_PROFILE_BUCKETS];
+    uint8_t stateMax[NUM_STATES];
+    uint8_t worstState;
+    uint8_t entryMax;                   // the longest first tick of any state, in the same units as stateMax
+    uint8_t worstEntryState;            // ... and its state
+    };
+
+GLOBAL struct _profileData profileData;
+
+
+void resetProfile()
+    {
+    memset(&profileData, 0, sizeof(struct _profileData));
+    for(uint8_t i = 0; i < NUM_PROFILE_SECTIONS; i++)
+        profileData.section[i].min = 0xFFFF;
+    profileData.worstState = STATE_NONE;
+    profileData.worstEntryState = STATE_NONE;
+    }
+
+
+void profileRecord(uint8_t section, uint32_t time)
+    {
+    uint16_t t = (time > 0xFFFF ? 0xFFFF : (uint16_t)time);
+    struct _profile* p = &profileData.section[section];
+
+    if (t < p->min) p->min = t;
+    if (t > p->max) p->max = t;
+
+    // keep a running average without overflowing: when count fills up, halve everything
+    if (p->count == 0xFFFF)
+        {
+        p->count >>= 1;
+        p->total >>= 1;
+        }
+    p->count++;
+    p->total += t;
+
+    if (section == PROFILE_GO)
+        {
+        uint8_t bucket = (t >= TARGET_TICK_TIMESTEP ? NUM_PROFILE_BUCKETS - 1 : (uint8_t)(t >> PROFILE_BUCKET_SHIFT));
+        if (profileData.histogram[bucket] != 0xFFFF)
+            profileData.histogram[bucket]++;
+        }
+    }
+
+
+void profileRecordState(uint8_t st, uint8_t entered, uint32_t time)
+    {
+    profileRecord(PROFILE_STATE, time);
+    if (st >= NUM_STATES) return;
+
+    time = time >> PROFILE_STATE_SHIFT;
+    uint8_t t = (time > 255 ? 255 : (uint8_t)time);
+    if (entered && (profileData.worstEntryState == STATE_NONE || t > profileData.entryMax))
+        {
+        profileData.entryMax = t;
+        profileData.worstEntryState = st;
+        }
+    if (t > profileData.stateMax[st])
+        {
+        profileData.stateMax[st] = t;
+        if (profileData.worstState == STATE_NONE || t > profileData.stateMax[profileData.worstState])
+            profileData.worstState = st;
+        }
+    }
+
+
+void sendProfileSysex()
+    {
+    // See sendSlotSysex() for the format.  The data is profileData followed by tickStats.
+#define PROFILE_SYSEX_DATA_SIZE (sizeof(struct _profileData) + sizeof(struct _tickStats))
+    uint8_t bytes[PROFILE_SYSEX_DATA_SIZE * 2 + 11];
+    loadHeader(bytes);
+    bytes[8] = SYSEX_TYPE_PROFILE;
+    uint8_t sum = 0;
+    for(uint16_t i = 0; i < PROFILE_SYSEX_DATA_SIZE; i++)
+        {
+        uint8_t d = (i < sizeof(struct _profileData) ? 
+            ((uint8_t*)(&profileData))[i] : 
+            ((uint8_t*)(&tickStats))[i - sizeof(struct _profileData)]);
+        bytes[9 + i * 2] = (uint8_t)((d >> 4) & 0xF);
+        bytes[9 + i * 2 + 1] = (uint8_t)(d & 0xF);
+        sum += bytes[9 + i * 2];
+        sum += bytes[9 + i * 2 + 1];
+        }
+    bytes[PROFILE_SYSEX_DATA_SIZE * 2 + 11 - 2] = (sum & 127);
+    bytes[PROFILE_SYSEX_DATA_SIZE * 2 + 11 - 1] = 0xF7;
+    flushMIDI();
+    MIDI.sendSysEx(PROFILE_SYSEX_DATA_SIZE * 2 + 11, bytes, true);
+    }
+
+
+// The labels for each section, in order
+GLOBAL static const uint8_t profileLabels[NUM_PROFILE_SECTIONS] PROGMEM =
+    { GLYPH_3x5_G, GLYPH_3x5_M, GLYPH_3x5_T, GLYPH_3x5_U, GLYPH_3x5_S, GLYPH_3x5_D };
+
+#define PROFILE_DISPLAY_HISTOGRAM               (NUM_PROFILE_SECTIONS * 3)
+#define PROFILE_DISPLAY_WORST_STATE             (PROFILE_DISPLAY_HISTOGRAM + NUM_PROFILE_BUCKETS)
+#define PROFILE_DISPLAY_WORST_STATE_TIME        (PROFILE_DISPLAY_WORST_STATE + 1)
+#define PROFILE_DISPLAY_WORST_ENTRY             (PROFILE_DISPLAY_WORST_STATE_TIME + 1)
+#define PROFILE_DISPLAY_WORST_ENTRY_TIME        (PROFILE_DISPLAY_WORST_ENTRY + 1)
+#define PROFILE_DISPLAY_TICKS                   (PROFILE_DISPLAY_WORST_ENTRY_TIME + 1)
+#define PROFILE_DISPLAY_MIDI_OUT_DEPTH          (PROFILE_DISPLAY_TICKS + 6)
+#define PROFILE_DISPLAY_MIDI_OUT_DROPPED        (PROFILE_DISPLAY_MIDI_OUT_DEPTH + 1)
+#define PROFILE_DISPLAY_LED_BYTES_SAVED         (PROFILE_DISPLAY_MIDI_OUT_DROPPED + 1)
+#define NUM_PROFILE_DISPLAY_ITEMS               (PROFILE_DISPLAY_LED_BYTES_SAVED + 1)
+
+// The labels for each of the tick statistics, in the order they appear in struct _tickStats
+GLOBAL static const uint8_t tickStatsLabels[6] PROGMEM =
+    { GLYPH_3x5_L, GLYPH_3x5_X, GLYPH_3x5_P, GLYPH_3x5_Q, GLYPH_3x5_R, GLYPH_3x5_F };
+
+void stateProfile()
+    {
+    if (entry)
+        {
+        entry = false;
+        }
+
+    if (isUpdated(BACK_BUTTON, RELEASED))
+        {
+        goUpState(STATE_OPTIONS);
+        return;
+        }
+    else if (isUpdated(SELECT_BUTTON, RELEASED))
+        {
+        resetProfile();
+        resetTickStats();
+        midiOutMaxDepth = 0;
+        midiOutDropped = 0;
+        ledBytesSaved = 0;
+        }
+    else if (isUpdated(MIDDLE_BUTTON, RELEASED))
+        {
+        sendProfileSysex();
+        }
+
+    if (updateDisplay)
+        {
+        uint8_t item = (uint8_t)(((uint32_t)pot[LEFT_POT] * NUM_PROFILE_DISPLAY_ITEMS) >> 10);
+        uint16_t val = 0;
+        uint8_t label;
+
+        clearScreen();
+        if (item < PROFILE_DISPLAY_HISTOGRAM)
+            {
+            struct _profile* p = &profileData.section[item / 3];
+            label = pgm_read_byte(&profileLabels[item / 3]);
+            switch(item % 3)
+                {
+                case 0: val = (p->count == 0 ? 0 : p->min); break;
+                case 1: val = (p->count == 0 ? 0 : p->total / p->count); break;
+                case 2: val = p->max; break;
+                }
+            drawRange(led2, 0, 0, 3, item % 3);
+            }
+        else if (item < PROFILE_DISPLAY_WORST_STATE)
+            {
+            label = GLYPH_3x5_H;
+            val = profileData.histogram[item - PROFILE_DISPLAY_HISTOGRAM];
+            drawRange(led2, 0, 0, NUM_PROFILE_BUCKETS, item - PROFILE_DISPLAY_HISTOGRAM);
+            }
+        else if (item == PROFILE_DISPLAY_MIDI_OUT_DEPTH)
+            {
+            label = GLYPH_3x5_O;
+            val = midiOutMaxDepth;
+            }
+        else if (item == PROFILE_DISPLAY_MIDI_OUT_DROPPED)
+            {
+            label = GLYPH_3x5_V;
+            val = (midiOutDropped > 19999 ? 19999 : midiOutDropped);
+            }
+        else if (item == PROFILE_DISPLAY_LED_BYTES_SAVED)
+            {
+            label = GLYPH_3x5_B;
+            uint32_t t = ledBytesSaved >> 10;           // shown in KB
+            val = (t > 19999 ? 19999 : t);
+            }
+        else if (item >= PROFILE_DISPLAY_WORST_ENTRY && item < PROFILE_DISPLAY_TICKS)
+            {
+            label = GLYPH_3x5_E;
+            if (profileData.worstEntryState != STATE_NONE)
+                {
+                if (item == PROFILE_DISPLAY_WORST_ENTRY)
+                    val = profileData.worstEntryState;
+                else
+                    val = ((uint16_t)profileData.entryMax) << PROFILE_STATE_SHIFT;
+                }
+            drawRange(led2, 0, 0, 2, item - PROFILE_DISPLAY_WORST_ENTRY);
+            }
+        else if (item >= PROFILE_DISPLAY_TICKS)
+            {
+            label = pgm_read_byte(&tickStatsLabels[item - PROFILE_DISPLAY_TICKS]);
+            uint32_t t = ((uint32_t*)(&tickStats))[item - PROFILE_DISPLAY_TICKS];
+            if (item == PROFILE_DISPLAY_MIDI_OUT_DEPTH - 1)
+                t = (tickStats.drift < 0 ? 0 : t);          // we only show drift behind micros()
+            if (item >= PROFILE_DISPLAY_MIDI_OUT_DEPTH - 2)
+                t = t >> 10;                // dropped time and drift are shown in (roughly) milliseconds
+            val = (t > 19999 ? 19999 : t);
+            }
+        else
+            {
+            label = GLYPH_3x5_W;
+            if (profileData.worstState != STATE_NONE)
+                {
+                if (item == PROFILE_DISPLAY_WORST_STATE)
+                    val = profileData.worstState;
+                else
+                    val = ((uint16_t)profileData.stateMax[profileData.worstState]) << PROFILE_STATE_SHIFT;
+                }
+            drawRange(led2, 0, 0, 2, item - PROFILE_DISPLAY_WORST_STATE);
+            }
+
+        writeNumber(led, led2, val > 19999 ? 19999 : val);
+        // the label overwrites the thousands digit, like secondGlyph does in doNumericalDisplay
+        write3x5Glyph(led2, label, 0);
+        }
+    }
+
+#endif INCLUDE_PROFILER
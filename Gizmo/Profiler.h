@@ -0,0 +1,85 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+
+////// PROFILER
+//////
+////// Profiler.h/.cpp time each iteration of go(), and the major pieces of it, against
+////// the TARGET_TICK_TIMESTEP budget of 320 microseconds.  This is only compiled in if
+////// INCLUDE_PROFILER is defined (see All.h), since calling micros() a dozen
+////// times a tick isn't free.
+//////
+////// For each SECTION we keep the minimum, maximum, and average time in microseconds.
+////// We also keep a histogram of go() times, and the worst time seen in each state.
+////// You can look at all of this by selecting the "GIZMO V6..." item at the bottom of
+////// the Options menu.  The left knob scrolls through the statistics:
+//////
+////// G M T U S D     go(), readMIDI(), updateTimers(), update(), the state's case in
+//////                 go(), and sendMatrix().  Each has a MIN, AVG, and MAX entry, indicated
+//////                 by a dot on the bottom row.
+////// H               Histogram buckets, each PROFILE_BUCKET_WIDTH microseconds wide.
+//////                 The last bucket (the far right dot) counts overruns.
+////// W               The state whose case in go() has taken the longest, then its time.
+////// E               The state whose FIRST tick (when it's entered, and usually does its
+//////                 setting up) has taken the longest, then its time.  This is how long
+//////                 moving from one state to another can take.
+////// L X P Q R F     The tick statistics in Timing.h: late ticks, worst tick lateness,
+//////                 late pulses, worst pulse lateness, time dropped (in ms) 
+//////                 by the catch up policy, and how far the ticks have drifted behind
+//////                 micros() (in ms).
+////// O V           The deepest the outgoing MIDI queue has been, and how many messages it has dropped.
+////// B               How many KB sendMatrix() has kept off the I2C bus by only sending changed rows.
+//////
+////// Pressing SELECT resets the statistics.  Pressing MIDDLE dumps them as sysex.
+////// Pressing BACK returns to the Options menu.
+
+
+#define PROFILE_GO                      0
+#define PROFILE_MIDI_READ               1
+#define PROFILE_UPDATE_TIMERS           2
+#define PROFILE_UPDATE                  3
+#define PROFILE_STATE                   4
+#define PROFILE_SEND_MATRIX             5
+#define NUM_PROFILE_SECTIONS            6
+
+#ifdef INCLUDE_PROFILER
+
+// Declare a timer called 'var' and start it
+#define PROFILE_START(var) uint32_t var = micros()
+// Stop the timer 'var' and record its time under the given section
+#define PROFILE_STOP(var, section) profileRecord(section, micros() - (var))
+// Stop the timer 'var' and record its time as that of the state case in go() for the given state,
+// noting whether this was the state's first tick
+#define PROFILE_STOP_STATE(var, st, en) profileRecordState(st, en, micros() - (var))
+
+#else
+
+#define PROFILE_START(var)
+#define PROFILE_STOP(var, section)
+#define PROFILE_STOP_STATE(var, st, en)
+
+#endif INCLUDE_PROFILER
+
+
+// Records a time (in microseconds) for the given section
+void profileRecord(uint8_t section, uint32_t time);
+
+// Records a time (in microseconds) for the given state's case in go().  If entered is true,
+// this was the first tick in the state.
+void profileRecordState(uint8_t st, uint8_t entered, uint32_t time);
+
+// Clears all the statistics
+void resetProfile();
+
+// Dumps the statistics as sysex.  Format:
+// 0xF0 0x7D G I Z M O [version] [SYSEX_TYPE_PROFILE] [nybblized _profileData then _tickStats, high nybble first] [checksum] 0xF7
+void sendProfileSysex();
+
+// Displays the statistics.  Called from STATE_OPTIONS_ABOUT.
+void stateProfile();
+
+#endif __PROFILER_H__
@@ -0,0 +1,44 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#include "All.h"
+
+
+GLOBAL static uint32_t randomState = 2463534242UL;           // Marsaglia's example seed
+
+
+void seedRandom(uint32_t seed)
+    {
+    // xorshift gets stuck at 0
+    randomState = (seed == 0 ? 2463534242UL : seed);
+    }
+
+uint16_t random16()
+    {
+    uint32_t x = randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState = x;
+    return (uint16_t)(x >> 16);
+    }
+
+uint16_t randomBelow(uint16_t n)
+    {
+    // Lemire, "Fast Random Integer Generation in an Interval", 2019.  The high
+    // 16 bits of random16() * n are our sample; the low 16 bits tell us if it
+    // fell in the little biased region at the bottom, in which case we try again.
+    uint32_t m = (uint32_t)random16() * n;
+    uint16_t low = (uint16_t) m;
+    if (low < n)
+        {
+        uint16_t threshold = ((uint16_t)(0 - n)) % n;               // 65536 mod n
+        while (low < threshold)
+            {
+            m = (uint32_t)random16() * n;
+            low = (uint16_t) m;
+            }
+        }
+    return (uint16_t)(m >> 16);
+    }
@@ -0,0 +1,41 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <Arduino.h>
+
+
+//// RANDOM NUMBERS
+////
+//// Arduino's random() is the C library's, which does 32-bit multiplies, divides, and
+//// modulos, all slow on the AVR, and random(min, max) does a further 32-bit modulo.
+//// Instead we use a 32-bit xorshift generator (Marsaglia 2003, shifts 13, 17, 5), which is
+//// just shifts and XORs, and has a period of 2^32 - 1.  We hand out its high 16 bits.
+////
+//// randomBelow(n) is unbiased: it uses Lemire's multiply-shift method, which only needs
+//// a (16-bit) modulo in the rare case that it has to reject a sample.
+////
+//// To test against a probability, compare random16() against one of the RANDOM_PROBABILITY
+//// thresholds below, which are the probability times 65536.
+
+#define RANDOM_PROBABILITY_1_8 (8192)
+#define RANDOM_PROBABILITY_1_4 (16384)
+#define RANDOM_PROBABILITY_1_2 (32768)
+#define RANDOM_PROBABILITY_3_4 (49152)
+
+// Seeds the generator.  The same seed always produces the same sequence.
+void seedRandom(uint32_t seed);
+
+// Returns a random number 0...65535
+uint16_t random16();
+
+// Returns a random number 0...n-1, without bias.  n must be > 0.
+uint16_t randomBelow(uint16_t n);
+
+// Returns a random number min...max-1, like Arduino's random(min, max).  max must be > min.
+#define RANDOM_RANGE(min, max) ((min) + randomBelow((max) - (min)))
+
+#endif __RANDOM_H__
@@ -33,6 +33,96 @@ void resetRecorder()
 #define LOAD_NOTE_OFF 128
 #define LOAD_NOTE_ON 0
 
+
+// Returns the time of the event at the given position in the buffer.
+// Time is stored in the low three bits of the first byte, plus the next entire byte
+static uint16_t recorderEventTime(uint16_t pos)
+    {
+    return (((uint16_t)((data.slot.data.recorder.buffer[pos]) & (4 + 2 + 1))) << 8) | 
+        data.slot.data.recorder.buffer[pos + 1];
+    }
+
+
+// Builds the measure index in local.recorder.  Called whenever the song is loaded or recorded.
+static void indexRecorder()
+    {
+    uint16_t pos = 0;
+    uint8_t notes = 0;
+    uint8_t measure = 0;
+    while(true)
+        {
+        // skip to the first event in this measure
+        while (pos < data.slot.data.recorder.length && recorderEventTime(pos) < measure * (uint16_t) 96)   // 96 pulses per measure
+            {
+            if (data.slot.data.recorder.buffer[pos] & LOAD_NOTE_OFF)
+                pos += RECORDER_SIZE_OF_NOTE_OFF;
+            else
+                {
+                pos += RECORDER_SIZE_OF_NOTE_ON;
+                notes++;
+                }
+            }
+        local.recorder.measureOffset[measure] = pos;
+        local.recorder.measureNotes[measure] = notes;
+                
+        // The song ends at the first measure boundary after its last event
+        if (pos >= data.slot.data.recorder.length || measure == MAXIMUM_RECORDER_MEASURES)
+            break;
+        measure++;
+        }
+    local.recorder.measures = measure;
+    }
+
+
+
+// Moves playback to where it'd be after POSITION pulses from the start
+void seekRecorder(uint32_t position)
+    {
+    if (state != STATE_RECORDER_PLAY || 
+        (local.recorder.status != RECORDER_PLAYING && local.recorder.status != RECORDER_STOPPED))
+        return;
+                
+    resetRecorder();
+    sendAllSoundsOff();
+    memset(local.recorder.notes, NO_NOTE, MAX_RECORDER_NOTES_PLAYING);
+        
+    // The song lasts through the pulse at its last measure boundary, then starts
+    // over (or stops) on the next pulse.  See stateRecorderPlay().
+    uint16_t songLength = local.recorder.measures * (uint16_t) 96 + 1;
+    if (position >= songLength)
+        {
+        if (!options.recorderRepeat)
+            {
+            local.recorder.status = RECORDER_STOPPED;
+            return;
+            }
+        position = position % songLength;
+        }
+    
+    // at 0 we're where Start would put us
+    if (position == 0)
+        return;
+        
+    // Jump to the measure, then go through its events up to the tick.  Notes which
+    // would be playing aren't restarted.
+    local.recorder.tick = (int16_t)(position - 1);
+    uint8_t measure = (uint8_t)(local.recorder.tick / 96);
+    local.recorder.bufferPos = local.recorder.measureOffset[measure];
+    local.recorder.currentPos = local.recorder.measureNotes[measure];
+    while (local.recorder.bufferPos < data.slot.data.recorder.length && 
+        recorderEventTime(local.recorder.bufferPos) <= local.recorder.tick)
+        {
+        if (data.slot.data.recorder.buffer[local.recorder.bufferPos] & LOAD_NOTE_OFF)
+            local.recorder.bufferPos += RECORDER_SIZE_OF_NOTE_OFF;
+        else
+            {
+            local.recorder.bufferPos += RECORDER_SIZE_OF_NOTE_ON;
+            local.recorder.currentPos++;
+            }
+        }
+    }
+
+
 // Private helper method for stateRecorderPlay() for packing notes for storage.
 // Packs a NOTE ON or NOTE OFF into the buffer.  If the note is a NOTE OFF, also
 // sends a NoteOFF message to MIDI, and clears the NoteOFF ID, making it available.
@@ -107,6 +197,7 @@ void stateRecorderPlay()
             data.slot.data.recorder.length = 0;
             local.recorder.numNotes = 0;
             }
+        indexRecorder();
         entry = false;
         }
                 
@@ -178,10 +269,7 @@ void stateRecorderPlay()
             // we could have a number of items stored for this tick
             while ((local.recorder.bufferPos < data.slot.data.recorder.length) &&
                     (local.recorder.tick >=  // just in case we're below the tick but not equal to it.
-                    // time is stored in the low three bits of the first byte, plus the
-                    // next entire byte
-                        ((((uint16_t)((data.slot.data.recorder.buffer[local.recorder.bufferPos]) & (4 + 2 + 1))) << 8) | 
-                        data.slot.data.recorder.buffer[local.recorder.bufferPos + 1])))  /// ... the next note time
+                    recorderEventTime(local.recorder.bufferPos)))  /// ... the next note time
                 {
                 // id is in bytes 3, 4, 5, 6 of the first byte
                 uint8_t id = (data.slot.data.recorder.buffer[local.recorder.bufferPos] & (64 + 32 + 16 + 8)) >> 3;
@@ -189,8 +277,9 @@ void stateRecorderPlay()
                 // NOTE OFF is indicated by a 1 in the high bit of the first byte
                 if (data.slot.data.recorder.buffer[local.recorder.bufferPos] & LOAD_NOTE_OFF)
                     {
-                    // NOTE OFF
-                    sendNoteOff(local.recorder.notes[id], 127, options.channelOut);
+                    // NOTE OFF.  The note might not be playing if we've just seeked past its NOTE ON.
+                    if (local.recorder.notes[id] != NO_NOTE)
+                        sendNoteOff(local.recorder.notes[id], 127, options.channelOut);
                     local.recorder.bufferPos += 2;
                     local.recorder.notes[id] = NO_NOTE;
                     }
@@ -329,6 +418,8 @@ void stateRecorderPlay()
 
     if (ended)
         {
+        if (local.recorder.status == RECORDER_RECORDING)
+            indexRecorder();
         resetRecorder();
         sendAllSoundsOff();
         if (ended == ENDED)
@@ -96,6 +96,9 @@
 #define RECORDER_RECORDING 2
 #define RECORDER_TICKING_OFF 3
 
+// The recorder holds at most 21 measures (see above)
+#define MAXIMUM_RECORDER_MEASURES (21)
+
 // LOCAL
 
 struct _recorderLocal
@@ -121,6 +124,14 @@ struct _recorderLocal
     
     // Number of notes recorded so far
     uint8_t numNotes;
+    
+    // The MEASURE INDEX, for seeking.  For each measure, where its first event is in the buffer,
+    // and how many NOTE ONs come before it.  Built by indexRecorder().
+    uint16_t measureOffset[MAXIMUM_RECORDER_MEASURES + 1];
+    uint8_t measureNotes[MAXIMUM_RECORDER_MEASURES + 1];
+    
+    // How many measures the song plays before it ends (or repeats)
+    uint8_t measures;
     };
 
 
@@ -148,6 +159,10 @@ void stateRecorderPlay();
 /// Resets the recorder entirely.  Called on MIDI Start etc.
 void resetRecorder();
 
+/// Moves playback to where it'd be after POSITION pulses from the start.  See setSongPosition().
+/// Uses the measure index to jump to the right measure without going through the events before it.
+void seekRecorder(uint32_t position);
+
 
 // This is a dummy function which does nothing at all, because we can't presently
 // play in the background.  But it's included because if we DON'T have it, then
@@ -0,0 +1,186 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#include "All.h"
+
+
+#define NO_NOTE_OFF             255             // marks the end of a list
+
+// The entries.  An entry whose note is NO_NOTE has nothing pending and isn't in any slot.
+// Entries 0 ... noteOffsReserved - 1 have been reserved, and the rest are for NOTE_OFF_ANY.
+GLOBAL static uint8_t noteOffNote[NUM_NOTE_OFFS];
+GLOBAL static uint8_t noteOffChannel[NUM_NOTE_OFFS];
+GLOBAL static uint16_t noteOffBucket[NUM_NOTE_OFFS];           // the bucket in which the note off is processed (see Scheduler.h)
+GLOBAL static uint8_t noteOffNext[NUM_NOTE_OFFS];              // the next entry in the same slot
+GLOBAL static uint8_t noteOffsReserved;
+
+GLOBAL static uint8_t noteOffSlots[NUM_NOTE_OFF_SLOTS];        // the first entry in each slot
+GLOBAL static uint16_t noteOffNextBucket;                      // the next bucket to be processed by updateScheduledNoteOffs()
+
+
+void resetScheduledNoteOffs()
+    {
+    memset(noteOffNote, NO_NOTE, NUM_NOTE_OFFS);
+    memset(noteOffSlots, NO_NOTE_OFF, NUM_NOTE_OFF_SLOTS);
+    noteOffNextBucket = (uint16_t)(currentTime >> NOTE_OFF_BUCKET_SHIFT);
+    noteOffsReserved = 0;
+    }
+
+
+uint8_t reserveNoteOffs(uint8_t count)
+    {
+    if (count > NUM_NOTE_OFFS - noteOffsReserved)
+        return NOTE_OFF_ANY;
+    uint8_t first = noteOffsReserved;
+    noteOffsReserved += count;
+    return first;
+    }
+
+
+// Takes a pending entry out of its slot.  The entry's slot is given by its bucket.
+static void unlinkNoteOff(uint8_t entry)
+    {
+    uint8_t slot = noteOffBucket[entry] & (NUM_NOTE_OFF_SLOTS - 1);
+    uint8_t i = noteOffSlots[slot];
+    if (i == entry)
+        {
+        noteOffSlots[slot] = noteOffNext[entry];
+        }
+    else
+        {
+        while(noteOffNext[i] != entry)
+            i = noteOffNext[i];
+        noteOffNext[i] = noteOffNext[entry];
+        }
+    noteOffNote[entry] = NO_NOTE;
+    }
+
+
+// Returns a free unreserved entry for NOTE_OFF_ANY.  If there isn't one, sends the note off
+// in the one which is due soonest to free it up.  If there are no unreserved entries at all,
+// returns NOTE_OFF_ANY.
+static uint8_t findFreeNoteOff()
+    {
+    uint8_t soonest = NOTE_OFF_ANY;
+    for(uint8_t i = noteOffsReserved; i < NUM_NOTE_OFFS; i++)
+        {
+        if (noteOffNote[i] == NO_NOTE)
+            return i;
+        if (soonest == NOTE_OFF_ANY || 
+            (int16_t)(noteOffBucket[i] - noteOffNextBucket) < (int16_t)(noteOffBucket[soonest] - noteOffNextBucket))
+            soonest = i;
+        }
+    if (soonest != NOTE_OFF_ANY)
+        {
+        sendNoteOff(noteOffNote[soonest], 127, noteOffChannel[soonest]);
+        unlinkNoteOff(soonest);
+        }
+    return soonest;
+    }
+
+
+void scheduleNoteOff(uint8_t entry, uint8_t note, uint8_t channel, uint32_t time)
+    {
+    if (entry == NOTE_OFF_ANY)
+        {
+        entry = findFreeNoteOff();
+        if (entry == NOTE_OFF_ANY)
+            {
+            // nowhere to put it
+            sendNoteOff(note, 127, channel);
+            return;
+            }
+        }
+    else if (noteOffNote[entry] != NO_NOTE)
+        {
+        // the last one hasn't gone out yet.  A short note is better than a stuck one.
+        sendNoteOff(noteOffNote[entry], 127, noteOffChannel[entry]);
+        unlinkNoteOff(entry);
+        }
+
+    uint32_t delay = time - currentTime;
+    if (delay > NOTE_OFF_MAX_DELAY)     // includes times in the past, which wrap around to huge delays
+        delay = (TIME_GREATER_THAN(currentTime, time) ? 0 : NOTE_OFF_MAX_DELAY);
+    // round up, so the note off is never sent early
+    uint16_t bucket = (uint16_t)((currentTime + delay + NOTE_OFF_BUCKET_WIDTH - 1) >> NOTE_OFF_BUCKET_SHIFT);
+
+    // If the bucket has already been processed, put it in the next one to be processed.
+    // It's still due, so it'll go out then.
+    if ((int16_t)(noteOffNextBucket - bucket) > 0)
+        bucket = noteOffNextBucket;
+
+    uint8_t slot = bucket & (NUM_NOTE_OFF_SLOTS - 1);
+    noteOffNote[entry] = note;
+    noteOffChannel[entry] = channel;
+    noteOffBucket[entry] = bucket;
+    noteOffNext[entry] = noteOffSlots[slot];
+    noteOffSlots[slot] = entry;
+    }
+
+
+uint8_t cancelNoteOff(uint8_t entry)
+    {
+    if (entry == NOTE_OFF_ANY || noteOffNote[entry] == NO_NOTE)
+        return false;
+    unlinkNoteOff(entry);
+    return true;
+    }
+
+
+void sendScheduledNoteOffs()
+    {
+    for(uint8_t i = 0; i < NUM_NOTE_OFFS; i++)
+        {
+        if (noteOffNote[i] != NO_NOTE)
+            {
+            sendNoteOff(noteOffNote[i], 127, noteOffChannel[i]);
+            noteOffNote[i] = NO_NOTE;
+            }
+        }
+    memset(noteOffSlots, NO_NOTE_OFF, NUM_NOTE_OFF_SLOTS);
+    }
+
+
+// Sends and unlinks the due entries in the given slot
+static void updateNoteOffSlot(uint8_t slot, uint16_t bucket)
+    {
+    uint8_t prev = NO_NOTE_OFF;
+    uint8_t i = noteOffSlots[slot];
+    while(i != NO_NOTE_OFF)
+        {
+        uint8_t next = noteOffNext[i];
+        if ((int16_t)(bucket - noteOffBucket[i]) >= 0)
+            {
+            sendNoteOff(noteOffNote[i], 127, noteOffChannel[i]);
+            noteOffNote[i] = NO_NOTE;
+
+            // unlink
+            if (prev == NO_NOTE_OFF)
+                noteOffSlots[slot] = next;
+            else
+                noteOffNext[prev] = next;
+            }
+        else
+            {
+            prev = i;
+            }
+        i = next;
+        }
+    }
+
+
+void updateScheduledNoteOffs()
+    {
+    uint16_t currentBucket = (uint16_t)(currentTime >> NOTE_OFF_BUCKET_SHIFT);
+
+    // If we've fallen more than a full turn of the wheel behind, one turn covers everything
+    if ((int16_t)(currentBucket - noteOffNextBucket) >= NUM_NOTE_OFF_SLOTS)
+        noteOffNextBucket = currentBucket - (NUM_NOTE_OFF_SLOTS - 1);
+
+    while((int16_t)(currentBucket - noteOffNextBucket) >= 0)
+        {
+        updateNoteOffSlot(noteOffNextBucket & (NUM_NOTE_OFF_SLOTS - 1), currentBucket);
+        noteOffNextBucket++;
+        }
+    }
@@ -0,0 +1,86 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+
+////// SCHEDULER
+//////
+////// Scheduler.h/.cpp hold note offs which are to be sent at some time in the future.  Rather than
+////// keep its own array of off times and scan it every tick, an application calls
+////// scheduleNoteOff(entry, note, channel, time) and forgets about it: go() calls updateScheduledNoteOffs()
+////// every tick, which sends the note off once currentTime reaches the given time.  Note offs are
+////// sent with sendNoteOff(note, 127, channel), just as the applications used to.
+//////
+////// Note offs are held in ENTRIES from a pool of NUM_NOTE_OFFS.  There are two ways to use them:
+//////
+////// - An application which needs to take back a note off it scheduled (say, when a note is tied
+//////   over) reserves a range of entries once, in setup(), with reserveNoteOffs(count), and then
+//////   owns them: the step sequencer has one per track, and the click one.  Each entry only ever
+//////   has one note off pending, so cancelNoteOff(entry) can only take back that owner's own note
+//////   off, never another's which happens to be for the same note and channel.  Scheduling an entry
+//////   which is still pending sends its old note off first.
+//////
+////// - Anything else, for as many notes at once as it likes, schedules with the entry NOTE_OFF_ANY.
+//////   This takes whichever of the entries nobody reserved is free, and gives it back once the note
+//////   off has gone out.  Such a note off can't be cancelled.
+//////
+////// If the pool is full, reserveNoteOffs() returns NOTE_OFF_ANY, and the owner's note offs are then
+////// scheduled as NOTE_OFF_ANY ones (see NOTE_OFF_ENTRY), which it can't cancel.  If NOTE_OFF_ANY
+////// finds no free entry, the one of them which is due soonest is sent now to make room: a short
+////// note is better than a stuck one.  If nobody's left any entries unreserved at all, the new
+////// note off is sent now.
+//////
+////// The scheduled note offs are kept in a hashed timer wheel.  Time is cut into BUCKETS of
+////// NOTE_OFF_BUCKET_WIDTH microseconds, and each note off goes in the list for its bucket modulo
+////// NUM_NOTE_OFF_SLOTS.  Each tick we only look at the slots whose buckets have come due since the
+////// last tick, and only send the note offs in them which are actually due (a note off further in the
+////// future waits in its slot for the wheel to come round again).  So the cost per tick doesn't
+////// grow with the number of tracks or notes.  Note offs are sent at most one bucket late.
+//////
+////// A note off can't be scheduled more than NOTE_OFF_MAX_DELAY in the future: if you try, it's
+////// scheduled at NOTE_OFF_MAX_DELAY instead.
+
+#define NOTE_OFF_BUCKET_SHIFT           9                               // 512 microseconds
+#define NOTE_OFF_BUCKET_WIDTH           (1 << NOTE_OFF_BUCKET_SHIFT)
+#define NOTE_OFF_MAX_DELAY              (((uint32_t) 32767) << NOTE_OFF_BUCKET_SHIFT)   // about 16 seconds
+
+#if defined(__MEGA__)
+#define NUM_NOTE_OFF_SLOTS              32                              // must be a power of 2
+#define NUM_NOTE_OFFS                   32                              // no more than 254
+#else
+#define NUM_NOTE_OFF_SLOTS              16                              // must be a power of 2
+#define NUM_NOTE_OFFS                   16                              // no more than 254
+#endif
+
+// Schedule with this entry to use any free entry, or returned by reserveNoteOffs() when it can't
+#define NOTE_OFF_ANY                    255
+
+// Entry i of the COUNT reserved at FIRST, or NOTE_OFF_ANY if they couldn't be reserved
+#define NOTE_OFF_ENTRY(first, i)        ((first) == NOTE_OFF_ANY ? NOTE_OFF_ANY : (uint8_t)((first) + (i)))
+
+// Clears out all the scheduled note offs without sending them, and all the reservations.  Called by setup().
+void resetScheduledNoteOffs();
+
+// Reserves COUNT entries for one owner, and returns the first of them.  Returns NOTE_OFF_ANY
+// if there aren't that many left.  Called by setup().
+uint8_t reserveNoteOffs(uint8_t count);
+
+// Schedules a note off for the given note and channel at the given time (in the same units as currentTime)
+// in the given entry, or in any free one if the entry is NOTE_OFF_ANY.  If a reserved entry already has
+// a note off pending, it's sent now.
+void scheduleNoteOff(uint8_t entry, uint8_t note, uint8_t channel, uint32_t time);
+
+// Removes the note off scheduled in the given reserved entry without sending it.
+// Returns true if there was one (that is, if it hadn't been sent yet).  Always false for NOTE_OFF_ANY.
+uint8_t cancelNoteOff(uint8_t entry);
+
+// Sends all the scheduled note offs now
+void sendScheduledNoteOffs();
+
+// Sends any scheduled note offs that have come due.  Called every tick by go().
+void updateScheduledNoteOffs();
+
+#endif __SCHEDULER_H__
@@ -12,6 +12,8 @@ GLOBAL uint8_t _trackLength[4] = { 16, 24, 32, 64 };
 // Used by GET_NUM_TRACKS to return the number of tracks in the current format
 //GLOBAL uint8_t _numTracks[5] = { 12, 8, 6, 4, 3 };
 GLOBAL uint8_t _numTracks[4] = { 12, 8, 6, 3 };
+// The first of the note off entries reserved for the tracks, one each (see Scheduler.h)
+GLOBAL uint8_t stepSequencerNoteOffs;
 
 
 
@@ -27,14 +29,14 @@ void stateStepSequencerMenuEditMark()
 
 void stateStepSequencerMenuEditDuplicate()
     {
+    // The mark track's playing note, and its scheduled note off, stay with the mark track
+    clearNoteOnTrack(local.stepSequencer.currentTrack);
     local.stepSequencer.data[local.stepSequencer.currentTrack] = local.stepSequencer.data[local.stepSequencer.markTrack];
     local.stepSequencer.outMIDI[local.stepSequencer.currentTrack] = local.stepSequencer.outMIDI[local.stepSequencer.markTrack];
     local.stepSequencer.noteLength[local.stepSequencer.currentTrack] = local.stepSequencer.noteLength[local.stepSequencer.markTrack];
     local.stepSequencer.muted[local.stepSequencer.currentTrack] = local.stepSequencer.muted[local.stepSequencer.markTrack];
     local.stepSequencer.velocity[local.stepSequencer.currentTrack] = local.stepSequencer.velocity[local.stepSequencer.markTrack];
     local.stepSequencer.fader[local.stepSequencer.currentTrack] = local.stepSequencer.fader[local.stepSequencer.markTrack];
-    local.stepSequencer.offTime[local.stepSequencer.currentTrack] = local.stepSequencer.offTime[local.stepSequencer.markTrack];
-    local.stepSequencer.noteOff[local.stepSequencer.currentTrack] = local.stepSequencer.noteOff[local.stepSequencer.markTrack];
     local.stepSequencer.shouldPlay[local.stepSequencer.currentTrack] = local.stepSequencer.shouldPlay[local.stepSequencer.markTrack];
     local.stepSequencer.transposable[local.stepSequencer.currentTrack] = local.stepSequencer.transposable[local.stepSequencer.markTrack];
     local.stepSequencer.pattern[local.stepSequencer.currentTrack] = local.stepSequencer.pattern[local.stepSequencer.markTrack];
@@ -328,9 +330,9 @@ void stateStepSequencerMenuPerformanceRepeat()
         
 void stateStepSequencerMenuPerformanceNext()
     {
-    // The values are OFF, 0, 1, ..., 8
-    // These correspond with stored values (in the high 4 bits of repeat) of 0...9
-    uint8_t result = doNumericalDisplay(-1, 8, ((int16_t)(data.slot.data.stepSequencer.repeat >> 4)) - 1, true, GLYPH_NONE);
+    // The values are OFF, 0, 1, ..., NUM_SLOTS - 1
+    // These correspond with stored values (in the high 4 bits of repeat) of 0...NUM_SLOTS
+    uint8_t result = doNumericalDisplay(-1, NUM_SLOTS - 1, ((int16_t)(data.slot.data.stepSequencer.repeat >> 4)) - 1, true, GLYPH_NONE);
     playStepSequencer();
     switch (result)
         {
@@ -421,11 +423,13 @@ void clearNoteOnTrack(uint8_t track)
     if (local.stepSequencer.noteOff[track] < NO_NOTE) 
         {
         uint8_t out = (local.stepSequencer.outMIDI[track] == MIDI_OUT_DEFAULT ? options.channelOut : local.stepSequencer.outMIDI[track]);
-        if (out != NO_MIDI_OUT)
+        // If the note is tied it's still playing.  Otherwise it's still playing only if its scheduled note off hasn't gone out yet.
+        if (out != NO_MIDI_OUT && (local.stepSequencer.tied[track] || cancelNoteOff(NOTE_OFF_ENTRY(stepSequencerNoteOffs, track))))
             {
             sendNoteOff(local.stepSequencer.noteOff[track], 127, out);
             }
         local.stepSequencer.noteOff[track] = NO_NOTE;
+        local.stepSequencer.tied[track] = false;
         }
     }
 
@@ -443,7 +447,7 @@ void loadSequence(uint8_t slot)
         }
     else
         {
-        loadSlot(slot);
+        loadPrefetchedSlot(slot);
 
         // FIXME: did I fix the issue of synchronizing the beats with the sequencer notes?
         //local.stepSequencer.currentPlayPosition = 
@@ -524,7 +528,7 @@ void resetTrack(uint8_t track)
     local.stepSequencer.muted[track] = STEP_SEQUENCER_NOT_MUTED;
     local.stepSequencer.velocity[track] = STEP_SEQUENCER_NO_OVERRIDE_VELOCITY;
     local.stepSequencer.fader[track] = FADER_IDENTITY_VALUE;
-    local.stepSequencer.offTime[track] = 0;
+    local.stepSequencer.tied[track] = false;
     local.stepSequencer.noteOff[track] = NO_NOTE;
     }
 
@@ -1099,8 +1103,8 @@ void stateStepSequencerPlay()
             int16_t newPos = getNewCursorXPos(trackLen);
             if (lockoutPots ||      // using an external NRPN device, which is likely accurate
                 local.stepSequencer.currentRightPot == -1 ||   // nobody's been entering data
-                local.stepSequencer.currentRightPot >= newPos && local.stepSequencer.currentRightPot - newPos >= 2 ||
-                local.stepSequencer.currentRightPot < newPos && newPos - local.stepSequencer.currentRightPot >= 2)
+                (local.stepSequencer.currentRightPot >= newPos && local.stepSequencer.currentRightPot - newPos >= 2) ||
+                (local.stepSequencer.currentRightPot < newPos && newPos - local.stepSequencer.currentRightPot >= 2))
                 {
                 local.stepSequencer.currentEditPosition = newPos;
                                 
@@ -1230,7 +1234,7 @@ local.stepSequencer.clearTrack = DONT_CLEAR_TRACK;
   {
   // clear track and notes
   memset(data.slot.data.stepSequencer.buffer + ((uint16_t)trackLen) * local.stepSequencer.currentTrack * 2, 0, trackLen * 2);
-  clearNotesOnTracks(true);
+  clearNotesOnTracks();
   local.stepSequencer.clearTrack = DONT_CLEAR_TRACK;
   }
 */
@@ -1916,38 +1920,127 @@ void stateStepSequencerMenuTypeParameter()
 #endif INCLUDE_ADVANCED_STEP_SEQUENCER
 
 
-// Turns off all notes
-void clearNotesOnTracks(uint8_t clearEvenIfNoteNotFinished)
+// Returns whether the step after the current play position on the given track is a tie
+static uint8_t nextStepIsTie(uint8_t track)
     {
-    uint8_t numTracks = GET_NUM_TRACKS();
     uint8_t trackLen = GET_TRACK_LENGTH();
+    uint8_t nextPos = local.stepSequencer.currentPlayPosition + 1;       // next position
+    if (nextPos >= trackLen) nextPos = 0;                                                     // wrap around
+    uint16_t pos = (track * (uint16_t) trackLen + nextPos) * 2;
+    uint8_t vel = data.slot.data.stepSequencer.buffer[pos + 1];
+    uint8_t note = data.slot.data.stepSequencer.buffer[pos];
+    return ((vel == 0) && (note == 1));
+    }
+
+// Schedules the note off for the note playing on the given track, unless the next step
+// is a tie, in which case we hold the note instead.
+static void releaseNoteOnTrack(uint8_t track, uint8_t noteLength)
+    {
+    if (nextStepIsTie(track))
+        {
+        local.stepSequencer.tied[track] = true;
+        }
+    else
+        {
+        uint8_t out = (local.stepSequencer.outMIDI[track] == MIDI_OUT_DEFAULT ? options.channelOut : local.stepSequencer.outMIDI[track]);
+        if (out != NO_MIDI_OUT)
+            {
+            scheduleNoteOff(NOTE_OFF_ENTRY(stepSequencerNoteOffs, track), local.stepSequencer.noteOff[track], out, currentTime + (div100(notePulseRate * getMicrosecsPerPulse() * noteLength)));
+            }
+        local.stepSequencer.tied[track] = false;
+        }
+    }
+
+// Turns off all notes (except ones about to be continued by a tie).  Note offs which come due
+// before the end of a step are sent by the scheduler (see Scheduler.h).
+void clearNotesOnTracks()
+    {
+    uint8_t numTracks = GET_NUM_TRACKS();
     for(uint8_t track = 0; track < numTracks; track++)
         {
         // clearNotesOnTracks is called BEFORE the current play position is incremented.
         // So we need to check the NEXT note to determine if it's a tie.  If it is,
         // then we don't want to stop playing
+        if (!nextStepIsTie(track))
+            {
+            clearNoteOnTrack(track);
+            }
+        }
+    }
 
-        uint8_t currentPos = local.stepSequencer.currentPlayPosition + 1;       // next position
-        if (currentPos >= trackLen) currentPos = 0;                                                     // wrap around
-        uint16_t pos = (track * (uint16_t) trackLen + currentPos) * 2;
-        uint8_t vel = data.slot.data.stepSequencer.buffer[pos + 1];
-        uint8_t note = data.slot.data.stepSequencer.buffer[pos];
-        
-        if (local.stepSequencer.noteOff[track] < NO_NOTE &&             // there's something to turn off
-            //(clearEvenIfNoteNotFinished || (currentTime >= local.stepSequencer.offTime[track])) &&  // it's time to clear the note
-            (clearEvenIfNoteNotFinished || (TIME_GREATER_THAN_OR_EQUAL(currentTime, local.stepSequencer.offTime[track]))) &&  // it's time to clear the note
-            (!((vel == 0) && (note == 1))))                                     // not a tie
+// Decides which tracks play this time through the sequence, according to their patterns
+// and local.stepSequencer.countup.  Called at position 0.
+static void chooseStepSequencerPatterns(uint8_t numTracks)
+    {
+    // pick an exclusive random track
+    uint8_t exclusiveTrack = 0;
+    int trkcount = 0;
+    for(uint8_t track = 0; track < numTracks; track++)
+        {
+        if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
             {
-            uint8_t out = (local.stepSequencer.outMIDI[track] == MIDI_OUT_DEFAULT ? options.channelOut : local.stepSequencer.outMIDI[track]);
-            if (out != NO_MIDI_OUT)
+            if ((trkcount == 0) || (randomBelow(trkcount + 1) == 0))  // this could work without the trakcount == 0 but I save a call to randomBelow() here 
                 {
-                sendNoteOff(local.stepSequencer.noteOff[track], 127, out);
+                exclusiveTrack = track;
                 }
-            local.stepSequencer.noteOff[track] = NO_NOTE;
+            trkcount++;
+            }
+        }
+
+    for(uint8_t track = 0; track < numTracks; track++)
+        {
+        // pick a random track                          
+        if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
+            {
+            local.stepSequencer.shouldPlay[track] = (track == exclusiveTrack);
+            }
+        else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_3_4)
+            {
+            local.stepSequencer.shouldPlay[track] = (random16() < RANDOM_PROBABILITY_3_4);
             }
+        else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_1_2)
+            {
+            local.stepSequencer.shouldPlay[track] = (random16() < RANDOM_PROBABILITY_1_2);
+            }
+        else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_1_4)
+            {
+            local.stepSequencer.shouldPlay[track] = (random16() < RANDOM_PROBABILITY_1_4);
+            }
+        else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_1_8)
+            {
+            local.stepSequencer.shouldPlay[track] = (random16() < RANDOM_PROBABILITY_1_8);
+            }
+        else
+            {
+            local.stepSequencer.shouldPlay[track] = ((local.stepSequencer.pattern[track] >> (local.stepSequencer.countup & 3)) & 1);                        
+            }
+                                        
+        if (!local.stepSequencer.shouldPlay[track]) 
+            clearNoteOnTrack(track);
         }
     }
 
+// Makes the mute and solo changes scheduled for the start of the sequence.  Called at
+// position 0 in performance mode.
+static void changeScheduledMutes(uint8_t numTracks)
+    {
+    for(uint8_t track = 0; track < numTracks; track++)
+        {
+        if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_ON_SCHEDULED)
+            local.stepSequencer.muted[track] = STEP_SEQUENCER_MUTED;
+        else if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_OFF_SCHEDULED)
+            local.stepSequencer.muted[track] = STEP_SEQUENCER_NOT_MUTED;
+        else if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_ON_SCHEDULED_ONCE)
+            local.stepSequencer.muted[track] = STEP_SEQUENCER_MUTE_OFF_SCHEDULED;
+        else if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_OFF_SCHEDULED_ONCE)
+            local.stepSequencer.muted[track] = STEP_SEQUENCER_MUTE_ON_SCHEDULED;
+        }
+    if (local.stepSequencer.solo == STEP_SEQUENCER_SOLO_ON_SCHEDULED)
+        local.stepSequencer.solo = STEP_SEQUENCER_SOLO;
+    else if (local.stepSequencer.solo == STEP_SEQUENCER_SOLO_OFF_SCHEDULED)
+        local.stepSequencer.solo = STEP_SEQUENCER_NO_SOLO;
+    }
+
 // Plays the current sequence
 void playStepSequencer()
     {
@@ -1957,39 +2050,27 @@ void playStepSequencer()
     uint8_t trackLen = GET_TRACK_LENGTH();
     uint8_t numTracks = GET_NUM_TRACKS();
         
-    // Clear notes if necessary
-    clearNotesOnTracks(false);
-        
     if ((local.stepSequencer.playState == PLAY_STATE_WAITING) && beat)
         local.stepSequencer.playState = PLAY_STATE_PLAYING;
         
     if (notePulse && (local.stepSequencer.playState == PLAY_STATE_PLAYING))
         {
         // definitely clear everything
-        clearNotesOnTracks(true);
+        clearNotesOnTracks();
 
         uint8_t oldPlayPosition = local.stepSequencer.currentPlayPosition;
         local.stepSequencer.currentPlayPosition = incrementAndWrap(local.stepSequencer.currentPlayPosition, trackLen);
+
+#ifdef INCLUDE_PREFETCH_SEQUENCES
+        // get the next sequence ready ahead of time
+        if (local.stepSequencer.performanceMode && (data.slot.data.stepSequencer.repeat >> 4) != 0)
+            prefetchSlot((data.slot.data.stepSequencer.repeat >> 4) - 1);
+#endif INCLUDE_PREFETCH_SEQUENCES
         
         // change scheduled mute?
         if (local.stepSequencer.performanceMode && local.stepSequencer.currentPlayPosition == 0)
             {
-            for(uint8_t track = 0; track < numTracks; track++)
-                {
-                if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_ON_SCHEDULED)
-                    local.stepSequencer.muted[track] = STEP_SEQUENCER_MUTED;
-                else if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_OFF_SCHEDULED)
-                    local.stepSequencer.muted[track] = STEP_SEQUENCER_NOT_MUTED;
-                else if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_ON_SCHEDULED_ONCE)
-                    local.stepSequencer.muted[track] = STEP_SEQUENCER_MUTE_OFF_SCHEDULED;
-                else if (local.stepSequencer.muted[track] == STEP_SEQUENCER_MUTE_OFF_SCHEDULED_ONCE)
-                    local.stepSequencer.muted[track] = STEP_SEQUENCER_MUTE_ON_SCHEDULED;
-                }
-            if (local.stepSequencer.solo == STEP_SEQUENCER_SOLO_ON_SCHEDULED)
-                local.stepSequencer.solo = STEP_SEQUENCER_SOLO;
-            else if (local.stepSequencer.solo == STEP_SEQUENCER_SOLO_OFF_SCHEDULED)
-                local.stepSequencer.solo = STEP_SEQUENCER_NO_SOLO;
-
+            changeScheduledMutes(numTracks);
 
             if (local.stepSequencer.goNextSequence || (oldPlayPosition != -1 && local.stepSequencer.countdown == 0))  // we're supposed to go
                 {
@@ -2010,24 +2091,11 @@ void playStepSequencer()
             local.stepSequencer.countup++;
             }
 
-// pick an exclusive random track
-        uint8_t exclusiveTrack = 0;
         if (local.stepSequencer.currentPlayPosition == 0)
             {
-            int trkcount = 0;
-            for(uint8_t track = 0; track < numTracks; track++)
-                {
-                if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
-                    {
-                    if ((trkcount == 0) || (random() < RANDOM_MAX / (trkcount + 1)))  // this could work without the trakcount == 0 but I save a call to random() here 
-                        {
-                        exclusiveTrack = track;
-                        }
-                    trkcount++;
-                    }
-                }
+            chooseStepSequencerPatterns(numTracks);
             }
-                        
+
         for(uint8_t track = 0; track < numTracks; track++)
             {
             // data is stored per-track as
@@ -2041,38 +2109,6 @@ void playStepSequencer()
             uint8_t noteLength = ((local.stepSequencer.noteLength[track] == PLAY_LENGTH_USE_DEFAULT) ? 
                 options.noteLength : local.stepSequencer.noteLength[track] );
  
-            if (local.stepSequencer.currentPlayPosition == 0)
-                {
-                // pick a random track                          
-                if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_EXCLUSIVE)
-                    {
-                    local.stepSequencer.shouldPlay[track] = (track == exclusiveTrack);
-                    }
-                else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_3_4)
-                    {
-                    local.stepSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 4) * 3);
-                    }
-                else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_1_2)
-                    {
-                    local.stepSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 2));
-                    }
-                else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_1_4)
-                    {
-                    local.stepSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 4));
-                    }
-                else if (local.stepSequencer.pattern[track] == STEP_SEQUENCER_PATTERN_RANDOM_1_8)
-                    {
-                    local.stepSequencer.shouldPlay[track] = (random() < (RANDOM_MAX / 8));
-                    }
-                else
-                    {
-                    local.stepSequencer.shouldPlay[track] = ((local.stepSequencer.pattern[track] >> (local.stepSequencer.countup & 3)) & 1);                        
-                    }
-                                        
-                if (!local.stepSequencer.shouldPlay[track]) 
-                    clearNoteOnTrack(track);
-                }
-                                
             uint8_t shouldPlay = local.stepSequencer.shouldPlay[track] ;
 
 
@@ -2096,7 +2132,8 @@ void playStepSequencer()
 #endif INCLUDE_ADVANCED_STEP_SEQUENCER
                 if (vel == 0 && note == 1 && shouldPlay)  // tie
                     {
-                    local.stepSequencer.offTime[track] = currentTime + (div100(notePulseRate * getMicrosecsPerPulse() * noteLength));
+                    if (local.stepSequencer.noteOff[track] < NO_NOTE && local.stepSequencer.tied[track])
+                        releaseNoteOnTrack(track, noteLength);
                     }
                 else if (vel != 0 
                     && !local.stepSequencer.dontPlay[track]  // not a rest or tie
@@ -2123,12 +2160,13 @@ void playStepSequencer()
                         }
                     sendTrackNote(note, (uint8_t)newvel, track);         
                         
-                    local.stepSequencer.offTime[track] = currentTime + (div100(notePulseRate * getMicrosecsPerPulse() * noteLength));
                     local.stepSequencer.noteOff[track] = note;
+                    releaseNoteOnTrack(track, noteLength);
                     }
                 else //if (vel == 0 && note == 0) // rest or something weird
                     {
                     local.stepSequencer.noteOff[track] = NO_NOTE;
+                    local.stepSequencer.tied[track] = false;
                     }
             }
         // clear the dontPlay flags
@@ -2140,5 +2178,62 @@ void playStepSequencer()
     }
     
 
+// Moves the sequencer to where it would be had it played POSITION pulses from the start.
+// Notes which would be sounding aren't restarted.
+void seekStepSequencer(uint32_t position)
+    {
+    if (local.stepSequencer.playState == PLAY_STATE_STOPPED)
+        return;
+                
+    uint8_t numTracks = GET_NUM_TRACKS();
+    for(uint8_t track = 0; track < numTracks; track++)
+        clearNoteOnTrack(track);
+    resetStepSequencer();
+    local.stepSequencer.playState = PLAY_STATE_PLAYING;
+        
+    // at 0 we're where Start would put us
+    if (position == 0)
+        return;
+        
+    uint8_t trackLen = GET_TRACK_LENGTH();
+    uint32_t step = (position - 1) / notePulseRate;             // the last step played, counting from 0 at the start
+    uint32_t wraps = step / trackLen;                           // how many times we've gone round, less 1
+    local.stepSequencer.currentPlayPosition = (uint8_t)(step - wraps * trackLen);
+        
+    // In performance mode, each time round decrements the countdown, and when it's
+    // already 0 we move on (see playStepSequencer()).  Moving on reloads the sequence,
+    // which resets the countdown and countup, so after the first C0 times round the
+    // countdown goes C0, C0-1, ..., 0 over and over.
+    if (local.stepSequencer.performanceMode)
+        {
+        // The scheduled mutes change each time round, but after twice round a "once" has
+        // played out, so there's nothing more to change
+        changeScheduledMutes(numTracks);
+        if (wraps > 0)
+            changeScheduledMutes(numTracks);
+        }
+        
+    uint8_t countdown = local.stepSequencer.countdown;
+    if (local.stepSequencer.performanceMode && countdown != COUNTDOWN_INFINITE && wraps >= countdown)
+        {
+        if ((data.slot.data.stepSequencer.repeat >> 4) == 0)       // STOP
+            { 
+            stopStepSequencer(); 
+            return; 
+            }
+        // We can't follow a chain into the next sequence without loading it, so we keep
+        // looping this one
+        wraps = (wraps - countdown) % (countdown + 1);
+        local.stepSequencer.countdown = countdown - (uint8_t) wraps;
+        }
+    else if (local.stepSequencer.performanceMode && countdown != COUNTDOWN_INFINITE)
+        {
+        local.stepSequencer.countdown -= (uint8_t)(wraps + 1);
+        }
+    local.stepSequencer.countup = (uint8_t) wraps;
+    chooseStepSequencerPatterns(numTracks);
+    }
+    
+
 #endif INCLUDE_STEP_SEQUENCER
 
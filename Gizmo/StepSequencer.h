@@ -161,9 +161,6 @@
 // local.outMidi[track] is set to this if it's not overriding the default MIDI out in options.channelOut
 #define MIDI_OUT_DEFAULT 17
 
-// No MIDI out channel at all
-#define NO_MIDI_OUT 0
-
 // There are three edited states: the file is brand new,
 // the file has been loaded and not modified yet,
 // and the file has been modified
@@ -249,7 +246,7 @@ struct _stepSequencerLocal
     uint8_t muted[MAX_STEP_SEQUENCER_TRACKS];               		// Per-track mute toggle
     uint8_t velocity[MAX_STEP_SEQUENCER_TRACKS];    				// Per track note velocity, or STEP_SEQUENCER_NO_OVERRIDE_VELOCITY
     uint8_t fader[MAX_STEP_SEQUENCER_TRACKS];               		// Per-track fader, values from 1...16
-    uint32_t offTime[MAX_STEP_SEQUENCER_TRACKS];    				// When do we turn off? 
+    uint8_t tied[MAX_STEP_SEQUENCER_TRACKS];    					// Is noteOff being held over a tie?  If so it has no note off scheduled yet.
     uint8_t noteOff[MAX_STEP_SEQUENCER_TRACKS];						// What note should be turned off?
     uint8_t shouldPlay[MAX_STEP_SEQUENCER_TRACKS];					// Should the track be played this time around (due to the pattern)?
     uint8_t transposable[MAX_STEP_SEQUENCER_TRACKS];				// Can this track be transposed in performance mode?
@@ -312,6 +309,8 @@ struct _stepSequencer
 extern uint8_t _trackLength[4];
 // Used by GET_NUM_TRACKS to return the number of tracks in the current format
 extern uint8_t _numTracks[4];
+// The first of the note off entries reserved for the tracks, one each (see Scheduler.h)
+extern uint8_t stepSequencerNoteOffs;
 
 // The largest track size
 #define MAXIMUM_TRACK_LENGTH (64)
@@ -333,9 +332,12 @@ extern uint8_t _numTracks[4];
 
 
 
-// Turns off all notes as appropriate (rests and ties aren't cleared),
-// unless clearAbsolutely is true, in which case absolutely everything gets cleared regardless
-void clearNotesOnTracks(uint8_t clearEvenIfNoteNotFinished);
+// Turns off all notes as appropriate (notes about to be continued by ties aren't cleared).
+// Notes shorter than a step are turned off by the scheduler instead (see Scheduler.h).
+void clearNotesOnTracks();
+
+// Turns off the note playing on the given track, if any
+void clearNoteOnTrack(uint8_t track);
 
 // Draws the sequence with the given track length, number of tracks, and skip size
 //void drawStepSequencer(uint8_t tracklen, uint8_t numTracks, uint8_t skip);
@@ -361,6 +363,9 @@ void stopStepSequencer();
 
 void resetStepSequencer();
 
+// Moves the sequencer to where it'd be after POSITION pulses from the start.  See setSongPosition().
+void seekStepSequencer(uint32_t position);
+
 void stateStepSequencerMenuLength();
 
 // Performance Options
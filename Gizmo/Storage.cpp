@@ -3,6 +3,187 @@
 
 #include "All.h"
 
+
+#ifdef INCLUDE_BACKGROUND_SAVE
+
+/// The data being saved, and where it's going
+struct _saveSegment
+    {
+    uint16_t position;                                  // where in the EEPROM the segment goes
+    uint16_t length;
+    };
+
+GLOBAL static uint8_t saveBuffer[SAVE_BUFFER_SIZE];
+GLOBAL static struct _saveSegment saveSegments[MAX_SAVE_SEGMENTS];
+GLOBAL static uint8_t saveNumSegments;
+GLOBAL static uint16_t saveLength = 0;                 // 0 when we're not saving
+GLOBAL static uint16_t saveIndex;                      // the next byte of saveBuffer to check
+GLOBAL static uint8_t saveSegment;                     // the segment holding saveIndex
+GLOBAL static uint16_t saveSegmentStart;               // where that segment starts in saveBuffer
+GLOBAL static uint8_t saveMarker;                      // see below
+
+#define SAVE_NO_MARKER 0                // there's no commit marker
+#define SAVE_MARKER_VALID 1             // saveBuffer[0] is the commit marker, and it's still valid in the EEPROM
+#define SAVE_MARKER_INVALID 2           // saveBuffer[0] is the commit marker, and it's been set to saveInvalidMarker in the EEPROM
+GLOBAL static uint8_t saveInvalidMarker;
+
+// Adds a segment to the save being put together, merging it with the last one if it follows right on
+static void addSaveSegment(uint16_t position, uint16_t length)
+    {
+    if (length == 0) return;
+    if (saveNumSegments > 0)
+        {
+        struct _saveSegment* last = &saveSegments[saveNumSegments - 1];
+        if (last->position + last->length == position)
+            {
+            last->length += length;
+            return;
+            }
+        }
+    saveSegments[saveNumSegments].position = position;
+    saveSegments[saveNumSegments].length = length;
+    saveNumSegments++;
+    }
+
+// Starts saving the first LENGTH bytes of saveBuffer to the segments
+static void beginSaving(uint16_t length, uint8_t marker, uint8_t invalidMarker)
+    {
+    saveLength = length;
+    saveMarker = marker;
+    saveInvalidMarker = invalidMarker;
+    saveSegment = 0;
+    saveSegmentStart = 0;
+    // if there's a marker, it's written last
+    saveIndex = (marker == SAVE_NO_MARKER ? 0 : 1);
+    }
+
+static void startSaving(char* data, uint16_t position, uint16_t length, uint8_t marker, uint8_t invalidMarker)
+    {
+    finishSaving();
+    memcpy(saveBuffer, data, length);
+    saveNumSegments = 0;
+    addSaveSegment(position, length);
+    beginSaving(length, marker, invalidMarker);
+    }
+
+uint8_t isSaving()
+    {
+    return saveLength != 0;
+    }
+
+uint8_t getSaveProgress(uint8_t total)
+    {
+    if (saveLength == 0) return total;
+    return (uint8_t)(((uint32_t)saveIndex * total) / saveLength);
+    }
+
+void updateSaving()
+    {
+    if (saveLength == 0) return;                // not saving
+    if (EECR & _BV(EEPE)) return;               // the last write is still going
+
+    for(uint8_t n = 0; n < SAVE_READS_PER_TICK; n++)
+        {
+        uint16_t i = saveIndex;
+        if (i == saveLength)
+            {
+            // the commit marker goes last
+            if (saveMarker != SAVE_NO_MARKER)
+                EEPROM.update(saveSegments[0].position, saveBuffer[0]);
+            saveLength = 0;
+            return;
+            }
+        
+        if (i - saveSegmentStart == saveSegments[saveSegment].length)
+            {
+            saveSegmentStart = i;
+            saveSegment++;
+            }
+        uint16_t pos = saveSegments[saveSegment].position + (i - saveSegmentStart);
+            
+        if (EEPROM.read(pos) != saveBuffer[i])
+            {
+            if (saveMarker == SAVE_MARKER_VALID)
+                {
+                // Before we change anything, mark the whole thing as invalid, so if
+                // we lose power partway through, we don't leave it half written.
+                saveMarker = SAVE_MARKER_INVALID;
+                if (EEPROM.read(saveSegments[0].position) != saveInvalidMarker)
+                    {
+                    EEPROM.write(saveSegments[0].position, saveInvalidMarker);
+                    return;
+                    }
+                }
+            EEPROM.write(pos, saveBuffer[i]);
+            saveIndex = i + 1;
+            return;
+            }
+        saveIndex = i + 1;
+        }
+    }
+
+void finishSaving()
+    {
+    while(saveLength != 0)
+        updateSaving();
+    }
+
+/// LOAD DATA
+/// Loads data from Flash starting at the given position and of the given length.
+/// Any data which is still waiting to be saved is loaded from the save buffer.
+void loadData(char* data, uint16_t position, uint16_t length)
+    {
+    for (uint16_t i = 0; i < length; i++)
+        *(data + i) = EEPROM.read(i + position);
+
+    if (saveLength == 0) return;
+
+    // Copy over whatever part of each segment falls in our range.  Later segments
+    // are written later, so they win if they overlap earlier ones.
+    uint16_t start = 0;
+    for(uint8_t s = 0; s < saveNumSegments; s++)
+        {
+        uint16_t from = saveSegments[s].position;
+        uint16_t to = from + saveSegments[s].length;
+        uint16_t bufferStart = start;
+        start += saveSegments[s].length;
+        
+        if (from < position)
+            {
+            bufferStart += position - from;
+            from = position;
+            }
+        if (to > position + length)
+            to = position + length;
+        if (from >= to) continue;
+
+        memcpy(data + (from - position), saveBuffer + bufferStart, to - from);
+        }
+    }
+
+/// SAVE DATA
+/// Saves data to Flash starting at the given position and of the given length.
+void saveData(char* data, uint16_t position, uint16_t length)
+    {
+    if (length > SAVE_BUFFER_SIZE)          // too big, just do it now
+        {
+        finishSaving();
+        for (uint16_t i = 0; i < length; i++)
+            EEPROM.update(i + position, *(data + i));
+        }
+    else
+        {
+        startSaving(data, position, length, SAVE_NO_MARKER, 0);
+        }
+    }
+
+#else
+
+uint8_t isSaving() { return false; }
+uint8_t getSaveProgress(uint8_t total) { return total; }
+void updateSaving() { }
+void finishSaving() { }
+
 /// LOAD DATA
 /// Loads data from Flash starting at the given position and of the given length.
 void loadData(char* data, uint16_t position, uint16_t length)
@@ -19,31 +200,479 @@ void saveData(char* data, uint16_t position, uint16_t length)
         EEPROM.update(i + position, *(data + i));
     }
 
-/// LOAD SLOT
-/// Loads a slot of the given index.
-void loadSlot(uint8_t index)
+#endif INCLUDE_BACKGROUND_SAVE
+
+
+
+/// The slot directory, cached in RAM by setupSlots() and kept up to date by saveSlot()
+GLOBAL static uint8_t slotTypes[NUM_SLOTS];
+
+#ifdef INCLUDE_PREFETCH_SEQUENCES
+#define NO_PREFETCH 255
+GLOBAL static uint8_t prefetchIndex = NO_PREFETCH;    // the slot in prefetchBuffer, or being read into it
+#define FORGET_PREFETCH(index) { if (prefetchIndex == (index)) prefetchIndex = NO_PREFETCH; }
+#else
+#define FORGET_PREFETCH(index) { }
+#endif INCLUDE_PREFETCH_SEQUENCES
+
+/// GET SLOT TYPE
+/// Returns the type of a given slot.
+uint8_t getSlotType(uint8_t index)
     {
-    // converting this to a #define saves zero bytes :-(
-    loadData((char*)(&(data.slot)), sizeof(struct _slot) * index + SLOT_OFFSET, sizeof(struct _slot));
+    return slotTypes[index];
+    }
+
+
+
+#ifdef INCLUDE_COMPRESSED_SLOTS
+
+GLOBAL static uint8_t slotFirstBlocks[NUM_SLOTS];      // SLOT_NO_BLOCK for empty slots
+
+/// Which blocks are in use, one bit per block
+GLOBAL static uint8_t slotBlockUsed[(NUM_SLOT_BLOCKS + 7) / 8];
+
+#define SLOT_BLOCK_POSITION(block) ((SLOT_OFFSET) + (uint16_t)(block) * (SLOT_BLOCK_SIZE))
+#define SLOT_ENTRY_POSITION(index) ((SLOT_ENTRY_OFFSET) + (uint16_t)(index) * 2)
+#define IS_SLOT_BLOCK_USED(block) (slotBlockUsed[(block) >> 3] & (1 << ((block) & 7)))
+
+// Returns the block after the given one in its slot, or SLOT_NO_BLOCK
+static uint8_t nextSlotBlock(uint8_t block)
+    {
+    if (block >= NUM_SLOT_BLOCKS) return SLOT_NO_BLOCK;
+    uint8_t next;
+    loadData((char*)&next, SLOT_BLOCK_TABLE_OFFSET + block, 1);
+    return (next >= NUM_SLOT_BLOCKS ? SLOT_NO_BLOCK : next);
+    }
+
+// Puts the blocks of the chain starting with the given one in blocks, and returns how many there are
+static uint8_t getSlotBlocks(uint8_t block, uint8_t* blocks)
+    {
+    uint8_t n = 0;
+    // a bad block table can't send us round in circles
+    while(n < SLOT_MAX_BLOCKS && block < NUM_SLOT_BLOCKS)
+        {
+        blocks[n++] = block;
+        block = nextSlotBlock(block);
+        }
+    return n;
+    }
+
+// Marks the given blocks as used or free
+static void markSlotBlocks(uint8_t* blocks, uint8_t n, uint8_t used)
+    {
+    for(uint8_t i = 0; i < n; i++)
+        {
+        if (used)
+            slotBlockUsed[blocks[i] >> 3] |= (1 << (blocks[i] & 7));
+        else
+            slotBlockUsed[blocks[i] >> 3] &= ~(1 << (blocks[i] & 7));
+        }
+    }
+
+// Returns the length of the in-use part of the loaded slot's data.  Everything after it is treated as zero.
+static uint16_t slotDataLength()
+    {
+    if (data.slot.type == SLOT_TYPE_RECORDER)
+        {
+        uint16_t length = (sizeof(struct _recorder) - RECORDER_BUFFER_SIZE) + data.slot.data.recorder.length;
+        if (length < SLOT_DATA_SIZE) return length;
+        }
+    return SLOT_DATA_SIZE;
+    }
+
+// Returns how many zeros there are in a row starting at pos, up to 128
+static uint8_t countZeros(uint8_t* in, uint16_t pos, uint16_t length)
+    {
+    uint8_t count = 0;
+    while(count < 128 && pos < SLOT_DATA_SIZE && (pos >= length || in[pos] == 0))
+        {
+        count++;
+        pos++;
+        }
+    return count;
+    }
+
+// Packs the loaded slot's data into out (see Storage.h), returning the packed length
+static uint16_t packSlot(uint8_t* out)
+    {
+    uint8_t* in = (uint8_t*)data.slot.data.buffer;
+    uint16_t length = slotDataLength();
+    uint16_t o = 0;
+    uint16_t i = 0;
+    while(i < SLOT_DATA_SIZE)
+        {
+        uint8_t zeros = countZeros(in, i, length);
+        if (zeros >= SLOT_PACK_MIN_ZEROS || (zeros > 0 && i + zeros == SLOT_DATA_SIZE))
+            {
+            out[o++] = 127 + zeros;
+            i += zeros;
+            }
+        else
+            {
+            uint16_t control = o++;
+            uint8_t count = 0;
+            do
+                {
+                out[o++] = (i < length ? in[i] : 0);
+                i++;
+                count++;
+                }
+            while(count < 128 && i < SLOT_DATA_SIZE && countZeros(in, i, length) < SLOT_PACK_MIN_ZEROS);
+            out[control] = count - 1;
+            }
+        }
+    return o;
+    }
+
+// Unpacks a slot a bit at a time
+struct _slotReader
+    {
+    struct _slot* slot;                 // where the slot is going
+    uint16_t count;                     // how much of its data we've done
+    uint8_t next;                       // the next block to read in
+    uint8_t pos;                        // how far we are into block
+    uint8_t run;                        // how much is left of the current run
+    uint8_t literal;                    // whether the current run is literal bytes or zeros
+    uint8_t block[SLOT_BLOCK_SIZE];
+    };
+
+static void startReadingSlot(struct _slotReader* reader, uint8_t index, struct _slot* slot)
+    {
+    slot->type = slotTypes[index];
+    reader->slot = slot;
+    reader->count = 0;
+    reader->next = slotFirstBlocks[index];
+    reader->pos = SLOT_BLOCK_SIZE;
+    reader->run = 0;
+    }
+
+// Returns the next packed byte of a slot being read, reading in the next block when
+// we've used up the last one.  If there are no more blocks, returns 0.
+static uint8_t nextPackedByte(struct _slotReader* reader)
+    {
+    if (reader->pos == SLOT_BLOCK_SIZE)
+        {
+        if (reader->next == SLOT_NO_BLOCK) return 0;
+        loadData((char*)reader->block, SLOT_BLOCK_POSITION(reader->next), SLOT_BLOCK_SIZE);
+        reader->next = nextSlotBlock(reader->next);
+        reader->pos = 0;
+        }
+    return reader->block[reader->pos++];
+    }
+
+// Unpacks up to COUNT more bytes of the slot's data.  Returns true when it's all done.
+static uint8_t readSlot(struct _slotReader* reader, uint16_t count)
+    {
+    uint8_t* out = (uint8_t*)reader->slot->data.buffer;
+    uint16_t i = reader->count;
+    uint16_t end = (count >= SLOT_DATA_SIZE - i ? SLOT_DATA_SIZE : i + count);
+    for( ; i < end; i++)
+        {
+        if (reader->run == 0)
+            {
+            uint8_t control = nextPackedByte(reader);
+            reader->literal = (control < 128);
+            reader->run = (reader->literal ? control + 1 : control - 127);
+            }
+        out[i] = (reader->literal ? nextPackedByte(reader) : 0);
+        reader->run--;
+        }
+    reader->count = i;
+    return (i == SLOT_DATA_SIZE);
+    }
+
+// Puts up to COUNT free blocks in blocks, and returns how many it found
+static uint8_t findFreeSlotBlocks(uint8_t* blocks, uint8_t count)
+    {
+    uint8_t n = 0;
+    for(uint8_t b = 0; b < NUM_SLOT_BLOCKS && n < count; b++)
+        {
+        if (!IS_SLOT_BLOCK_USED(b))
+            blocks[n++] = b;
+        }
+    return n;
     }
 
 /// SAVE SLOT
 /// Saves a slot of the given index.
-void saveSlot(uint8_t index)
+uint8_t saveSlot(uint8_t index)
+    {
+    finishSaving();                     // we need the buffer, and the blocks the last save freed up
+    
+    uint8_t type = data.slot.type;
+    uint8_t oldType = slotTypes[index];
+    uint8_t oldBlocks[SLOT_MAX_BLOCKS];
+    uint8_t numOldBlocks = getSlotBlocks(slotFirstBlocks[index], oldBlocks);
+
+    // Leave room at the front of saveBuffer in case we need to empty the slot first (below)
+    uint16_t length = (type == SLOT_TYPE_EMPTY ? 0 : packSlot(saveBuffer + 1));
+    uint8_t numBlocks = (length + SLOT_BLOCK_SIZE - 1) / SLOT_BLOCK_SIZE;
+
+    // The new copy goes in free blocks, so the old copy is untouched until the entry is
+    // rewritten.  If there's no room for two copies, the new one has to reuse the old one's
+    // blocks, so the slot is emptied first: if the power goes out partway through, the slot
+    // is lost, but it isn't left holding garbage.
+    uint8_t blocks[SLOT_MAX_BLOCKS];
+    uint8_t reuse = false;
+    uint8_t n = findFreeSlotBlocks(blocks, numBlocks);
+    if (n < numBlocks)
+        {
+        markSlotBlocks(oldBlocks, numOldBlocks, false);
+        n = findFreeSlotBlocks(blocks, numBlocks);
+        markSlotBlocks(oldBlocks, numOldBlocks, true);
+        if (n < numBlocks)          // no room even so
+            return false;
+        reuse = true;
+        }
+        
+    // Emptying the slot (if need be), then the packed data, then the block table, then the entry
+    saveNumSegments = 0;
+    uint16_t end = 0;
+    if (reuse && oldType != SLOT_TYPE_EMPTY)
+        {
+        saveBuffer[end++] = SLOT_TYPE_EMPTY;
+        addSaveSegment(SLOT_ENTRY_POSITION(index), 1);
+        }
+    else
+        {
+        memmove(saveBuffer, saveBuffer + 1, length);
+        }
+    
+    for(uint8_t i = 0; i < n; i++)
+        {
+        uint16_t start = i * SLOT_BLOCK_SIZE;
+        addSaveSegment(SLOT_BLOCK_POSITION(blocks[i]), (length - start < SLOT_BLOCK_SIZE ? length - start : SLOT_BLOCK_SIZE));
+        }
+    end += length;
+
+    for(uint8_t i = 0; i < n; i++)
+        {
+        saveBuffer[end++] = (i + 1 < n ? blocks[i + 1] : SLOT_NO_BLOCK);
+        addSaveSegment(SLOT_BLOCK_TABLE_OFFSET + blocks[i], 1);
+        }
+
+    // The entry is two bytes, written one at a time.  If the type is changing, empty the slot
+    // before pointing it at the new blocks, so it's never the old type with the new data.
+    if (!reuse && oldType != type && oldType != SLOT_TYPE_EMPTY)
+        {
+        saveBuffer[end++] = SLOT_TYPE_EMPTY;
+        addSaveSegment(SLOT_ENTRY_POSITION(index), 1);
+        }
+    saveBuffer[end++] = (n == 0 ? SLOT_NO_BLOCK : blocks[0]);
+    addSaveSegment(SLOT_ENTRY_POSITION(index) + 1, 1);
+    saveBuffer[end++] = type;
+    addSaveSegment(SLOT_ENTRY_POSITION(index), 1);
+    beginSaving(end, SAVE_NO_MARKER, 0);
+    
+    // Now that the commit is queued, the old blocks can be handed out again.  Nothing else
+    // can be saved until this save is finished, by which time they really are free.
+    markSlotBlocks(oldBlocks, numOldBlocks, false);
+    markSlotBlocks(blocks, n, true);
+    slotTypes[index] = type;
+    slotFirstBlocks[index] = (n == 0 ? SLOT_NO_BLOCK : blocks[0]);
+    FORGET_PREFETCH(index);
+    return true;
+    }
+    
+void clearSlots()
     {
+    finishSaving();
+    for(uint8_t i = 0; i < NUM_SLOTS; i++)
+        {
+        EEPROM.update(SLOT_ENTRY_POSITION(i), SLOT_TYPE_EMPTY);
+        EEPROM.update(SLOT_ENTRY_POSITION(i) + 1, SLOT_NO_BLOCK);
+        slotTypes[i] = SLOT_TYPE_EMPTY;
+        slotFirstBlocks[i] = SLOT_NO_BLOCK;
+        FORGET_PREFETCH(i);
+        }
+    // the magic number goes last
+    EEPROM.update(SLOT_DIRECTORY_OFFSET, SLOT_MAGIC_0);
+    EEPROM.update(SLOT_DIRECTORY_OFFSET + 1, SLOT_MAGIC_1);
+    memset(slotBlockUsed, 0, sizeof(slotBlockUsed));
+    }
+
+// Moves the slots of the old nine-slot layout into blocks, then writes the directory.
+// Each slot's blocks follow on from the last slot's, and we read a slot in before writing
+// it, so we only have to make sure we don't write over the slots we haven't read yet.
+// A slot which would is dropped.  See Storage.h.
+static void upgradeSlots()
+    {
+    uint8_t numBlocks[OLD_NUM_SLOTS];
+    uint8_t block = 0;
+    for(uint8_t i = 0; i < OLD_NUM_SLOTS; i++)
+        {
+        uint16_t position = SLOT_OFFSET + (uint16_t)i * SLOT_SIZE;
+        data.slot.type = EEPROM.read(position);
+        loadData(data.slot.data.buffer, position + 1, SLOT_DATA_SIZE);
+        slotTypes[i] = SLOT_TYPE_EMPTY;
+        slotFirstBlocks[i] = SLOT_NO_BLOCK;
+        numBlocks[i] = 0;
+        
+        uint8_t type = data.slot.type;
+        if (type != SLOT_TYPE_STEP_SEQUENCER && type != SLOT_TYPE_DRUM_SEQUENCER && type != SLOT_TYPE_RECORDER)
+            continue;           // empty, or a new board
+        uint16_t length = packSlot(saveBuffer);
+        uint8_t n = (length + SLOT_BLOCK_SIZE - 1) / SLOT_BLOCK_SIZE;
+        uint16_t limit = (i + 1 == OLD_NUM_SLOTS ? SLOT_DIRECTORY_OFFSET : position + SLOT_SIZE);
+        if (SLOT_BLOCK_POSITION(block + n) > limit)
+            continue;
+        for(uint16_t j = 0; j < length; j++)
+            EEPROM.update(SLOT_BLOCK_POSITION(block) + j, saveBuffer[j]);
+        slotTypes[i] = type;
+        slotFirstBlocks[i] = block;
+        numBlocks[i] = n;
+        block += n;
+        }
+
+    // The directory is where the last old slot was, so it can only be written now
+    for(uint8_t i = 0; i < OLD_NUM_SLOTS; i++)
+        for(uint8_t j = 0; j < numBlocks[i]; j++)
+            EEPROM.update(SLOT_BLOCK_TABLE_OFFSET + slotFirstBlocks[i] + j, (j + 1 < numBlocks[i] ? slotFirstBlocks[i] + j + 1 : SLOT_NO_BLOCK));
+    for(uint8_t i = 0; i < NUM_SLOTS; i++)
+        {
+        if (i >= OLD_NUM_SLOTS)
+            {
+            slotTypes[i] = SLOT_TYPE_EMPTY;
+            slotFirstBlocks[i] = SLOT_NO_BLOCK;
+            }
+        EEPROM.update(SLOT_ENTRY_POSITION(i), slotTypes[i]);
+        EEPROM.update(SLOT_ENTRY_POSITION(i) + 1, slotFirstBlocks[i]);
+        }
+    // the magic number goes last
+    EEPROM.update(SLOT_DIRECTORY_OFFSET, SLOT_MAGIC_0);
+    EEPROM.update(SLOT_DIRECTORY_OFFSET + 1, SLOT_MAGIC_1);
+    }
+
+void setupSlots()
+    {
+    if (EEPROM.read(SLOT_DIRECTORY_OFFSET) != SLOT_MAGIC_0 ||
+        EEPROM.read(SLOT_DIRECTORY_OFFSET + 1) != SLOT_MAGIC_1)
+        {
+        upgradeSlots();         // still the old layout, or a new board
+        }
+
+    memset(slotBlockUsed, 0, sizeof(slotBlockUsed));
+    for(uint8_t i = 0; i < NUM_SLOTS; i++)
+        {
+        slotTypes[i] = EEPROM.read(SLOT_ENTRY_POSITION(i));
+        uint8_t block = EEPROM.read(SLOT_ENTRY_POSITION(i) + 1);
+        // an empty slot's blocks may have been handed out again
+        if (slotTypes[i] == SLOT_TYPE_EMPTY || block >= NUM_SLOT_BLOCKS)
+            block = SLOT_NO_BLOCK;
+        slotFirstBlocks[i] = block;
+        uint8_t blocks[SLOT_MAX_BLOCKS];
+        markSlotBlocks(blocks, getSlotBlocks(block, blocks), true);
+        }
+    }
+
+#else
+
+// Reads a slot a bit at a time
+struct _slotReader
+    {
+    struct _slot* slot;                 // where the slot is going
+    uint16_t count;                     // how much of its data we've done
+    uint16_t position;                  // where its data starts in the EEPROM
+    };
+
+static void startReadingSlot(struct _slotReader* reader, uint8_t index, struct _slot* slot)
+    {
+    slot->type = slotTypes[index];
+    reader->slot = slot;
+    reader->count = 0;
+    reader->position = sizeof(struct _slot) * index + SLOT_OFFSET + offsetof(struct _slot, data);       // there may be padding after the type, though not on the AVR
+    }
+
+// Reads up to COUNT more bytes of the slot's data.  Returns true when it's all done.
+static uint8_t readSlot(struct _slotReader* reader, uint16_t count)
+    {
+    uint16_t left = SLOT_DATA_SIZE - reader->count;
+    if (count > left) count = left;
+    loadData(reader->slot->data.buffer + reader->count, reader->position + reader->count, count);
+    reader->count += count;
+    return (reader->count == SLOT_DATA_SIZE);
+    }
+
+/// SAVE SLOT
+/// Saves a slot of the given index.
+uint8_t saveSlot(uint8_t index)
+    {
+#ifdef INCLUDE_BACKGROUND_SAVE
+    // The slot type is the commit marker
+    startSaving((char*)(&(data.slot)), sizeof(struct _slot) * index  + SLOT_OFFSET, sizeof(struct _slot), SAVE_MARKER_VALID, SLOT_TYPE_EMPTY);
+#else
     // converting this to a #define saves zero bytes :-(
     saveData((char*)(&(data.slot)), sizeof(struct _slot) * index  + SLOT_OFFSET, sizeof(struct _slot));
+#endif INCLUDE_BACKGROUND_SAVE
+    slotTypes[index] = data.slot.type;
+    FORGET_PREFETCH(index);
+    return true;
     }
-    
-/// GET SLOT TYPE
-/// Returns the type of a given slot.
-uint8_t getSlotType(uint8_t index)
+
+void clearSlots()
     {
-    uint8_t type;
-    loadData((char*)&type, sizeof(struct _slot) * index + SLOT_OFFSET, 1);
-    return type;
+    for(uint8_t i = 0; i < NUM_SLOTS; i++)
+        {
+        loadSlot(i);
+        data.slot.type = SLOT_TYPE_EMPTY;
+        saveSlot(i);
+        }
     }
 
+void setupSlots()
+    {
+    for(uint8_t i = 0; i < NUM_SLOTS; i++)
+        slotTypes[i] = EEPROM.read(sizeof(struct _slot) * i + SLOT_OFFSET);
+    }
+
+#endif INCLUDE_COMPRESSED_SLOTS
+
+
+/// LOAD SLOT
+/// Loads a slot of the given index.
+void loadSlot(uint8_t index)
+    {
+    struct _slotReader reader;
+    startReadingSlot(&reader, index, &data.slot);
+    readSlot(&reader, SLOT_DATA_SIZE);
+    }
+
+
+#ifdef INCLUDE_PREFETCH_SEQUENCES
+
+GLOBAL static struct _slot prefetchBuffer;
+GLOBAL static struct _slotReader prefetchReader;
+GLOBAL static uint8_t prefetchDone;
+
+void prefetchSlot(uint8_t index)
+    {
+    if (index == prefetchIndex) return;
+    prefetchIndex = index;
+    startReadingSlot(&prefetchReader, index, &prefetchBuffer);
+    prefetchDone = false;
+    }
+
+void updatePrefetching()
+    {
+    if (prefetchIndex == NO_PREFETCH || prefetchDone) return;
+    if (EECR & _BV(EEPE)) return;               // reading would have to wait for the write to finish
+    prefetchDone = readSlot(&prefetchReader, PREFETCH_BYTES_PER_TICK);
+    }
+
+void loadPrefetchedSlot(uint8_t index)
+    {
+    if (index != prefetchIndex)
+        {
+        loadSlot(index);
+        return;
+        }
+    if (!prefetchDone)          // we got here sooner than expected
+        prefetchDone = readSlot(&prefetchReader, SLOT_DATA_SIZE);
+    memcpy(&data.slot, &prefetchBuffer, sizeof(struct _slot));
+    }
+
+#endif INCLUDE_PREFETCH_SEQUENCES
+
 uint8_t slotTypeForApplication(uint8_t application)
     {
     switch(application)
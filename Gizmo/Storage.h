@@ -24,17 +24,27 @@
 //// the arpeggios.  There are ten of them, each of size 18, starting at ARPEGGIATOR_OFFSET.
 //// Finally comes the options struct.  This starts at OPTIONS_OFFSET.
 //// The Mega has space for a 424-byte options struct.  The Uno has space for 68 bytes.
+////
+//// If INCLUDE_COMPRESSED_SLOTS is defined, the slots are instead packed into the same
+//// region the Mega's nine slots used to take up (SLOT_REGION_SIZE), and there are fifteen
+//// of them.  See COMPRESSED SLOTS below.
 
 #if defined(__MEGA__)
+#ifdef INCLUDE_COMPRESSED_SLOTS
+#define NUM_SLOTS 15                            // the most the four-bit "next sequence" settings can reach
+#else
 #define NUM_SLOTS 9
+#endif INCLUDE_COMPRESSED_SLOTS
+#define SLOT_REGION_SIZE (9 * (SLOT_SIZE))
 #endif
 #if defined(__UNO__)
 #define NUM_SLOTS 2
+#define SLOT_REGION_SIZE (2 * (SLOT_SIZE))
 #endif
 
 #define SLOT_OFFSET 0
 #define SLOT_SIZE ((SLOT_DATA_SIZE) + 1)
-#define ARPEGGIATOR_OFFSET      ((SLOT_OFFSET) + (NUM_SLOTS) * (SLOT_SIZE))
+#define ARPEGGIATOR_OFFSET      ((SLOT_OFFSET) + (SLOT_REGION_SIZE))
 #define NUM_ARPS 10
 #define OPTIONS_OFFSET  ((ARPEGGIATOR_OFFSET) + ((NUM_ARPS) * sizeof(struct _arp)))
 
@@ -45,6 +55,9 @@
 ////// will be displayed when you load slots, and also serves to indicate what
 ////// elements are stored in a given slot.  Following this a slot contains a union
 ////// of 386 bytes whose layout is specified by the given application.
+////// The slot types are read into RAM by setupSlots() when we boot, and kept up to
+////// date by saveSlot(), so the load and save menus and sequence chaining don't have
+////// to go to the EEPROM to find out what's in each slot.
 
 #define SLOT_TYPE_EMPTY (GLYPH_3x5_BLANK)
 #define SLOT_TYPE_STEP_SEQUENCER (GLYPH_3x5_S)
@@ -88,6 +101,48 @@ union _data
 extern union _data data;
     
 
+////// BACKGROUND SAVING
+////// Writing a byte to the EEPROM takes 3.3ms, so saving a whole slot at once could
+////// stop everything (the clock, the sequencers) for over a second.  If INCLUDE_BACKGROUND_SAVE
+////// is defined, saveData() and saveSlot() instead copy the data into a buffer and return,
+////// and go() calls updateSaving() every tick, which checks a few bytes against the EEPROM
+////// and starts writing the first which differs, if the EEPROM isn't still busy writing
+////// the last one.  Meanwhile loadData() loads anything still waiting to be saved
+////// from the buffer, so you see what you saved.  Only one save is done at a time:
+////// saving something else while a save is going on first finishes the current save.
+//////
+////// A save is written as a list of up to MAX_SAVE_SEGMENTS SEGMENTS, each going to its
+////// own place in the EEPROM, one after the other.  saveData() has just one.
+//////
+////// Without INCLUDE_COMPRESSED_SLOTS, a slot's type is its COMMIT MARKER.  Before the first
+////// byte of a slot is changed, its type is set to SLOT_TYPE_EMPTY, and the real type is
+////// written last.  So if the power goes out partway through, the slot is empty rather than
+////// half old and half new.  Arpeggios and options are small and don't have this protection.
+//////
+////// The buffer costs SAVE_BUFFER_SIZE bytes of RAM, which the Uno doesn't have, so there
+////// saving is done all at once, as it always was.
+
+#ifdef INCLUDE_COMPRESSED_SLOTS
+#define SAVE_BUFFER_SIZE ((SLOT_DATA_SIZE) + 32)        // a packed slot, its block chain, and its directory entry
+#define MAX_SAVE_SEGMENTS 32
+#else
+#define SAVE_BUFFER_SIZE (sizeof(struct _slot))
+#define MAX_SAVE_SEGMENTS 1
+#endif INCLUDE_COMPRESSED_SLOTS
+#define SAVE_READS_PER_TICK 16                  // how many unchanged bytes updateSaving() will skip over in one tick
+
+/// Returns true if a save is going on in the background
+uint8_t isSaving();
+
+/// Returns how much of the background save is done, from 0 to TOTAL
+uint8_t getSaveProgress(uint8_t total);
+
+/// Does a bit more of the background save.  Called every tick by go().
+void updateSaving();
+
+/// Completes the background save right now.  Call this before you reset the board.
+void finishSaving();
+
 /// LOAD DATA
 /// Loads data from Flash starting at the given position and of the given length.
 void loadData(char* data, uint16_t position, uint16_t length);
@@ -101,14 +156,112 @@ void saveData(char* data, uint16_t position, uint16_t length);
 void loadSlot(uint8_t index);
 
 /// SAVE SLOT
-/// Saves a slot of the given index.
-void saveSlot(uint8_t index);
+/// Saves a slot of the given index.  Returns false if there wasn't room, in which
+/// case the slot is left as it was.  This can only happen with INCLUDE_COMPRESSED_SLOTS.
+uint8_t saveSlot(uint8_t index);
 
 /// GET SLOT TYPE
-/// Returns the type of a given slot.
+/// Returns the type of a given slot.  The types are kept in RAM, so this is cheap.
 uint8_t getSlotType(uint8_t index);
 
 
+
+////// COMPRESSED SLOTS
+////// Most slots are mostly zeros: empty drum steps, rests, the unused end of the
+////// recorder's buffer.  If INCLUDE_COMPRESSED_SLOTS is defined, a slot's 387 bytes of
+////// data are PACKED before they're saved, as a series of runs, each starting with a
+////// control byte C.  If C < 128, then C + 1 literal bytes follow.  Otherwise C - 127
+////// zeros are to be filled in.  Runs of fewer than SLOT_PACK_MIN_ZEROS zeros are left as
+////// literals, since breaking up a literal run costs a byte.  The recorder only packs the
+////// part of its buffer which is in use.  A full slot can't pack to more than
+////// SLOT_PACKED_MAX_SIZE, and loading and unpacking it takes no longer than loading it did.
+//////
+////// The packed slots are stored in NUM_SLOT_BLOCKS blocks of SLOT_BLOCK_SIZE bytes.
+////// After the blocks comes the SLOT DIRECTORY: a two-byte magic number, then for each
+////// slot a two-byte ENTRY holding its type and its first block, then a BLOCK TABLE
+////// holding, for each block, the next block in its slot.  The last block in a slot
+////// (and the first block of an empty slot) is SLOT_NO_BLOCK.  setupSlots() reads the
+////// entries into RAM when we boot and works out which blocks are free, so loading a
+////// slot doesn't have to read its entry first.
+//////
+////// A slot is saved into free blocks, so its old blocks are untouched until its
+////// entry is rewritten, which is done last.  The entry is the commit marker: if the
+////// power goes out before then, the slot is as it was.  If the slot's type is changing,
+////// the entry's type is first set to SLOT_TYPE_EMPTY, so a half-written entry leaves
+////// the slot empty rather than pointing to the wrong kind of data.  If there aren't
+////// enough free blocks for the new copy, it reuses the old copy's blocks, and the
+////// entry's type is set to SLOT_TYPE_EMPTY before anything else: then if the power goes
+////// out partway through, the slot is empty rather than garbage.
+//////
+////// Compressed slots need INCLUDE_BACKGROUND_SAVE.  The first time the board boots with
+////// INCLUDE_COMPRESSED_SLOTS, setupSlots() doesn't find the directory's magic number, and
+////// UPGRADES the OLD_NUM_SLOTS slots of the old layout: it packs each one in turn into
+////// the blocks, then writes the directory.  This takes several seconds, and the board
+////// mustn't lose power while it's going on.  Packed slots are nearly always much
+////// smaller than the old ones, but a slot which won't fit without writing over a slot
+////// which hasn't been moved yet is emptied.  That can only happen if the slots are
+////// nearly incompressible, so to be safe, dump any slots you want to keep as sysex first.
+////// A new board has no valid slot types, so it just gets an empty directory.
+////// The arpeggios and options don't move.
+
+#ifdef INCLUDE_COMPRESSED_SLOTS
+#define OLD_NUM_SLOTS 9
+#define SLOT_BLOCK_SIZE 32
+#define NUM_SLOT_BLOCKS 104
+#define SLOT_NO_BLOCK 255
+#define SLOT_PACK_MIN_ZEROS 3
+#define SLOT_PACKED_MAX_SIZE ((SLOT_DATA_SIZE) + ((SLOT_DATA_SIZE) + 127) / 128)
+#define SLOT_MAX_BLOCKS (((SLOT_PACKED_MAX_SIZE) + (SLOT_BLOCK_SIZE) - 1) / (SLOT_BLOCK_SIZE))
+
+#define SLOT_MAGIC_0 'G'
+#define SLOT_MAGIC_1 'z'
+#define SLOT_DIRECTORY_OFFSET ((SLOT_OFFSET) + (NUM_SLOT_BLOCKS) * (SLOT_BLOCK_SIZE))
+#define SLOT_ENTRY_OFFSET ((SLOT_DIRECTORY_OFFSET) + 2)
+#define SLOT_BLOCK_TABLE_OFFSET ((SLOT_ENTRY_OFFSET) + (NUM_SLOTS) * 2)
+#define SLOT_DIRECTORY_END ((SLOT_BLOCK_TABLE_OFFSET) + (NUM_SLOT_BLOCKS))      // must be <= ARPEGGIATOR_OFFSET
+
+#ifndef INCLUDE_BACKGROUND_SAVE
+#error INCLUDE_COMPRESSED_SLOTS requires INCLUDE_BACKGROUND_SAVE
+#endif
+#endif INCLUDE_COMPRESSED_SLOTS
+
+/// Reads the slot types (and with INCLUDE_COMPRESSED_SLOTS, the rest of the slot directory)
+/// into RAM, and works out which blocks are free, upgrading the old slots if there's no
+/// directory yet.  Called by setup().
+void setupSlots();
+
+/// Empties all the slots.  Called by fullReset().
+void clearSlots();
+
+
+
+////// PREFETCHING
+////// When a sequence chains to the next one, loading and unpacking the next slot right on
+////// the downbeat could make it late.  If INCLUDE_PREFETCH_SEQUENCES is defined, a sequencer
+////// instead calls prefetchSlot() with its next slot while it's playing, and go() calls
+////// updatePrefetching() every tick, which reads PREFETCH_BYTES_PER_TICK bytes of it into a
+////// buffer of its own.  Then at the downbeat, loadPrefetchedSlot() just copies it in.
+////// Asking for a different slot starts over, saving the slot forgets it, and if it isn't
+////// finished by the time it's needed, loadPrefetchedSlot() finishes it there and then.
+////// The buffer costs another 388 bytes or so of RAM, so this is only on the Mega.
+
+#define PREFETCH_BYTES_PER_TICK 32
+
+#ifdef INCLUDE_PREFETCH_SEQUENCES
+/// Starts reading the given slot in the background, if we're not already
+void prefetchSlot(uint8_t index);
+
+/// Reads a bit more of the slot being prefetched.  Called every tick by go().
+void updatePrefetching();
+
+/// Loads a slot of the given index, from the prefetch buffer if it's there.
+void loadPrefetchedSlot(uint8_t index);
+#else
+#define prefetchSlot(index) 
+#define updatePrefetching()
+#define loadPrefetchedSlot(index) loadSlot(index)
+#endif INCLUDE_PREFETCH_SEQUENCES
+
     
 #endif
 
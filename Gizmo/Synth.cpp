@@ -51,6 +51,7 @@ void synthUpdate()
                 }
             else if (local.synth.datatype == TYPE_SYSEX)
                 {
+                flushMIDI();
                 MIDI.sendSysEx(local.synth.parameter, local.synth.sysex, true);
                 local.synth.parameterDisplay = DISPLAY_ONLY_VALUE;
                 local.synth.valueDisplay = local.synth.value;
@@ -130,6 +131,7 @@ void sendDelayedSysex(uint8_t* sysex, uint8_t length, int16_t displayValue, uint
         }
     else        // otherwise send it out immediately and set the timer for future items
         {
+        flushMIDI();
         MIDI.sendSysEx(length, sysex, true);
         TOGGLE_OUT_LED();
         local.synth.countDown = countdown;
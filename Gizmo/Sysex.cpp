@@ -6,8 +6,7 @@
 
 
 
-#ifdef INCLUDE_SYSEX
-        
+// This is also used by the profiler, so it's available even without INCLUDE_SYSEX
 void loadHeader(uint8_t bytes[])
     {
     bytes[0] = 0xF0;
@@ -20,6 +19,8 @@ void loadHeader(uint8_t bytes[])
     bytes[7] = SYSEX_VERSION;
     }
         
+#ifdef INCLUDE_SYSEX
+
 void sendSlotSysex()
     {
     loadSlot(local.sysex.slot);
@@ -51,6 +52,7 @@ void sendSlotSysex()
         }
     bytes[sizeof(struct _slot) * 2 + 11 - 2] = (sum & 127);
     bytes[sizeof(struct _slot) * 2 + 11 - 1] = 0xF7;
+    flushMIDI();
     MIDI.sendSysEx(sizeof(struct _slot) * 2 + 11, bytes, true);
     }        
 
@@ -80,6 +82,7 @@ void sendArpSysex()
         }
     bytes[sizeof(struct _arp) * 2 + 11 - 2] = (sum & 127);
     bytes[sizeof(struct _arp) * 2 + 11 - 1] = 0xF7;
+    flushMIDI();
     MIDI.sendSysEx(sizeof(struct _arp) * 2 + 11, bytes, true);
     }        
         
@@ -100,8 +103,7 @@ uint8_t receiveSlotSysex(unsigned char* bytes)
         {
         data.bytes[i] = (uint8_t)(bytes[9 + i * 2] << 4) | (bytes[9 + i * 2 + 1] & 0xF);
         }
-    saveSlot(local.sysex.slot);
-    return true;
+    return saveSlot(local.sysex.slot);
     }
 
 uint8_t receiveArpSysex(unsigned char* bytes)
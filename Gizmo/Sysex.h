@@ -11,6 +11,7 @@
 #define NO_SYSEX_SLOT (-1)
 #define SYSEX_TYPE_SLOT 0
 #define SYSEX_TYPE_ARP 1
+#define SYSEX_TYPE_PROFILE 2
 #define RECEIVED_WRONG (-1)
 #define RECEIVED_BAD (-2)
 #define RECEIVED_NONE (0)
@@ -22,6 +23,7 @@ struct _sysexLocal
     int8_t received;
     };
 
+void loadHeader(uint8_t bytes[]);
 void sendSlotSysex();
 void sendArpSysex();
 void handleSysex(unsigned char* bytes, int len);
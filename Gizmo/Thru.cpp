@@ -249,22 +249,22 @@ itemType = MIDI_NRPN_14_BIT;
                     {
                     case MIDI_AFTERTOUCH:
                         {
-                        MIDI.sendAfterTouch(itemValue, channel);
+                        queueMIDI(MIDIAfterTouchChannel, itemValue, 0, channel);
                         }
                     break;
                     case MIDI_PROGRAM_CHANGE:
                         {
-                        MIDI.sendProgramChange(itemNumber, channel);
+                        queueMIDI(MIDIProgramChange, itemNumber, 0, channel);
                         }
                     break;
                     case MIDI_PITCH_BEND:
                         {
-                        MIDI.sendPitchBend((int)itemValue, channel);
+                        queuePitchBend((int)itemValue, channel);
                         }
                     break;
                     case MIDI_CC_7_BIT:
                         {
-                        MIDI.sendControlChange(itemNumber, itemValue, channel);
+                        queueMIDI(MIDIChannelControl, itemNumber, itemValue, channel);
                         }
                     break;
                     case MIDI_CC_14_BIT:
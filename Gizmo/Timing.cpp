@@ -26,6 +26,14 @@ GLOBAL uint32_t targetNextTickTime = 0;
 /// The number of TICKS so far
 GLOBAL uint32_t tickCount = 0;
 
+#ifdef INCLUDE_PROFILER
+/// How late we've been (see Timing.h)
+GLOBAL struct _tickStats tickStats;
+
+/// When the last tick started, for tickStats.drift.  0 if we haven't seen a tick since the stats were reset.
+GLOBAL static uint32_t tickStatsLastTime = 0;
+#endif INCLUDE_PROFILER
+
 
 
 
@@ -39,6 +47,15 @@ GLOBAL uint32_t targetNextPulseTime = 0;
 // Flipping that we have 62500 MSEC / 3 PULSE ~ 20833 MSEC/PULSE
 GLOBAL uint32_t microsecsPerPulse = 20833;
 
+// The part of a pulse that doesn't divide into whole microseconds.  A pulse is really
+// microsecsPerPulse + pulseRemainder / pulseRemainderDivisor microseconds long (at 120 BPM
+// it's 20833 + 400/1200), so we add pulseRemainder to pulseRemainderAccumulator every
+// pulse, and when it reaches pulseRemainderDivisor we make the pulse one microsecond longer.
+// This way the internal clock never drifts no matter how long it runs.
+GLOBAL static uint16_t pulseRemainder = 400;
+GLOBAL static uint16_t pulseRemainderDivisor = 1200;
+GLOBAL static uint16_t pulseRemainderAccumulator = 0;
+
 // The number of PULSES so far.
 GLOBAL uint32_t pulseCount = 0;
 
@@ -92,9 +109,46 @@ void updateTicksAndWait()
     {
     targetNextTickTime += TARGET_TICK_TIMESTEP;
     currentTime = micros();
+#ifdef INCLUDE_PROFILER
+    // Each tick should start TARGET_TICK_TIMESTEP after the last one.  Whatever it's off by
+    // (late ticks we never caught up on, dropped time) is drift.
+    if (tickStatsLastTime != 0)
+        tickStats.drift += (int32_t)(currentTime - tickStatsLastTime) - TARGET_TICK_TIMESTEP;
+    tickStatsLastTime = currentTime;
+    if (tickStatsLastTime == 0)                 // not allowed to be 0
+        tickStatsLastTime--;
+#endif INCLUDE_PROFILER
     if (TIME_GREATER_THAN(currentTime, targetNextTickTime)) //(currentTime > targetNextTickTime)
         {
-        // we're too far ahead, do nothing
+        // we're running late, so don't wait.
+#if defined(INCLUDE_PROFILER) || (TICK_CATCH_UP != TICK_CATCH_UP_BURST)
+        uint32_t lateness = currentTime - targetNextTickTime;
+#endif
+#ifdef INCLUDE_PROFILER
+        tickStats.lateTicks++;
+        if (lateness > tickStats.worstTickLateness)
+            tickStats.worstTickLateness = lateness;
+#endif INCLUDE_PROFILER
+                
+#if (TICK_CATCH_UP == TICK_CATCH_UP_SKIP)
+        if (lateness >= TARGET_TICK_TIMESTEP)
+            {
+            // drop the whole ticks we've missed.  This divide only happens when we're already in trouble.
+            uint32_t dropped = lateness - (lateness % TARGET_TICK_TIMESTEP);
+            targetNextTickTime += dropped;
+#ifdef INCLUDE_PROFILER
+            tickStats.droppedTime += dropped;
+#endif INCLUDE_PROFILER
+            }
+#elif (TICK_CATCH_UP == TICK_CATCH_UP_RESYNC)
+        if (lateness >= TICK_RESYNC_THRESHOLD)
+            {
+            targetNextTickTime = currentTime;
+#ifdef INCLUDE_PROFILER
+            tickStats.droppedTime += lateness;
+#endif INCLUDE_PROFILER
+            }
+#endif
         }
     else
         {
@@ -125,17 +179,59 @@ void updateTicksAndWait()
     }
 
 
+#ifdef INCLUDE_PROFILER
+void resetTickStats()
+    {
+    memset(&tickStats, 0, sizeof(struct _tickStats));
+    tickStatsLastTime = 0;
+    }
+#endif INCLUDE_PROFILER
+
+
 
 uint32_t lastExternalPulseTime = 0;
 uint32_t externalMicrosecsPerPulse = 0;
 uint8_t clockState = CLOCK_STOPPED;
 
+/// TRACKING THE EXTERNAL CLOCK
+/// We only see an incoming MIDI clock pulse at the start of the tick after it arrives, so
+/// the time between two pulses can be off by up to a tick (320us) either way, plus whatever
+/// jitter the sender adds.  If we just used that as our estimate of the microseconds per
+/// pulse, swing, gate lengths, and arpeggiator note offs would all jitter along with it.
+///
+/// Instead we track the clock with an alpha-beta filter (a simple phase-locked loop).  We keep
+/// an estimate of the period (in 1/16 microseconds) and of when the next pulse should arrive.
+/// When it does, the error between the two nudges our estimate of the pulse time by 1/4 of the
+/// error and the period by 1/32 of it.  The quantization and jitter mostly average out, while a
+/// steady drift in tempo is followed within a few pulses.
+///
+/// A pulse which is off by more than 1/8 of a period (or three ticks, whichever is more) is
+/// an OUTLIER and is ignored, unless EXTERNAL_CLOCK_MAX_OUTLIERS of them come in a row: then
+/// the tempo has really changed, and we start over from the time between the last two pulses.
+///
+/// host/bench/ClockBench.cpp measures this.  At 120 BPM the error in the estimate drops from
+/// 0.29% to 0.02% with a steady sender, and from 5.4% to 0.18% when the sender jitters by 1ms
+/// (one standard deviation).  A step from 120 to 90 or 130 BPM is followed to within 0.5%
+/// in 4 pulses, and to 240 BPM in 13.  When the jitter is a large part of the period (1ms
+/// at 240 BPM), too many pulses look like outliers and the filter can't settle down.
+
+#define EXTERNAL_CLOCK_PERIOD_SHIFT 4           // externalPeriod is in 1/16 microseconds
+#define EXTERNAL_CLOCK_ALPHA_SHIFT 2            // pulse time gets 1/4 of the error
+#define EXTERNAL_CLOCK_BETA_SHIFT 1             // period gets 1/32 of the error (that is, 16/32, in 1/16 microseconds)
+#define EXTERNAL_CLOCK_MIN_OUTLIER (3 * TARGET_TICK_TIMESTEP)
+#define EXTERNAL_CLOCK_MAX_OUTLIERS 3
+
+GLOBAL static uint32_t externalPeriod;                 // estimated microseconds per pulse, in 1/16 microseconds
+GLOBAL static uint32_t externalNextPulseTime;          // when we expect the next pulse to arrive
+GLOBAL static uint8_t externalTracking;                // do we have an estimate yet?
+GLOBAL static uint8_t externalOutliers;                // how many outliers in a row we've seen
+
 /// Estimates the microseconds per pulse if we're being driven by a remote external clock.
 /// If we have just STARTed, then lastExternalPulseTime is set to 0, so this is our FIRST pulse.
 /// We need at two pulses to get an estimate.  Prior to the second pulse, our estimate is 0.
 /// At the first pulse (and every pulse thereafter), we record the time of the pulse in 
-/// lastExternalPulseTime. At the second pulse (and every pulse thereafter), the estimate
-//  is (of course) the difference between the current time and the last pulse.
+/// lastExternalPulseTime. At the second pulse, the estimate is (of course) the difference
+//  between the current time and the last pulse.  Thereafter it's tracked as described above.
 //
 //  The issue here is that when a note is played on the VERY FIRST PULSE, application such
 //  as the step sequencer need to know when to turn the note off.  If there's swing, then they
@@ -146,12 +242,45 @@ uint8_t clockState = CLOCK_STOPPED;
 //  be well after the first pulse, at which point the estimate will be realistic.  I HOPE!
 void updateExternalClock()
     {
-    if (lastExternalPulseTime > 0)      // we've seen one pulse already
+    if (lastExternalPulseTime == 0)     // our first pulse
+        {
+        externalTracking = false;
+        }
+    else
         {
+        uint32_t elapsed = currentTime - lastExternalPulseTime;
+        int32_t error = (int32_t)(currentTime - externalNextPulseTime);         // positive if the pulse is late
+        uint32_t outlier = externalPeriod >> (EXTERNAL_CLOCK_PERIOD_SHIFT + 3);
+        if (outlier < EXTERNAL_CLOCK_MIN_OUTLIER)
+            outlier = EXTERNAL_CLOCK_MIN_OUTLIER;
+                
+        uint8_t isOutlier = ((uint32_t)(error < 0 ? -error : error) > outlier);
+        if (isOutlier) externalOutliers++;
+        else externalOutliers = 0;
+                
+        if (!externalTracking || externalOutliers >= EXTERNAL_CLOCK_MAX_OUTLIERS)
+            {
+            // start over
+            externalPeriod = elapsed << EXTERNAL_CLOCK_PERIOD_SHIFT;
+            externalNextPulseTime = currentTime + elapsed;
+            externalTracking = true;
+            externalOutliers = 0;
+            }
+        else if (isOutlier)
+            {
+            // ignore it, and expect the next one where we would have anyway
+            externalNextPulseTime += (externalPeriod >> EXTERNAL_CLOCK_PERIOD_SHIFT);
+            }
+        else
+            {
+            externalPeriod += (error >> EXTERNAL_CLOCK_BETA_SHIFT);
+            externalNextPulseTime += (error >> EXTERNAL_CLOCK_ALPHA_SHIFT) + (externalPeriod >> EXTERNAL_CLOCK_PERIOD_SHIFT);
+            }
+            
         // note that we're overwriting the microsecsPerPulse variable.  This will get
         // reset when the user changes the clock setting back to something that's not
         // external (see the case for STATE_OPTIONS_MIDI_CLOCK in TopLevel.cpp)
-        externalMicrosecsPerPulse = currentTime - lastExternalPulseTime;
+        externalMicrosecsPerPulse = (externalPeriod + (1 << (EXTERNAL_CLOCK_PERIOD_SHIFT - 1))) >> EXTERNAL_CLOCK_PERIOD_SHIFT;
         }
     lastExternalPulseTime = currentTime;
     if (lastExternalPulseTime == 0) // not allowed to be 0
@@ -187,12 +316,122 @@ void sendClock(midi::MidiType signal, uint8_t fromButton)
                 (options.clock == USE_MIDI_CLOCK && !fromButton) ||             // allow a send if I'm USING (and passing through) but NOT if the button was pressed
                 (options.clock == GENERATE_MIDI_CLOCK))))           // allow a send if I'm GENERATING AND a button was pressed              
         {
-        MIDI.sendRealTime(signal);
+        queueMIDI(signal, 0, 0, 0);
         TOGGLE_OUT_LED();
         }
     }
 
 
+#ifdef INCLUDE_TIMED_CLOCK
+
+// Has the clock byte for the next pulse been scheduled on Timer3?
+GLOBAL static uint8_t timedClockClaimed = false;
+
+// Is Timer3 still waiting to send the clock byte?
+GLOBAL static volatile uint8_t timedClockArmed = false;
+
+// Has the Timer3 interrupt turned off the serial port's transmit interrupt while it waits for the USART?
+GLOBAL static volatile uint8_t timedClockHeldSerial = false;
+
+// Has a Start, Continue, or Stop gone into the serial port's transmit buffer since it was last empty?
+// If so, Timer3 would send the clock byte ahead of it.
+GLOBAL static uint8_t timedClockBehindRealtime = false;
+
+void setupTimedClock()
+    {
+    TCCR3A = 0;                                         // normal mode, OC3A pin disconnected
+    TCCR3B = _BV(CS31) | _BV(CS30);                     // prescaler 64
+    TIMSK3 = 0;
+    }
+
+ISR(TIMER3_COMPA_vect)
+    {
+    if (UCSR0A & _BV(UDRE0))
+        {
+        UDR0 = (uint8_t) MIDIClock;
+        TIMSK3 = 0;
+        timedClockArmed = false;
+        if (timedClockHeldSerial)
+            {
+            UCSR0B |= _BV(UDRIE0);
+            timedClockHeldSerial = false;
+            }
+        }
+    else
+        {
+        // the USART's sending a byte.  Don't let the serial port load the next one ahead of us.
+        if (UCSR0B & _BV(UDRIE0))
+            {
+            UCSR0B &= ~_BV(UDRIE0);
+            timedClockHeldSerial = true;
+            }
+        OCR3A += (TIMED_CLOCK_RETRY / TIMED_CLOCK_RESOLUTION);
+        }
+    }
+
+size_t MidiSerial::write(uint8_t b)
+    {
+    TIMSK3 = 0;
+    
+    // If the Timer3 interrupt is holding the serial port, Serial.write() could wait forever
+    // for room in a full buffer.  Let it go: the interrupt will hold it again when it retries.
+    if (timedClockHeldSerial)
+        {
+        UCSR0B |= _BV(UDRIE0);
+        timedClockHeldSerial = false;
+        }
+    if (b >= MIDIStart && b <= MIDIStop)
+        timedClockBehindRealtime = true;
+    size_t result = Serial.write(b);
+
+    // Only turn the interrupt back on if it's still waiting to send.  Restoring the old TIMSK3
+    // instead could restart a send the interrupt finished just before we turned it off.
+    if (timedClockArmed)
+        TIMSK3 = _BV(OCIE3A);
+    return result;
+    }
+
+// Tells Timer3 to send a clock byte at the given time, which must be soon
+static void scheduleTimedClock(uint32_t time)
+    {
+    int32_t delay = (int32_t)(time - micros());
+    uint16_t counts = 2;                                // if it's due now, go as soon as we can
+    if (delay > (TIMED_CLOCK_RESOLUTION * 2))
+        counts = ((uint32_t) delay) / TIMED_CLOCK_RESOLUTION;
+
+    uint8_t sreg = SREG;
+    cli();                                              // don't let anything come between reading TCNT3 and setting OCR3A
+    OCR3A = TCNT3 + counts;
+    TIFR3 = _BV(OCF3A);
+    timedClockArmed = true;
+    TIMSK3 = _BV(OCIE3A);
+    SREG = sreg;
+    }
+
+void cancelTimedClock()
+    {
+    uint8_t sreg = SREG;
+    cli();
+    if (timedClockArmed)
+        {
+        TIMSK3 = 0;
+        timedClockArmed = false;
+        if (timedClockHeldSerial)
+            {
+            UCSR0B |= _BV(UDRIE0);
+            timedClockHeldSerial = false;
+            }
+        // the pulse may send it the usual way after all
+        timedClockClaimed = false;
+        }
+    // else it's gone out already, or was never scheduled.  If it's gone out, the pulse
+    // mustn't send it again, so it stays claimed until then.
+    SREG = sreg;
+    }
+
+#endif INCLUDE_TIMED_CLOCK
+
+
 // Gizmo can emit divided-down MIDI clock messages as an option.  This method is called every time 
 // we want to send out a MIDI clock message.  It sends the clock message only every options.clockDivisor
 // times, using an internal countdown called dividePulseCountdown.
@@ -206,6 +445,14 @@ void sendDividedClock()
         if ((options.clock == GENERATE_MIDI_CLOCK || options.clock == MERGE_MIDI_CLOCK) && 
             clockState == CLOCK_STOPPED)
             return;
+#ifdef INCLUDE_TIMED_CLOCK
+        if (timedClockClaimed)
+            {
+            // Timer3 has sent it already, or is about to
+            TOGGLE_OUT_LED();
+            return;
+            }
+#endif INCLUDE_TIMED_CLOCK
         sendClock(MIDIClock, false);
         }
     }
@@ -255,6 +502,9 @@ uint8_t stopClock(uint8_t fromButton)
     if (fromButton && (USING_EXTERNAL_CLOCK() || clockState == CLOCK_STOPPED))
         return 0;
         
+#ifdef INCLUDE_TIMED_CLOCK
+    cancelTimedClock();
+#endif INCLUDE_TIMED_CLOCK
     sendClock(MIDIStop, fromButton);
 
     lastExternalPulseTime = 0;
@@ -264,7 +514,7 @@ uint8_t stopClock(uint8_t fromButton)
 #ifdef INCLUDE_ARPEGGIATOR
     if (application == STATE_ARPEGGIATOR)
         {
-        MIDI.sendControlChange(123, 0, options.channelOut);
+        queueMIDI(MIDIChannelControl, 123, 0, options.channelOut);
         }
     else
 #endif
@@ -272,7 +522,7 @@ uint8_t stopClock(uint8_t fromButton)
 #ifdef INCLUDE_RECORDER
         if (application == STATE_RECORDER)
             {
-            MIDI.sendControlChange(123, 0, options.channelOut);
+            queueMIDI(MIDIChannelControl, 123, 0, options.channelOut);
             }
 #endif
 
@@ -372,6 +622,67 @@ uint8_t continueClock(uint8_t fromButton)
     return 1;
     }     
         
+// Returns the countdown a timer firing every RATE pulses (starting with pulse 0)
+// should have once POSITION pulses have gone by.  It fires when the countdown hits 0.
+static uint8_t countdownAt(uint32_t position, uint8_t rate)
+    {
+    uint8_t remainder = (uint8_t)(position % rate);
+    return (remainder == 0 ? 1 : rate - remainder + 1);
+    }
+
+void setSongPosition(uint16_t beats)
+    {
+    uint32_t position = beats * (uint32_t) SONG_POSITION_PULSES_PER_BEAT;
+        
+    initializeClock();
+    pulseCount = position;
+    if (position > 0)
+        {
+        beatCountdown = countdownAt(position, PULSES_PER_BEAT);
+        dividePulseCountdown = countdownAt(position, options.clockDivisor);
+        notePulseCountdown = countdownAt(position, notePulseRate);
+        
+        // swing falls on every other note pulse, starting with the second
+        if (NOTE_SPEED_SWINGS(options.noteSpeedType))
+            swingToggle = (uint8_t)(((position - 1) / notePulseRate + 1) & 1);
+        }
+    swingTime = 0;
+
+    // Like startClock(), we only tell the applications which restart there.  They
+    // may revise notePulseRate and notePulseCountdown.
+    switch(application)
+        {
+#ifdef INCLUDE_STEP_SEQUENCER
+        case STATE_STEP_SEQUENCER:
+            {
+            seekStepSequencer(position);
+            }
+        break;
+#endif
+#ifdef INCLUDE_DRUM_SEQUENCER
+        case STATE_DRUM_SEQUENCER:
+            {
+            seekDrumSequencer(position);
+            }
+        break;
+#endif
+#ifdef INCLUDE_RECORDER
+        case STATE_RECORDER:
+            {
+            seekRecorder(position);
+            }
+        break;
+#endif
+#ifdef INCLUDE_MEASURE
+        case STATE_MEASURE:
+            {
+            seekMeasure(position);
+            }
+        break;
+#endif
+        }
+    }
+
 // Returns either CLOCK_RUNNING or CLOCK_STOPPED
 
 uint8_t getClockState()
@@ -381,19 +692,22 @@ uint8_t getClockState()
 
 
 ///// SET PULSE RATE
-///// Given a tempo in Beats Per Minute, sets the global variables such that the system issues
+///// Given a tempo in tenths of a Beat Per Minute, sets the global variables such that the system issues
 ///// a PULSE at that rate.
-void setPulseRate(uint16_t bpm)
+void setPulseRate(uint16_t tempo)
     {
-    long currentTime = micros();                // note local variable
+    uint32_t currentTime = micros();            // note local variable
     
     // BPM conversion to usec/pulse:
     // X Beat/Minute * 24 pulses/Beat / 60000000 usec/Minute = Y pulses/usec
     // Then flip
-    // So you have usecs/pulse = 1 / (bpm * 24 / 60000000) = 2500000 / bpm
+    // So you have usecs/pulse = 1 / (bpm * 24 / 60000000) = 2500000 / bpm = 25000000 / tempo
   
     // this division will be costly, but I don't see any way around it.
-    microsecsPerPulse = (((uint32_t) 2500000) / bpm);
+    microsecsPerPulse = (((uint32_t) 25000000) / tempo);
+    pulseRemainder = (uint16_t)(((uint32_t) 25000000) - microsecsPerPulse * tempo);             // saves a second division
+    pulseRemainderDivisor = tempo;
+    pulseRemainderAccumulator = 0;
   
     // update the target pulse time, but don't starve if we're constantly changing the pulse rate
     targetNextPulseTime =  (TIME_GREATER_THAN(targetNextPulseTime - currentTime, microsecsPerPulse) ? currentTime + microsecsPerPulse : targetNextPulseTime);
@@ -454,9 +768,51 @@ void updateTimers()
     // update our internal clock if we're making one
     if (!USING_EXTERNAL_CLOCK())
         {
+#ifdef INCLUDE_TIMED_CLOCK
+        // If the next pulse is coming up and will send a clock byte, hand the byte to Timer3.
+        // This mirrors the tests in sendDividedClock() and sendClock().
+        // It mustn't overtake a Start, Continue, or Stop, whether it's still waiting in the outgoing
+        // MIDI queue or already in the serial port's transmit buffer.
+        if (timedClockBehindRealtime && Serial.availableForWrite() == SERIAL_TX_BUFFER_SIZE - 1)
+            timedClockBehindRealtime = false;
+        if (!timedClockClaimed && !timedClockArmed && !timedClockBehindRealtime && !realtimeMIDIQueued() &&
+            targetNextPulseTime - currentTime <= TIMED_CLOCK_WINDOW &&          // false if it's already overdue
+            dividePulseCountdown == 1 && clockState == CLOCK_RUNNING &&
+            (options.clock == MERGE_MIDI_CLOCK || (options.clock == GENERATE_MIDI_CLOCK && !bypass)))
+            {
+            scheduleTimedClock(targetNextPulseTime);
+            timedClockClaimed = true;
+            }
+#endif INCLUDE_TIMED_CLOCK
+
         if (TIME_GREATER_THAN(currentTime, targetNextPulseTime))                // (currentTime > targetNextPulseTime)
             {
+            uint32_t lateness = currentTime - targetNextPulseTime;
+            if (lateness > TARGET_TICK_TIMESTEP)            // we're normally up to a tick late
+                {
+#ifdef INCLUDE_PROFILER
+                tickStats.latePulses++;
+                if (lateness > tickStats.worstPulseLateness)
+                    tickStats.worstPulseLateness = lateness;
+#endif INCLUDE_PROFILER
+#if (TICK_CATCH_UP == TICK_CATCH_UP_RESYNC)
+                if (lateness >= microsecsPerPulse)
+                    {
+                    // don't burst out the backlog, start over from now
+                    targetNextPulseTime = currentTime;
+#ifdef INCLUDE_PROFILER
+                    tickStats.droppedTime += lateness;
+#endif INCLUDE_PROFILER
+                    }
+#endif
+                }
             targetNextPulseTime += microsecsPerPulse;
+            pulseRemainderAccumulator += pulseRemainder;
+            if (pulseRemainderAccumulator >= pulseRemainderDivisor)
+                {
+                pulseRemainderAccumulator -= pulseRemainderDivisor;
+                targetNextPulseTime++;
+                }
             pulseClock(false);  // note that the 'false' is ignored
             }
         }
@@ -486,11 +842,7 @@ void updateTimers()
 
             notePulseCountdown = notePulseRate;
                         
-            if (options.noteSpeedType == NOTE_SPEED_THIRTY_SECOND || 
-                options.noteSpeedType == NOTE_SPEED_SIXTEENTH ||
-                options.noteSpeedType == NOTE_SPEED_EIGHTH ||
-                options.noteSpeedType == NOTE_SPEED_QUARTER ||
-                options.noteSpeedType == NOTE_SPEED_HALF)
+            if (NOTE_SPEED_SWINGS(options.noteSpeedType))
                 swingToggle = !swingToggle;
             else
                 swingToggle = 0;
@@ -506,5 +858,8 @@ void updateTimers()
             options.clock == GENERATE_MIDI_CLOCK ||
             options.clock == MERGE_MIDI_CLOCK)
             sendDividedClock();
+#ifdef INCLUDE_TIMED_CLOCK
+        timedClockClaimed = false;
+#endif INCLUDE_TIMED_CLOCK
         }
     }
@@ -93,6 +93,52 @@ extern uint32_t tickCount;
 void updateTicksAndWait();
 
 
+//// TICK ACCOUNTING
+////
+//// If go() takes longer than a tick (or the board stalls, say, during an EEPROM save), the next
+//// tick starts late.  With INCLUDE_PROFILER we keep track of how often this happens and how bad
+//// it is in tickStats, and of how far the ticks have drifted from micros() as a result.
+//// What we do about it is the CATCH UP POLICY, set with TICK_CATCH_UP in All.h:
+////
+//// TICK_CATCH_UP_BURST        Don't wait at all until we've caught up, running late ticks back to
+////                            back.  Nothing is lost, but everything after a stall happens in a rush.
+////                            This is the default.
+//// TICK_CATCH_UP_SKIP         Throw away any whole ticks we've missed, staying on the 320us grid.
+//// TICK_CATCH_UP_RESYNC       If we've fallen more than TICK_RESYNC_THRESHOLD behind, start over
+////                            from the current time, and likewise drop any backlog of internal
+////                            clock pulses rather than emitting them in a burst.
+////
+//// Time thrown away by SKIP or RESYNC is added to tickStats.droppedTime.
+
+#define TICK_CATCH_UP_BURST 0
+#define TICK_CATCH_UP_SKIP 1
+#define TICK_CATCH_UP_RESYNC 2
+
+#ifndef TICK_CATCH_UP
+#define TICK_CATCH_UP TICK_CATCH_UP_BURST
+#endif
+
+// 16 ticks, about 5ms
+#define TICK_RESYNC_THRESHOLD (TARGET_TICK_TIMESTEP * 16)
+
+#ifdef INCLUDE_PROFILER
+struct _tickStats
+    {
+    uint32_t lateTicks;                 // ticks which started after their target time
+    uint32_t worstTickLateness;         // in microseconds
+    uint32_t latePulses;                // internal clock pulses which went out more than a tick after their target time
+    uint32_t worstPulseLateness;        // in microseconds
+    uint32_t droppedTime;               // microseconds thrown away by the catch up policy
+    int32_t drift;                      // microseconds micros() has run ahead of TARGET_TICK_TIMESTEP * ticks, negative if behind
+    };
+
+extern struct _tickStats tickStats;
+
+// Clears tickStats
+void resetTickStats();
+#endif INCLUDE_PROFILER
+
+
 
 
 
@@ -113,10 +159,14 @@ extern  uint8_t pulse;
 ///// How fast is our tempo?
 #define MAXIMUM_BPM 999
 
+///// Tempos (such as options.tempo) are in tenths of a Beat Per Minute, so 1200 is 120 BPM
+#define MINIMUM_TEMPO 10                        // 1.0 BPM
+#define MAXIMUM_TEMPO (MAXIMUM_BPM * 10 + 9)    // 999.9 BPM
+
 ///// SET PULSE RATE
-///// Given a tempo in Beats Per Minute, sets the global variables such that the system issues
+///// Given a tempo in tenths of a Beat Per Minute, sets the global variables such that the system issues
 ///// a PULSE at that rate.
-void setPulseRate(uint16_t bpm);
+void setPulseRate(uint16_t tempo);
 
 
 
@@ -144,6 +194,14 @@ extern uint8_t swingToggle;
 // how much time should we delay?
 extern uint32_t swingTime;
 
+// Only these note speeds swing
+#define NOTE_SPEED_SWINGS(noteSpeedType) \
+    ((noteSpeedType) == NOTE_SPEED_THIRTY_SECOND || \
+    (noteSpeedType) == NOTE_SPEED_SIXTEENTH || \
+    (noteSpeedType) == NOTE_SPEED_EIGHTH || \
+    (noteSpeedType) == NOTE_SPEED_QUARTER || \
+    (noteSpeedType) == NOTE_SPEED_HALF)
+
 ///// SET RAW NOTE PULSE RATE
 ///// Given a note speed type (various NOTE_SPEED_* values defined in LEDDisplay.h), sets up
 ///// the global variables such that the system issues a NOTE PULSE at that rate.
@@ -211,6 +269,57 @@ void sendDividedClock();
 void resetDividedClock();
 
 
+//// SONG POSITION
+////
+//// A DAW which continues from the middle of a song first sends a Song Position Pointer while
+//// the clock is stopped, then a Continue.  The position is in MIDI beats (sixteenth notes), that
+//// is, SONG_POSITION_PULSES_PER_BEAT pulses each.  If we're USING or CONSUMING the external clock,
+//// setSongPosition() resets the pulse, note pulse, and beat countdowns as if the clock had run
+//// from Start up to that point, and then asks the current application to seek there.  Each
+//// application's seek function computes its state from the position directly rather than replaying
+//// the notes in between, so the first pulse after the Continue plays what it would have
+//// played had we run from the top.
+
+#define SONG_POSITION_PULSES_PER_BEAT 6
+
+// Moves the clock and the current application to the given Song Position Pointer (in MIDI beats)
+void setSongPosition(uint16_t beats);
+
+
+//// TIMED CLOCK
+////
+//// Normally a generated MIDI clock byte goes out on the first tick after its pulse is due,
+//// and then it may wait in the serial port's transmit buffer behind other bytes.  So it can be
+//// a tick or more late, and how late changes from pulse to pulse.  Drum machines slaved to us 
+//// can flam as a result.
+////
+//// With INCLUDE_TIMED_CLOCK (Mega only), when we're GENERATING or MERGING the clock and the next
+//// pulse is due within TIMED_CLOCK_WINDOW, updateTimers() schedules its clock byte on Timer3, which 
+//// counts in TIMED_CLOCK_RESOLUTION microsecond steps.  The compare match interrupt then writes the
+//// byte straight into the USART at the pulse's exact time, ahead of anything in the transmit buffer 
+//// (MIDI lets realtime bytes go in between the bytes of other messages).  If the USART is busy 
+//// with a byte, we hold off the serial port's own interrupt and try again every TIMED_CLOCK_RETRY 
+//// microseconds, so the clock is never more than one byte (320us) late.  When the pulse itself 
+//// comes round, sendDividedClock() sees the byte has been taken care of and doesn't queue another.
+//// A clock byte mustn't overtake a Start, Continue, or Stop, so while one of those is still waiting
+//// to go out (in the outgoing MIDI queue or the serial port's buffer), the pulse sends it the usual way.
+////
+//// Timer3 is otherwise unused.  Only the clock is sent this way: notes still go out through the
+//// outgoing MIDI queue on tick boundaries.
+
+#ifdef INCLUDE_TIMED_CLOCK
+#define TIMED_CLOCK_WINDOW (TARGET_TICK_TIMESTEP * 2)
+#define TIMED_CLOCK_RESOLUTION 4                        // Timer3 prescaler of 64 at 16MHz
+#define TIMED_CLOCK_RETRY 32
+
+// Starts up Timer3.  Called by setup().
+void setupTimedClock();
+// Stops Timer3 from sending a clock byte it's waiting to send.  Called when the clock stops,
+// or when options.clock changes.
+void cancelTimedClock();
+#endif INCLUDE_TIMED_CLOCK
+
+
 //// Called by go() every iteration to update pulse, note pulse, and beat variables and trigger
 //// stuff.  Does so considering swing and note division.
 void updateTimers();
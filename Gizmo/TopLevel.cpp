@@ -10,7 +10,12 @@
 
 //// SETTING UP MIDI
 
-MIDI_CREATE_DEFAULT_INSTANCE();
+#ifdef INCLUDE_TIMED_CLOCK
+GLOBAL static MidiSerial midiSerial;
+#else
+#define midiSerial Serial
+#endif INCLUDE_TIMED_CLOCK
+MIDI_CREATE_INSTANCE(MidiSerial, midiSerial, MIDI);
 
 ///// COMMON PROGMEM STRINGS
 
@@ -114,10 +119,37 @@ GLOBAL static uint8_t ignoreNextButtonRelease[NUM_BUTTONS] = { false, false, fal
 
 GLOBAL uint16_t pot[NUM_POTS];        // The current pot value OR MIDI controlled value
 GLOBAL uint8_t potUpdated[NUM_POTS];       // has the pot been updated?  CHANGED or NO_CHANGE
-GLOBAL static uint16_t potCurrent[NUM_POTS][3];     // The filtered current pot value
-GLOBAL static uint16_t potCurrentFinal[NUM_POTS];    //  
+GLOBAL static volatile uint16_t potSum[NUM_POTS];           // The sum of the readings so far of each pot
+GLOBAL static volatile uint8_t potCount[NUM_POTS];          // How many readings are in potSum
+GLOBAL static volatile uint16_t potRaw[NUM_POTS];           // The latest sum of POT_OVERSAMPLE readings, 0...4092
+GLOBAL static volatile uint8_t potFresh = 0;                // Bit p is set when potRaw[p] is new since updatePot(p) last looked at it
+GLOBAL static volatile uint8_t potReading = 0;              // The pot the ADC is presently reading
+GLOBAL static int16_t potSmoothed[NUM_POTS];                // The smoothed reading, in eighths of potRaw
+GLOBAL static uint8_t potStill[NUM_POTS];                   // How many fresh readings since the pot last changed, up to POT_STILL
+GLOBAL static int8_t potTrend[NUM_POTS];                    // 1 or -1 if the last reading was at least POT_MEDIUM above or below potSmoothed, else 0
 GLOBAL static uint16_t potLast[NUM_POTS];     // The last pot value submitted 
 
+/// The ADC channel for each pot
+#ifdef INCLUDE_MEGA_POTS
+GLOBAL static const uint8_t potChannel[NUM_POTS] PROGMEM = { 0, 1, 14, 15 };   // A0, A1, A14, A15
+#else
+GLOBAL static const uint8_t potChannel[NUM_POTS] PROGMEM = { 0, 1, 2, 3 };     // A0, A1, A2, A3
+#endif INCLUDE_MEGA_POTS
+
+// Starts the ADC reading the given pot
+static void startPotConversion(uint8_t p)
+    {
+    uint8_t channel = pgm_read_byte(&potChannel[p]);
+    ADMUX = _BV(REFS0) | (channel & 0x07);          // AVcc reference, as analogRead() uses by default
+#ifdef MUX5
+    if (channel & 0x08)
+        ADCSRB |= _BV(MUX5);
+    else
+        ADCSRB &= ~_BV(MUX5);
+#endif
+    ADCSRA |= _BV(ADSC);
+    }
+
 void setExtraButton(uint8_t n, uint8_t val)
     {
     if (val)
@@ -137,14 +169,25 @@ uint8_t getExtraButton(uint8_t n)
 
 
 // SETUP POTS
-// initializes the pots
+// initializes the pots, and hands the ADC over to them.  Don't call analogRead() after this.
 void setupPots()
     {
-    memset(potCurrent, 0, NUM_POTS * 3);
-    memset(potUpdated, NO_CHANGE, NUM_POTS);
-    memset(pot, 0, NUM_POTS);
-    memset(potCurrentFinal, 0, NUM_POTS);
-    memset(potLast, 0, NUM_POTS);
+    memset((void*)potSum, 0, sizeof(potSum));
+    memset((void*)potCount, 0, sizeof(potCount));
+    memset((void*)potRaw, 0, sizeof(potRaw));
+    memset(potSmoothed, 0, sizeof(potSmoothed));
+    memset(potStill, 0, sizeof(potStill));
+    memset(potTrend, 0, sizeof(potTrend));
+    memset(potUpdated, NO_CHANGE, sizeof(potUpdated));
+    memset(pot, 0, sizeof(pot));
+    memset(potLast, 0, sizeof(potLast));
+    potFresh = 0;
+    
+    // enable the ADC and its interrupt, with a prescaler of 128 (as analogRead() uses),
+    // and start reading the pots
+    ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+    potReading = 0;
+    startPotConversion(0);
     }
 
 //// Clears the 'released' and 'released long' flag on all buttons.
@@ -220,48 +263,126 @@ void updateButtons(uint8_t buttonPressed[])
     }
 
 
-/// Gets the new value of a pot and sets it into pot.  Returns CHANGED or NO_CHANGE.
-/// potCurrent is an array of the most recent three calls to analogRead for the pot.  It's
-/// used to do a median filter.
-//  VARIABLES:
-//  pot                                 Where to store the resulting value
-//  potCurrent                  An array of three numbers which will store the most recent three calls to analogRead()
-//  potCurrentFinal             A value which will store the most recent smoothed estimate produced by potCurrent
-//  potLast                             A value which will hold the PREVIOUS smoothed estimate produced by potCurrent
-//  analog                              The analog pin to read via analogRead(analog)
+/// READING THE POTS
+//  analogRead() blocks for about 110us, so we don't use it.  Instead the ADC runs
+//  continuously in the background, reading each pot in turn: when a reading is done,
+//  the ADC interrupt adds it to that pot's sum and starts reading the next pot.  Every
+//  POT_OVERSAMPLE readings, the sum is handed over to updatePot() in potRaw.  That's
+//  a reading every 104us, so each pot gets a new potRaw about every 1.7ms.
 //
-//  RETURNED: CHANGED or NO CHANGED, depending if potCurrentFinal and potLast are sufficiently different from
-//            one another to assume that the pot is being changed by the user
+//  updatePot() then cleans up potRaw as follows:
+//
+//  1. Smoothing.  We move potSmoothed towards potRaw, quickly if they're far apart
+//     (the pot is being turned fast, and we don't want to lag behind) and slowly 
+//     if they're close (it's probably just noise).  A single reading can be some way
+//     off just from noise, so we only move half way if two readings in a row are 
+//     off in the same direction.
+//
+//  2. Hysteresis.  The pot value is potSmoothed / 4, that is, 0...1023.  But we only
+//     change it if potSmoothed has moved past the edge of the current value by
+//     a margin.  While the pot is being turned the margin is small, so we get every
+//     value on the way.  Once the pot has been left alone for POT_STILL readings, the
+//     margin grows to POT_STILL_HYSTERESIS, so noise doesn't make it wander.  0 and
+//     1023 can always be reached: noise can't push a reading past the ends, so a pot
+//     turned all the way averages a little short of them, and we round the last 
+//     POT_END of potSmoothed at either end off to the end.
+//
+//  With readings jittering by +/- 2 (one standard deviation) the pot value doesn't
+//  wander at all when left alone, and when swept end to end in a second it lags 
+//  behind by at most 10.  See host/bench/PotBench.cpp.
+//
+//  We used to do a median of three and a half/half average, and required the pot to
+//  move MINIMUM_POT_DEVIATION (8) before we'd believe it, which left the pots with a
+//  realistic resolution of 1024 / 8 = 128.  Now they have all 10 bits.
+
+#define POT_OVERSAMPLE 4
+#define POT_FAST 64                     // at or beyond this distance (in units of potRaw) we jump right to the reading
+#define POT_MEDIUM 16                   // at or beyond this distance twice in a row we move half way
+                                        // otherwise we move 1/8 of the way
+#define POT_STILL 64                    // about 1/10 second
+#define POT_MOVING_HYSTERESIS 1         // in units of potRaw, that is, 1/4 of a pot value
+#define POT_STILL_HYSTERESIS 4
+#define POT_END 8                       // potSmoothed this close to either end counts as the end
+
+
+// Adds the reading just taken of pot potReading to its sum, then moves on to the next pot.
+ISR(ADC_vect)
+    {
+    uint8_t p = potReading;
+    uint16_t sum = potSum[p] + ADC;
+    uint8_t count = potCount[p] + 1;
+    if (count == POT_OVERSAMPLE)
+        {
+        potRaw[p] = sum;
+        potFresh |= (1 << p);
+        sum = 0;
+        count = 0;
+        }
+    potSum[p] = sum;
+    potCount[p] = count;
+
+    p++;
+    if (p == NUM_POTS) p = 0;
+    potReading = p;
+    startPotConversion(p);
+    }
 
-uint8_t updatePot(uint16_t &pot, uint16_t* potCurrent, uint16_t &potCurrentFinal, uint16_t& potLast, uint8_t analog)
+/// Sets the latest filtered value of pot p into pot[p] if it's changed.  
+/// Returns CHANGED or NO_CHANGE.
+
+static uint8_t updatePot(uint8_t p)
     {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t raw = potRaw[p];
+    uint8_t fresh = potFresh & (1 << p);
+    potFresh &= ~(1 << p);
+    SREG = sreg;
     
-    // we clean up the pots as follows:
-    // 1. Run it through a median of three filter
-    // 2. potCurrentFinal <- 1/2 potCurrentFinal + 1/2 result from #1
-    // 3. If potCurrentFinal differs from its old value by at least MINIMUM_POT_DEVIATION (8), then we have a new pot value.
+    if (!fresh) 
+        return NO_CHANGE;
     
-    // This implies that the pots have a realistic resolution of 1024 / 8 = 128.
-    // The biggest range that we need to dial in is 2^14 = 16384.
-    // This means that the RIGHT POT must have a resolution of at least 128, since 128 * 128 = 16384.
+    // 1. Smoothing
+    int16_t x = raw << 3;
+    int16_t d = x - potSmoothed[p];
+    int16_t distance = (d < 0 ? -d : d);
+    int8_t trend = (distance < (POT_MEDIUM << 3) ? 0 : (d < 0 ? -1 : 1));
+    if (distance >= (POT_FAST << 3))
+        potSmoothed[p] = x;
+    else if (trend != 0 && trend == potTrend[p])
+        potSmoothed[p] += d / 2;
+    else
+        potSmoothed[p] += (d + 4) >> 3;
+    potTrend[p] = trend;
     
-    // I'd like MINIMUM_POT_DEVIATION to be 4, but it's just too noisy.  :-(
- 
-    potCurrent[0] = potCurrent[1];
-    potCurrent[1] = potCurrent[2];
-    potCurrent[2] = analogRead(analog);
-    uint16_t middle = MEDIAN_OF_THREE(potCurrent[0], potCurrent[1], potCurrent[2]);
-    if (middle == 1023)         // we handle this exceptional condition because otherwise potCurrentFinal would never be >= 1022, due to the division.
-        potCurrentFinal = middle;
-    else potCurrentFinal = (potCurrentFinal + middle) / 2;
-    // test to see if we're really turning the knob
-    if (potLast != potCurrentFinal && 
-            (potLast > potCurrentFinal && potLast - potCurrentFinal >= MINIMUM_POT_DEVIATION ||
-            potCurrentFinal > potLast && potCurrentFinal - potLast >= MINIMUM_POT_DEVIATION ||
-            potCurrentFinal == 1023 || //potCurrentFinal == 1023 - MINIMUM_POT_DEVIATION ||             // handle boundary condition    -- NOTE: too noisy.  I've removed it and mentioned it in the manual.
-            potCurrentFinal == 0 )) //potCurrentFinal <= MINIMUM_POT_DEVIATION))             // handle boundary condition
-        { potLast = potCurrentFinal; pot = potCurrentFinal; return CHANGED; }
-    else return NO_CHANGE;
+    // 2. Hysteresis
+    uint16_t smoothed = (potSmoothed[p] + 4) >> 3;       // 0...4092
+    uint16_t target = smoothed >> 2;                    // 0...1023
+    if (smoothed < POT_END) target = 0;
+    else if (smoothed > 4092 - POT_END) target = 1023;
+    uint16_t last = potLast[p];
+    uint8_t hysteresis = (potStill[p] >= POT_STILL ? POT_STILL_HYSTERESIS : POT_MOVING_HYSTERESIS);
+    if (target != last && 
+            ((target > last && smoothed >= ((last + 1) << 2) + hysteresis) ||   // past the top edge of last
+            (target < last && smoothed + hysteresis < (last << 2)) ||           // past the bottom edge of last
+            target == 1023 || 
+            target == 0))
+        { 
+        // A single step from a still pot is probably just a slow turn, or noise
+        // which got past the hysteresis.  Either way, it isn't a reason to drop the
+        // hysteresis and let more noise in.
+        if (potStill[p] < POT_STILL || target > last + 1 || target + 1 < last)
+            potStill[p] = 0;
+        potLast[p] = target; 
+        pot[p] = target; 
+        return CHANGED; 
+        }
+    else
+        {
+        if (potStill[p] < POT_STILL) 
+            potStill[p]++;
+        return NO_CHANGE;
+        }
     }
 
 
@@ -312,7 +433,6 @@ GLOBAL unsigned char led2[LED_WIDTH];
 /// When this is set, turning the pots won't affect anything.
 /// Pressing a button unlocks the pots.
 GLOBAL uint8_t lockoutPots = 0;
-GLOBAL uint8_t scheduleScreenBrightnessUpdate = 0;
 
 uint8_t update()
     {
@@ -346,13 +466,9 @@ uint8_t update()
             {
 #ifndef HEADLESS
             if (!lockoutPots)
-                potUpdated[LEFT_POT] = updatePot(pot[LEFT_POT], potCurrent[LEFT_POT], potCurrentFinal[LEFT_POT], potLast[LEFT_POT], A0);
+                potUpdated[LEFT_POT] = updatePot(LEFT_POT);
 #endif // HEADLESS
-#ifdef INCLUDE_MEGA_POTS
-            potUpdated[A2_POT] = updatePot(pot[A2_POT], potCurrent[A2_POT], potCurrentFinal[A2_POT], potLast[A2_POT], A14);
-#else
-            potUpdated[A2_POT] = updatePot(pot[A2_POT], potCurrent[A2_POT], potCurrentFinal[A2_POT], potLast[A2_POT], A2);
-#endif INCLUDE_MEGA_POTS
+            potUpdated[A2_POT] = updatePot(A2_POT);
             return 0;  // don't update the display
             }
         break;
@@ -360,13 +476,9 @@ uint8_t update()
             {
 #ifndef HEADLESS
             if (!lockoutPots)
-                potUpdated[RIGHT_POT] = updatePot(pot[RIGHT_POT], potCurrent[RIGHT_POT], potCurrentFinal[RIGHT_POT], potLast[RIGHT_POT], A1);
+                potUpdated[RIGHT_POT] = updatePot(RIGHT_POT);
 #endif // HEADLESS
-#ifdef INCLUDE_MEGA_POTS
-            potUpdated[A3_POT] = updatePot(pot[A3_POT], potCurrent[A3_POT], potCurrentFinal[A3_POT], potLast[A3_POT], A15);
-#else
-            potUpdated[A3_POT] = updatePot(pot[A3_POT], potCurrent[A3_POT], potCurrentFinal[A3_POT], potLast[A3_POT], A3);      
-#endif INCLUDE_MEGA_POTS
+            potUpdated[A3_POT] = updatePot(A3_POT);
             return 0;  // don't update the display
             }
         break;  
@@ -374,23 +486,14 @@ uint8_t update()
             {
             // we'll only update the screen every 32 times.  This is
             // a refresh rate of about 100 times a sec.  It's also enough
-            // to approximately display 999 beats per second. Perhaps we might
-            // do other I2C stuff as well for the other times
+            // to approximately display 999 beats per second.
             if ((tickCount & 31) == 31)
                 return 1;  // update the display
-            // off-sync with the screen update, we will update the screen brightness
-            // if it's been requested.  This is because it's an I2C operation
-            // and can be costly if called many times in sequence. 
-            // At present screen brightness change is NONblocking
-            else if (scheduleScreenBrightnessUpdate && ((tickCount & 31) == 15))
-                {
-                setScreenBrightness(options.screenBrightness);
-                scheduleScreenBrightnessUpdate = 0;
-                }
             return 0;
             }
         break;
         }
+    return 0;
     }
   
 
@@ -401,6 +504,7 @@ void semiReset()
     {
     resetOptions();
     saveOptions();
+    finishSaving();         // before we reboot
     }
 
 
@@ -410,12 +514,7 @@ void semiReset()
 
 void fullReset()
     {
-    for(uint8_t i = 0; i < NUM_SLOTS; i++)
-        {
-        loadSlot(i);
-        data.slot.type = SLOT_TYPE_EMPTY;
-        saveSlot(i);
-        }
+    clearSlots();
   
     for(uint8_t i = 0; i < NUM_ARPS; i++)
         {
@@ -464,7 +563,17 @@ void writeFooterAndSend()
             setPoint(led, 0, 0);
             }
         }
+    
+    // show how far along a background save is, along the bottom of the left screen
+    if (isSaving())
+        {
+        uint8_t progress = getSaveProgress(LED_WIDTH - 1);
+        for(uint8_t i = 0; i <= progress; i++)
+            setPoint(led2, i, 0);
+        }
+    PROFILE_START(profileSendMatrix);
     sendMatrix(led, led2);
+    PROFILE_STOP(profileSendMatrix, PROFILE_SEND_MATRIX);
     }
 
 
@@ -555,23 +664,46 @@ void checkForClockStartStop()
 
 void go()
     {
-    MIDI.read();
+    PROFILE_START(profileGo);
+    
+    // push out anything which didn't fit last time
+    writeMIDI();
+    
+    PROFILE_START(profileMidiRead);
+    readMIDI();
+    PROFILE_STOP(profileMidiRead, PROFILE_MIDI_READ);
     
     for(uint8_t i = 0; i < 3; i++)
         if (buttonPressedCountdown[i] > 0) 
             buttonPressedCountdown[i]--;
 
+    PROFILE_START(profileUpdateTimers);
     updateTimers();
+    updateScheduledNoteOffs();
+    PROFILE_STOP(profileUpdateTimers, PROFILE_UPDATE_TIMERS);
 
     // update the screen, read from the sensors, or update the board LEDs
+    PROFILE_START(profileUpdate);
     updateDisplay = update();
+    PROFILE_STOP(profileUpdate, PROFILE_UPDATE);
+    
+    // prefetching reads from the EEPROM, so it goes before saving starts another write
+    updatePrefetching();
+    updateSaving();
     
     if (isUpdated(BACK_BUTTON, RELEASED_LONG))
         {
         toggleBypass(CHANNEL_OMNI);
         }
 
-    // Now do your state-specific thing
+#ifdef INCLUDE_PROFILER
+    uint8_t profiledState = state;
+    uint8_t profiledEntry = entry;
+#endif INCLUDE_PROFILER
+    PROFILE_START(profileState);
+    
+    // Now do your state-specific thing.  The states are numbered consecutively, and only
+    // the ones compiled in exist, so the compiler turns this switch into a jump table.
     switch(state)
         {
         case STATE_ROOT:
@@ -641,7 +773,7 @@ void go()
         case STATE_CONTROLLER:
             {
             if (entry)
-                MIDI.sendRealTime(MIDIClock);
+                queueMIDI(MIDIClock, 0, 0, 0);
             const char* menuItems[9] = { PSTR("GO"), PSTR("L KNOB"), PSTR("R KNOB"), PSTR("M BUTTON"), PSTR("R BUTTON"), PSTR("WAVE"), PSTR("RANDOM"), PSTR("A2"), PSTR("A3"),  };
             doMenuDisplay(menuItems, 9, STATE_CONTROLLER_PLAY, STATE_ROOT, 1);
             }
@@ -729,14 +861,15 @@ void go()
             checkForClockStartStop();
                         
 #if defined(__MEGA__)
-            const char* menuItems[16] = { PSTR("TEMPO"), PSTR("NOTE SPEED"), PSTR("SWING"), PSTR("TRANSPOSE"), 
+            const char* menuItems[17] = { PSTR("TEMPO"), PSTR("NOTE SPEED"), PSTR("SWING"), PSTR("TRANSPOSE"), 
                                           PSTR("VOLUME"), PSTR("LENGTH"), PSTR("IN MIDI"), PSTR("OUT MIDI"), PSTR("CONTROL MIDI"), PSTR("CLOCK"), PSTR("DIVIDE"),
                                           ((options.click == NO_NOTE) ? PSTR("CLICK") : PSTR("NO CLICK")),
                                           PSTR("BRIGHTNESS"), 
                                           PSTR("MENU DELAY"),
                                           PSTR("AUTO RETURN"),
+                                          PSTR("RUNNING STATUS"),
                                           PSTR("GIZMO V6 (C) 2018 SEAN LUKE") };
-            doMenuDisplay(menuItems, 16, STATE_OPTIONS_TEMPO, immediateReturnState, 1);
+            doMenuDisplay(menuItems, 17, STATE_OPTIONS_TEMPO, immediateReturnState, 1);
 #endif
 #if defined(__UNO__)
             const char* menuItems[11] = { PSTR("TEMPO"), PSTR("NOTE SPEED"), PSTR("SWING"), 
@@ -860,7 +993,7 @@ void go()
         case STATE_STEP_SEQUENCER_MIDI_CHANNEL_OUT:
             {
             if (entry)
-                clearNotesOnTracks(true);
+                clearNotesOnTracks();
                 
             // 17 represents DEFAULT channel
             uint8_t val = stateNumerical(0, 17, local.stepSequencer.outMIDI[local.stepSequencer.currentTrack], local.stepSequencer.backup, false, true, GLYPH_DEFAULT, 
@@ -905,6 +1038,12 @@ void go()
             playStepSequencer();
             }
         break;
+        case STATE_STEP_SEQUENCER_CANT:
+            {
+            stateCant(STATE_STEP_SEQUENCER_PLAY);
+            playStepSequencer();
+            }
+        break;
 #ifdef INCLUDE_ADVANCED_STEP_SEQUENCER
         case STATE_STEP_SEQUENCER_MENU_TYPE:
             {
@@ -1029,8 +1168,8 @@ void go()
         break;
         case STATE_DRUM_SEQUENCER_TRACK:
             {
-            const char* menuItems[7] = { PSTR("VELOCITY"), PSTR("OUT MIDI"), PSTR("COPY WHOLE"), PSTR("SWAP WHOLE"),  PSTR("DISTRIBUTE"), PSTR("ACCENT"), PSTR("DEFAULT VELOCITY") };
-            doMenuDisplay(menuItems, 7, STATE_DRUM_SEQUENCER_TRACK_VELOCITY, immediateReturn ? immediateReturnState : STATE_DRUM_SEQUENCER_MENU, 1);
+            const char* menuItems[8] = { PSTR("VELOCITY"), PSTR("OUT MIDI"), PSTR("COPY WHOLE"), PSTR("SWAP WHOLE"),  PSTR("DISTRIBUTE"), PSTR("ACCENT"), PSTR("DEFAULT VELOCITY"), PSTR("SPEED") };
+            doMenuDisplay(menuItems, 8, STATE_DRUM_SEQUENCER_TRACK_VELOCITY, immediateReturn ? immediateReturnState : STATE_DRUM_SEQUENCER_MENU, 1);
             playDrumSequencer();
             }
         break;
@@ -1121,6 +1260,11 @@ void go()
             stateDrumSequencerMenuDefaultVelocity();
             }
         break;
+        case STATE_DRUM_SEQUENCER_TRACK_SPEED:
+            {
+            stateDrumSequencerTrackSpeed();
+            }
+        break;
         case STATE_DRUM_SEQUENCER_TRACK_PITCH:
             {
             stateDrumSequencerPitch();
@@ -1267,6 +1411,11 @@ void go()
             stateSave(STATE_RECORDER_PLAY);
             }
         break;
+        case STATE_RECORDER_CANT:
+            {
+            stateCant(STATE_RECORDER_PLAY);
+            }
+        break;
         case STATE_RECORDER_EXIT:
             {
             stateExit(STATE_RECORDER_PLAY, STATE_RECORDER);
@@ -1488,8 +1637,8 @@ void go()
                 if (lastTempoTapTime != 0)
                     {
                     // BPM = 1/(min/beat).  min/beat = micros/beat *  sec / 1000000 micros * min / 60 sec
-                    // So BPM = 60000000 / micros 
-                    uint16_t newTempo = (uint16_t)(60000000L / (currentTime - lastTempoTapTime));
+                    // So BPM = 60000000 / micros, and our tempo (in tenths of a BPM) is 600000000 / micros
+                    uint32_t newTempo = 600000000L / (currentTime - lastTempoTapTime);
 
                     // fold into options.tempo as a smoothing effort. 
                     // Note that we increase newTempo by one
@@ -1498,7 +1647,7 @@ void go()
                     // <= options.tempo because we'd truncate DOWN to newTempo in this case.
                     if (options.tempo < newTempo)
                         newTempo = newTempo + 1;
-                    options.tempo = max(min(((options.tempo + newTempo) >> 1), 999), 1);  // saves a tiny bit of code space!
+                    options.tempo = max(min(((options.tempo + newTempo) >> 1), MAXIMUM_TEMPO), MINIMUM_TEMPO);  // saves a tiny bit of code space!
 
                     setPulseRate(options.tempo);
                     entry = true;
@@ -1509,7 +1658,14 @@ void go()
             // at this point, MIDDLE_BUTTON shouldn't have any effect on doNumericalDisplay (incrementing it)
             // because it's been consumed.
             
-            uint8_t result = doNumericalDisplay(1, MAXIMUM_BPM, options.tempo, 0, GLYPH_NONE);
+            // The left pot sweeps across the whole range in roughly 1 BPM steps, and the
+            // right pot fine-tunes it by up to 6.4 BPM in either direction
+            uint8_t result = doNumericalDisplay(MINIMUM_TEMPO, MAXIMUM_TEMPO, options.tempo, 0, GLYPH_NONE);
+            if (updateDisplay)
+                {
+                // decimal point before the tenths digit
+                setPoint(led, 4, 3);
+                }
             switch (result)
                 {
                 case NO_MENU_SELECTED:
@@ -1730,7 +1886,12 @@ void go()
                     {
                     // this hopefully clears up notes that sometimes get stuck when we change the clock mode
                     if (options.clock != currentDisplay)
+                        {
+#ifdef INCLUDE_TIMED_CLOCK
+                        cancelTimedClock();             // we may not be generating the clock any more
+#endif INCLUDE_TIMED_CLOCK
                         sendAllSoundsOff();
+                        }
                     options.clock = currentDisplay;
                     }
                 break;
@@ -1747,6 +1908,10 @@ void go()
                 // Else FALL THRU
                 case MENU_CANCELLED:
                     {
+#ifdef INCLUDE_TIMED_CLOCK
+                    if (options.clock != backupOptions.clock)
+                        cancelTimedClock();             // likewise, since the old setting is about to come back
+#endif INCLUDE_TIMED_CLOCK
                     goUpStateWithBackup(STATE_OPTIONS);
                     }
                 break;
@@ -1809,11 +1974,8 @@ void go()
                 case NO_MENU_SELECTED:
                     {
                     options.screenBrightness = currentDisplay - 1;
-                    // if it's set to blocking, setScreenBrightness is too slow and it causes
-                    // us to quickly get out of sync with our clock.  So we make setScreenBrightness
-                    // non-blocking and so we also do it only once every 32 times, off-sync 
-                    // with the screen.
-                    scheduleScreenBrightnessUpdate = 1;
+                    // this is just queued (see LEDDisplay.cpp), so it's cheap to do every time
+                    setScreenBrightness(options.screenBrightness);
                     }
                 break;
                 case MENU_SELECTED:
@@ -1884,9 +2046,44 @@ void go()
             playApplication();
             }
         break;
+        case STATE_OPTIONS_RUNNING_STATUS:
+            {
+            uint8_t result;
+            if (entry) 
+                {
+                backupOptions = options; 
+                defaultMenuValue = options.midiOutRunningStatus;  // so we display the right thing
+                }
+            const char* menuItems[3] = { PSTR("ON"), PSTR("NOTE OFF AS NOTE ON"), PSTR("OFF") };
+            result = doMenuDisplay(menuItems, 3, STATE_NONE, STATE_NONE, 1);
+            switch (result)
+                {
+                case NO_MENU_SELECTED:
+                    {
+                    options.midiOutRunningStatus = currentDisplay;
+                    }
+                break;
+                case MENU_SELECTED:
+                    {
+                    saveOptions();
+                    }
+                // Else FALL THRU
+                case MENU_CANCELLED:
+                    {
+                    goUpStateWithBackup(STATE_OPTIONS);
+                    }
+                break;
+                }
+            playApplication();     
+            }
+        break;
         case STATE_OPTIONS_ABOUT:
             {
+#ifdef INCLUDE_PROFILER
+            stateProfile();
+#else
             goUpState(STATE_OPTIONS);
+#endif INCLUDE_PROFILER
             playApplication();
             }
         break;
@@ -2026,6 +2223,8 @@ void go()
         // END SWITCH       
         }
         
+    PROFILE_STOP_STATE(profileState, profiledState, profiledEntry);
+        
     // consume the pulses
     pulse = 0;
     if (notePulse == 1)
@@ -2050,6 +2249,8 @@ void go()
     
     // clear the pots
     potUpdated[LEFT_POT] = potUpdated[RIGHT_POT] = NO_CHANGE;
+    
+    PROFILE_STOP(profileGo, PROFILE_GO);
     }
 
 
@@ -103,6 +103,7 @@ typedef enum _State: uint8_t
 	STATE_STEP_SEQUENCER_NOTE_LENGTH,
 	STATE_STEP_SEQUENCER_EXIT,
 	STATE_STEP_SEQUENCER_SAVE,
+	STATE_STEP_SEQUENCER_CANT,
 #ifdef INCLUDE_ADVANCED_STEP_SEQUENCER
 	STATE_STEP_SEQUENCER_MENU_TYPE,
 	STATE_STEP_SEQUENCER_MENU_TYPE_PARAMETER,
@@ -143,6 +144,7 @@ typedef enum _State: uint8_t
 	STATE_DRUM_SEQUENCER_TRACK_DISTRIBUTE,
 	STATE_DRUM_SEQUENCER_TRACK_ACCENT,
 	STATE_DRUM_SEQUENCER_TRACK_DEFAULT_VELOCITY,
+	STATE_DRUM_SEQUENCER_TRACK_SPEED,
 	STATE_DRUM_SEQUENCER_TRACK_PITCH,
 	STATE_DRUM_SEQUENCER_TRACK_PITCH_BACK,
 	STATE_DRUM_SEQUENCER_GROUP_LENGTH,
@@ -176,6 +178,7 @@ typedef enum _State: uint8_t
 	STATE_RECORDER_FORMAT,
 	STATE_RECORDER_PLAY,
 	STATE_RECORDER_SAVE,
+	STATE_RECORDER_CANT,
 	STATE_RECORDER_EXIT,
 	STATE_RECORDER_MENU,
 #endif
@@ -238,6 +241,7 @@ typedef enum _State: uint8_t
 	STATE_OPTIONS_SCREEN_BRIGHTNESS,
 	STATE_OPTIONS_MENU_DELAY,
 	STATE_OPTIONS_AUTO_RETURN,
+	STATE_OPTIONS_RUNNING_STATUS,
 	STATE_OPTIONS_ABOUT,
 
 #ifdef INCLUDE_SPLIT
@@ -271,6 +275,8 @@ typedef enum _State: uint8_t
 	STATE_SYNTH_KORG_MICROSAMPLER,
 	STATE_SYNTH_YAMAHA_TX81Z,
 #endif
+
+	NUM_STATES		// not a state: this must stay last
 	} State;
 
 
@@ -431,9 +437,6 @@ extern unsigned char led2[LED_WIDTH];
 
 
 
-// Set this to schedule the screen brightness to be revised (because this is
-// costly and shouldn't be done constantly in response to, say, turning a pot).
-extern uint8_t scheduleScreenBrightnessUpdate;
 
 
 
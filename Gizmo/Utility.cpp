@@ -893,7 +893,8 @@ void stateSave(uint8_t backState)
                             distributeByte(pos + 23, local.stepSequencer.pattern[i] << 4);
                             }
                         }
-                    saveSlot(currentDisplay);
+                    if (!saveSlot(currentDisplay))     // out of room
+                        backState = STATE_STEP_SEQUENCER_CANT;
                     stripHighBits();                        
                     }
                 break;
@@ -901,7 +902,8 @@ void stateSave(uint8_t backState)
 #ifdef INCLUDE_RECORDER
                 case STATE_RECORDER:
                     {
-                    saveSlot(currentDisplay);
+                    if (!saveSlot(currentDisplay))     // out of room
+                        backState = STATE_RECORDER_CANT;
                     }
                 break;
 #endif INCLUDE_RECORDER
@@ -909,7 +911,8 @@ void stateSave(uint8_t backState)
                 case STATE_DRUM_SEQUENCER:
                     {
                     packDrumSequenceData();
-                    saveSlot(currentDisplay);
+                    if (!saveSlot(currentDisplay))     // out of room
+                        backState = STATE_DRUM_SEQUENCER_CANT;
                     }
                 break;
 #endif INCLUDE_DRUM_SEQUENCER
@@ -1086,7 +1089,7 @@ void stateExit(uint8_t cancelState, uint8_t exitState)
     if (isUpdated(BACK_BUTTON, RELEASED))
         {
         // send ALL NOTES OFF
-        MIDI.sendControlChange(123, 0, options.channelOut);
+        queueMIDI(MIDIChannelControl, 123, 0, options.channelOut);
         
         goUpState(exitState);
         defaultState = cancelState;
@@ -1138,6 +1141,7 @@ uint8_t stateEnterNote(uint8_t backState)
     if (entry)
         {
         newItem = 0;            // clear any current note
+        clearMIDIQueue();       // ...and any waiting behind it
         clearScreen();
         write3x5Glyphs(GLYPH_NOTE);
         entry = false;
@@ -1172,6 +1176,7 @@ uint8_t stateEnterChord(uint8_t* chord, uint8_t maxChordNotes, uint8_t backState
     if (entry)
         {
         newItem = 0;            // clear any current note
+        clearMIDIQueue();       // ...and any waiting behind it
         clearScreen();
         write3x5Glyphs(GLYPH_CHORD);
         entry = false;
@@ -1373,22 +1378,15 @@ void drawMIDIChannel(uint8_t channel)
     }
 
 
-GLOBAL static uint8_t clickNote = NO_NOTE;
-        
+GLOBAL uint8_t clickNoteOff;
+
 void doClick()
     {
-    // turn off previous click
-    if (pulse && (clickNote != NO_NOTE))
-        {
-        sendNoteOff(clickNote, 127, options.channelOut);
-        clickNote = NO_NOTE;
-        }
-                
-    // turn on new click
+    // turn on new click, and turn it off a pulse later
     if (beat && (options.click != NO_NOTE))
         {
         sendNoteOn(options.click, options.clickVelocity, options.channelOut);
-        clickNote = options.click;
+        scheduleNoteOff(clickNoteOff, options.click, options.channelOut, currentTime + getMicrosecsPerPulse());
         }
     }
 
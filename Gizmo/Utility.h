@@ -114,7 +114,11 @@ uint8_t doMenuDisplay(const char** _menu, uint8_t menuLen, uint8_t baseState, ui
 // every time the function is called, as it is immediately reset to NO_GLYPH
 // afterwards.
 
+#ifdef INCLUDE_COMPRESSED_SLOTS
+#define MAX_GLYPHS 15			// at least NUM_SLOTS
+#else
 #define MAX_GLYPHS 11
+#endif INCLUDE_COMPRESSED_SLOTS
 extern uint8_t glyphs[MAX_GLYPHS];
 extern uint8_t secondGlyph;
 
@@ -186,6 +190,9 @@ uint8_t debug(int8_t val1, int8_t val2);
 /// Indicates no note (in various contexts)
 #define NO_NOTE 128
 
+// The note off entry reserved for the click (see Scheduler.h)
+extern uint8_t clickNoteOff;
+
 // perform a click track
 void doClick();
 
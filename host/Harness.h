@@ -0,0 +1,117 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HARNESS_H__
+#define __HARNESS_H__
+
+////// HARNESS
+//////
+////// A few helpers shared by the tests and benchmarks: booting Gizmo in the simulator,
+////// collecting what it sends, and checking results.
+
+#include "Simulator.h"
+#include "All.h"
+#include <stdio.h>
+
+#define HARNESS_MAX_OUT 65536
+
+struct HarnessByte
+    {
+    uint64_t time;
+    uint8_t b;
+    };
+
+/// The MIDI bytes sent since the last harnessClearOut()
+static HarnessByte harnessOut[HARNESS_MAX_OUT];
+static uint32_t harnessNumOut;
+static uint8_t harnessStatus;               // the running status in effect at harnessOut[0]
+static uint8_t harnessLastStatus;           // the running status after the last byte sent
+static uint32_t harnessFailures;
+
+static inline void harnessMIDIOut(uint64_t time, uint8_t b)
+    {
+    if (b >= 0x80 && b < 0xF8)
+        harnessLastStatus = (b < 0xF0 ? b : 0);
+    if (harnessNumOut < HARNESS_MAX_OUT)
+        {
+        harnessOut[harnessNumOut].time = time;
+        harnessOut[harnessNumOut].b = b;
+        harnessNumOut++;
+        }
+    }
+
+static inline void harnessClearOut()
+    {
+    harnessNumOut = 0;
+    harnessStatus = harnessLastStatus;
+    }
+
+/// Does what you'd do to a new board: holds down all three buttons while it boots,
+/// which writes the default options (and empty slots and arpeggios) to the EEPROM
+static inline void harnessFactoryReset()
+    {
+    simPowerOn();
+    simPins[PIN_BACK_BUTTON] = LOW;
+    simPins[PIN_MIDDLE_BUTTON] = LOW;
+    simPins[PIN_SELECT_BUTTON] = LOW;
+    try
+        {
+        setup();
+        }
+    catch (SimSoftRestart)
+        {
+        }
+    }
+
+/// Powers on and runs setup(), so Gizmo is sitting in the root menu.  The first time,
+/// the EEPROM is factory reset first.
+static inline void harnessBoot()
+    {
+    static uint8_t reset = false;
+    if (!reset)
+        {
+        harnessFactoryReset();
+        reset = true;
+        }
+    simPowerOn();
+    simMIDIOutHook = harnessMIDIOut;
+    simBoot();
+    harnessClearOut();
+    }
+
+/// Runs one tick
+static inline void harnessTick()
+    {
+    loop();
+    }
+
+/// Runs ticks until the given time
+static inline void harnessRunUntil(uint64_t time)
+    {
+    simRunUntil(time);
+    }
+
+/// Counts the bytes sent equal to b
+static inline uint32_t harnessCountOut(uint8_t b)
+    {
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < harnessNumOut; i++)
+        if (harnessOut[i].b == b) count++;
+    return count;
+    }
+
+#define CHECK(cond) do { if (!(cond)) { harnessFailures++; fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); } } while(0)
+#define CHECK_EQUAL(a, b) do { long long _a = (long long)(a), _b = (long long)(b); if (_a != _b) { harnessFailures++; fprintf(stderr, "%s:%d: FAILED: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); } } while(0)
+
+/// Reports the results and returns the exit code for main()
+static inline int harnessDone(const char* name)
+    {
+    if (harnessFailures)
+        printf("%s: %lu FAILED\n", name, (unsigned long) harnessFailures);
+    else
+        printf("%s: passed\n", name);
+    return (harnessFailures ? 1 : 0);
+    }
+
+#endif __HARNESS_H__
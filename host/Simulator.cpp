@@ -0,0 +1,723 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+#include "Simulator.h"
+#include <EEPROM.h>
+#include <SoftReset.h>
+#include <util/twi.h>
+#include <stdio.h>
+
+//// See Simulator.h
+
+
+//// INTERRUPT VECTORS
+//// Gizmo defines these with ISR(...).  They're weak so that a harness can link without them.
+
+extern "C" void ADC_vect(void) __attribute__((weak));
+extern "C" void TWI_vect(void) __attribute__((weak));
+extern "C" void TIMER3_COMPA_vect(void) __attribute__((weak));
+
+
+//// STATE
+
+uint64_t simTime;
+uint8_t simEEPROM[SIM_EEPROM_SIZE];
+void (*simMIDIOutHook)(uint64_t time, uint8_t b) = NULL;
+void (*simFrameHook)(uint64_t time, const uint8_t* ram) = NULL;
+uint16_t (*simPotHook)(uint8_t channel) = NULL;
+uint16_t simAnalog[16];
+struct _simErrors simErrors;
+struct _simDisplay simDisplay;
+volatile uint8_t simPins[NUM_DIGITAL_PINS];
+EEPROMClass EEPROM;
+HardwareSerial Serial;
+
+#define SIM_NEVER (~(uint64_t)0)
+
+static uint8_t sreg;
+static uint8_t inInterrupt;
+
+// ADC
+static uint8_t adcsra, adcsrb, admux;
+static uint16_t adc;
+static uint8_t adcChannel;
+static uint64_t adcDone = SIM_NEVER;
+
+// TWI
+static uint8_t twcr, twsr, twbr, twdr;
+static uint8_t twint;
+static uint64_t twiDone = SIM_NEVER;
+static uint8_t twiNextStatus;
+static uint8_t twiBusHeld;          // we've sent a START without a STOP
+static uint8_t twiAddressNext;      // the next byte is the slave address
+static uint8_t twiAddressed;        // the HT16K33 ACKed its address
+static uint8_t twiFirstData;        // the next byte is the first after the address
+static uint8_t twiRamPointer;
+static uint8_t twiRamWritten;
+
+// USART
+#define SIM_SERIAL_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+static uint8_t ucsr0b;
+static uint8_t udrFull;
+static uint8_t udr;
+static uint64_t shiftDone = SIM_NEVER;
+static uint32_t byteTime = 320;
+static uint8_t txBuffer[SIM_SERIAL_BUFFER_SIZE];
+static uint8_t txHead, txTail;
+static uint8_t rxBuffer[SIM_SERIAL_BUFFER_SIZE];
+static uint8_t rxHead, rxTail;
+#define SIM_MAX_MIDI_IN 65536
+static struct { uint64_t time; uint8_t b; } *midiIn = NULL;
+static uint32_t midiInHead, midiInCount;
+
+// Timer3
+static uint8_t tccr3a, tccr3b, timsk3, tifr3;
+static uint16_t ocr3a;
+static uint64_t timer3Base;         // the count (in 4us units since power-on) at which TCNT3 was 0
+static uint64_t timer3Match = SIM_NEVER;
+
+// EEPROM
+static uint64_t eepromBusy;
+
+
+
+//// TIME AND INTERRUPTS
+
+static void service();
+
+static uint64_t nextEvent()
+    {
+    uint64_t t = adcDone;
+    if (twiDone < t) t = twiDone;
+    if (shiftDone < t) t = shiftDone;
+    if (timer3Match < t) t = timer3Match;
+    return t;
+    }
+
+static void updateTimer3Match()
+    {
+    if ((tccr3b & 0x07) == 0)
+        {
+        timer3Match = SIM_NEVER;
+        return;
+        }
+    uint64_t count = simTime / 4;
+    uint16_t tcnt = (uint16_t)(count - timer3Base);
+    uint32_t delta = (uint16_t)(ocr3a - tcnt);
+    if (delta == 0) delta = 65536;
+    timer3Match = (count + delta) * 4;
+    }
+
+static void shiftNext(uint64_t time)
+    {
+    if (udrFull)
+        {
+        udrFull = false;
+        if (simMIDIOutHook) simMIDIOutHook(time, udr);
+        shiftDone = time + byteTime;
+        }
+    else shiftDone = SIM_NEVER;
+    }
+
+static void finishTWI();
+
+// Handles whatever hardware events have come due
+static void processEvents()
+    {
+    if (adcDone <= simTime)
+        {
+        adcDone = SIM_NEVER;
+        uint16_t val = (simPotHook ? simPotHook(adcChannel) : simAnalog[adcChannel]);
+        adc = (val > 1023 ? 1023 : val);
+        adcsra &= ~_BV(ADSC);
+        adcsra |= _BV(ADIF);
+        }
+    if (twiDone <= simTime)
+        {
+        twiDone = SIM_NEVER;
+        twsr = (twsr & 0x07) | twiNextStatus;
+        twint = true;
+        }
+    if (shiftDone <= simTime)
+        {
+        shiftNext(shiftDone);
+        }
+    if (timer3Match <= simTime)
+        {
+        tifr3 |= _BV(OCF3A);
+        updateTimer3Match();
+        }
+    }
+
+void simAdvanceTo(uint64_t time)
+    {
+    service();
+    while(true)
+        {
+        uint64_t t = nextEvent();
+        if (t > time) break;
+        if (t > simTime) simTime = t;
+        processEvents();
+        service();
+        }
+    if (time > simTime) simTime = time;
+    }
+
+void simAdvance(uint32_t us)
+    {
+    simAdvanceTo(simTime + us);
+    }
+
+// Lets time pass until the next hardware event.  Used when the firmware is busy-waiting.
+static void waitForEvent()
+    {
+    uint64_t t = nextEvent();
+    if (t == SIM_NEVER)
+        {
+        fprintf(stderr, "Simulator: the firmware is waiting for hardware which will never respond\n");
+        abort();
+        }
+    simAdvanceTo(t);
+    }
+
+static void txEmptyInterrupt();
+
+// Runs pending interrupts, highest priority first, if interrupts are on
+static void service()
+    {
+    while(!inInterrupt && (sreg & _BV(SREG_I)))
+        {
+        inInterrupt = true;
+        sreg &= ~_BV(SREG_I);
+        if ((ucsr0b & _BV(UDRIE0)) && !udrFull)
+            {
+            txEmptyInterrupt();
+            }
+        else if ((adcsra & _BV(ADIE)) && (adcsra & _BV(ADIF)) && ADC_vect)
+            {
+            adcsra &= ~_BV(ADIF);
+            ADC_vect();
+            }
+        else if ((timsk3 & _BV(OCIE3A)) && (tifr3 & _BV(OCF3A)) && TIMER3_COMPA_vect)
+            {
+            tifr3 &= ~_BV(OCF3A);
+            TIMER3_COMPA_vect();
+            }
+        else if ((twcr & _BV(TWIE)) && twint && TWI_vect)
+            {
+            TWI_vect();
+            }
+        else
+            {
+            sreg |= _BV(SREG_I);
+            inInterrupt = false;
+            break;
+            }
+        sreg |= _BV(SREG_I);
+        inInterrupt = false;
+        }
+    }
+
+void simInterruptsOn()
+    {
+    sreg |= _BV(SREG_I);
+    service();
+    }
+
+void simInterruptsOff()
+    {
+    sreg &= ~_BV(SREG_I);
+    }
+
+
+
+//// REGISTERS
+
+SimRegister<uint8_t> SREG(SIM_SREG);
+SimRegister<uint8_t> ADCSRA(SIM_ADCSRA), ADCSRB(SIM_ADCSRB), ADMUX(SIM_ADMUX);
+SimRegister<uint16_t> ADC(SIM_ADC);
+SimRegister<uint8_t> TWCR(SIM_TWCR), TWSR(SIM_TWSR), TWBR(SIM_TWBR), TWDR(SIM_TWDR);
+SimRegister<uint8_t> UCSR0A(SIM_UCSR0A), UCSR0B(SIM_UCSR0B), UDR0(SIM_UDR0);
+SimRegister<uint8_t> EECR(SIM_EECR);
+#if defined(__AVR_ATmega2560__)
+SimRegister<uint8_t> TCCR3A(SIM_TCCR3A), TCCR3B(SIM_TCCR3B), TIMSK3(SIM_TIMSK3), TIFR3(SIM_TIFR3);
+SimRegister<uint16_t> OCR3A(SIM_OCR3A), TCNT3(SIM_TCNT3);
+#endif
+
+uint16_t simReadRegister(uint8_t reg)
+    {
+    switch(reg)
+        {
+        case SIM_SREG: return sreg;
+        case SIM_ADCSRA: return adcsra;
+        case SIM_ADCSRB: return adcsrb;
+        case SIM_ADMUX: return admux;
+        case SIM_ADC: return adc;
+        case SIM_TWCR: return (twcr & ~(_BV(TWINT) | _BV(TWSTO))) | (twint ? _BV(TWINT) : 0);
+        case SIM_TWSR: return twsr;
+        case SIM_TWBR: return twbr;
+        case SIM_TWDR: return twdr;
+        case SIM_UCSR0A: return (udrFull ? 0 : _BV(UDRE0));
+        case SIM_UCSR0B: return ucsr0b;
+        case SIM_UDR0: return 0;
+        case SIM_TCCR3A: return tccr3a;
+        case SIM_TCCR3B: return tccr3b;
+        case SIM_TIMSK3: return timsk3;
+        case SIM_TIFR3: return tifr3;
+        case SIM_OCR3A: return ocr3a;
+        case SIM_TCNT3: return (uint16_t)(simTime / 4 - timer3Base);
+        case SIM_EECR:
+            if (simTime < eepromBusy)
+                {
+                simAdvance(1);          // so a loop waiting on EEPE doesn't wait forever
+                return _BV(EEPE);
+                }
+            return 0;
+        default: return 0;
+        }
+    }
+
+// The I2C bit time in microseconds, times 10
+static uint32_t twiBitTime()
+    {
+    static const uint8_t prescale[4] = { 1, 4, 16, 64 };
+    return ((16 + 2 * (uint32_t) twbr * prescale[twsr & 0x03]) * 10000000) / F_CPU;
+    }
+
+static void startTWI(uint8_t status, uint32_t bits)
+    {
+    twiNextStatus = status;
+    twiDone = simTime + (bits * twiBitTime() + 9) / 10;
+    }
+
+static void finishTWI()
+    {
+    if (twiRamWritten)
+        {
+        simDisplay.frames++;
+        if (simFrameHook) simFrameHook(simTime, simDisplay.ram);
+        }
+    twiRamWritten = false;
+    twiAddressed = false;
+    }
+
+// The HT16K33 receives a byte
+static void displayByte(uint8_t b)
+    {
+    if (twiFirstData)
+        {
+        twiFirstData = false;
+        switch(b & 0xF0)
+            {
+            case 0x00: twiRamPointer = b & 0x0F; return;
+            case 0x20: simDisplay.oscillatorOn = b & 0x01; break;
+            case 0x80: simDisplay.displaySetup = b; break;
+            case 0xE0: simDisplay.dimming = b; break;
+            }
+        twiAddressed = false;           // commands take no more data
+        return;
+        }
+    simDisplay.ram[twiRamPointer] = b;
+    twiRamPointer = (twiRamPointer + 1) & 0x0F;
+    twiRamWritten = true;
+    }
+
+static void writeTWCR(uint8_t val)
+    {
+    twcr = val & ~_BV(TWINT);
+    if (!(val & _BV(TWEN)))
+        {
+        twint = false;
+        twiDone = SIM_NEVER;
+        twiBusHeld = false;
+        return;
+        }
+    if (!(val & _BV(TWINT)))            // writing 1 to TWINT clears it and starts the next operation
+        return;
+    twint = false;
+
+    if (val & _BV(TWSTO))
+        {
+        finishTWI();
+        twiBusHeld = false;
+        if (val & _BV(TWSTA))
+            {
+            twiBusHeld = true;
+            twiAddressNext = true;
+            startTWI(TW_START, 2);
+            }
+        }
+    else if (val & _BV(TWSTA))
+        {
+        if (twiBusHeld) finishTWI();
+        startTWI(twiBusHeld ? TW_REP_START : TW_START, 2);
+        twiBusHeld = true;
+        twiAddressNext = true;
+        }
+    else if (twiAddressNext)
+        {
+        twiAddressNext = false;
+        simDisplay.bytes++;
+        twiAddressed = (twdr == (0x70 << 1));
+        twiFirstData = true;
+        if (!twiAddressed) simErrors.i2cNacks++;
+        startTWI(twiAddressed ? TW_MT_SLA_ACK : TW_MT_SLA_NACK, 9);
+        }
+    else
+        {
+        simDisplay.bytes++;
+        if (twiAddressed) displayByte(twdr);
+        startTWI(TW_MT_DATA_ACK, 9);
+        }
+    }
+
+static void writeADCSRA(uint8_t val)
+    {
+    uint8_t flag = adcsra & _BV(ADIF);
+    if (val & _BV(ADIF)) flag = 0;      // writing 1 to ADIF clears it
+    uint8_t converting = adcsra & _BV(ADSC);
+    adcsra = (val & ~(_BV(ADIF) | _BV(ADSC))) | flag | converting;
+    if ((val & _BV(ADSC)) && (val & _BV(ADEN)) && !converting)
+        {
+        adcChannel = (admux & 0x07) | ((adcsrb & 0x08) ? 0x08 : 0);
+        adcsra |= _BV(ADSC);
+        adcDone = simTime + 104;        // 13 ADC clocks at 125KHz
+        }
+    if (!(val & _BV(ADEN)))
+        {
+        adcsra &= ~_BV(ADSC);
+        adcDone = SIM_NEVER;
+        }
+    }
+
+static void writeUDR(uint8_t val)
+    {
+    if (udrFull)
+        {
+        simErrors.udrOverwrites++;
+        }
+    udr = val;
+    udrFull = true;
+    if (shiftDone == SIM_NEVER)
+        shiftNext(simTime);
+    }
+
+void simWriteRegister(uint8_t reg, uint16_t val)
+    {
+    switch(reg)
+        {
+        case SIM_SREG: sreg = val; break;
+        case SIM_ADCSRA: writeADCSRA(val); break;
+        case SIM_ADCSRB: adcsrb = val; break;
+        case SIM_ADMUX: admux = val; break;
+        case SIM_ADC: break;
+        case SIM_TWCR: writeTWCR(val); break;
+        case SIM_TWSR: twsr = (twsr & 0xF8) | (val & 0x03); break;
+        case SIM_TWBR: twbr = val; break;
+        case SIM_TWDR: twdr = val; break;
+        case SIM_UCSR0A: break;
+        case SIM_UCSR0B: ucsr0b = val; break;
+        case SIM_UDR0: writeUDR(val); break;
+        case SIM_TCCR3A: tccr3a = val; break;
+        case SIM_TCCR3B: tccr3b = val; updateTimer3Match(); break;
+        case SIM_TIMSK3: timsk3 = val; break;
+        case SIM_TIFR3: tifr3 &= ~val; break;          // writing 1 clears a flag
+        case SIM_OCR3A: ocr3a = val; updateTimer3Match(); break;
+        case SIM_TCNT3: timer3Base = simTime / 4 - (uint16_t) val; updateTimer3Match(); break;
+        case SIM_EECR: break;
+        }
+    service();
+    }
+
+
+
+//// HARDWARE SERIAL
+//// Follows the Arduino core's HardwareSerial, including its UDRE interrupt
+
+static void txEmptyInterrupt()
+    {
+    if (txHead == txTail)               // nothing to send (the core would send garbage)
+        {
+        ucsr0b &= ~_BV(UDRIE0);
+        return;
+        }
+    uint8_t c = txBuffer[txTail];
+    txTail = (txTail + 1) % SIM_SERIAL_BUFFER_SIZE;
+    writeUDR(c);
+    if (txHead == txTail)
+        ucsr0b &= ~_BV(UDRIE0);
+    }
+
+void HardwareSerial::begin(unsigned long baud)
+    {
+    byteTime = (10 * 1000000UL + baud - 1) / baud;
+    ucsr0b = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+    txHead = txTail = rxHead = rxTail = 0;
+    }
+
+// Moves the bytes which have arrived into the receive buffer, as the receive interrupt would have
+static void receive()
+    {
+    while(midiInHead < midiInCount && midiIn[midiInHead].time <= simTime)
+        {
+        uint8_t next = (rxHead + 1) % SIM_SERIAL_BUFFER_SIZE;
+        if (next == rxTail)
+            simErrors.rxOverruns++;
+        else
+            {
+            rxBuffer[rxHead] = midiIn[midiInHead].b;
+            rxHead = next;
+            }
+        midiInHead++;
+        }
+    }
+
+int HardwareSerial::available()
+    {
+    receive();
+    return (SIM_SERIAL_BUFFER_SIZE + rxHead - rxTail) % SIM_SERIAL_BUFFER_SIZE;
+    }
+
+int HardwareSerial::read()
+    {
+    receive();
+    if (rxHead == rxTail) return -1;
+    uint8_t c = rxBuffer[rxTail];
+    rxTail = (rxTail + 1) % SIM_SERIAL_BUFFER_SIZE;
+    return c;
+    }
+
+int HardwareSerial::availableForWrite()
+    {
+    if (txHead >= txTail) return SIM_SERIAL_BUFFER_SIZE - 1 - txHead + txTail;
+    return txTail - txHead - 1;
+    }
+
+size_t HardwareSerial::write(uint8_t c)
+    {
+    if (txHead == txTail && !udrFull)
+        {
+        writeUDR(c);
+        return 1;
+        }
+    uint8_t i = (txHead + 1) % SIM_SERIAL_BUFFER_SIZE;
+    while(i == txTail)
+        {
+        if (!(sreg & _BV(SREG_I)))
+            {
+            if (!udrFull) txEmptyInterrupt();
+            else waitForEvent();
+            }
+        else waitForEvent();
+        }
+    txBuffer[txHead] = c;
+    txHead = i;
+    ucsr0b |= _BV(UDRIE0);
+    service();
+    return 1;
+    }
+
+void simMIDIIn(uint64_t time, uint8_t b)
+    {
+    if (midiIn == NULL)
+        midiIn = (typeof(midiIn)) malloc(sizeof(*midiIn) * SIM_MAX_MIDI_IN);
+    if (midiInHead == midiInCount)
+        midiInHead = midiInCount = 0;
+    if (midiInCount == SIM_MAX_MIDI_IN)
+        {
+        // compact
+        memmove(midiIn, midiIn + midiInHead, sizeof(*midiIn) * (midiInCount - midiInHead));
+        midiInCount -= midiInHead;
+        midiInHead = 0;
+        if (midiInCount == SIM_MAX_MIDI_IN)
+            {
+            fprintf(stderr, "Simulator: too much MIDI queued\n");
+            abort();
+            }
+        }
+    midiIn[midiInCount].time = time;
+    midiIn[midiInCount].b = b;
+    midiInCount++;
+    }
+
+uint32_t simMIDIInPending()
+    {
+    return midiInCount - midiInHead;
+    }
+
+
+
+//// ARDUINO CORE
+
+uint32_t micros()
+    {
+    return (uint32_t) simTime & ~3UL;                 // the AVR's micros() counts in 4us
+    }
+
+uint32_t millis()
+    {
+    return (uint32_t)(simTime / 1000);
+    }
+
+void delay(uint32_t ms)
+    {
+    simAdvance(ms * 1000);
+    }
+
+void delayMicroseconds(unsigned int us)
+    {
+    simAdvance(us);
+    }
+
+void pinMode(uint8_t pin, uint8_t mode)
+    {
+    // pins start out HIGH, as if pulled up, so there's nothing to do
+    }
+
+void digitalWrite(uint8_t pin, uint8_t val)
+    {
+    simPins[pin] = (val ? HIGH : LOW);
+    }
+
+int digitalRead(uint8_t pin)
+    {
+    return simPins[pin];
+    }
+
+int analogRead(uint8_t pin)
+    {
+    uint8_t channel = (pin >= A0 ? pin - A0 : pin) & 0x0F;
+    simAdvance(112);
+    uint16_t val = (simPotHook ? simPotHook(channel) : simAnalog[channel]);
+    return (val > 1023 ? 1023 : val);
+    }
+
+// avr-libc's random(), which the Arduino core's random() calls: Park and Miller's
+// "minimal standard" generator, computed with Schrage's method
+static int32_t randomState = 1;
+
+static int32_t nextRandom()
+    {
+    int32_t x = randomState;
+    if (x == 0) x = 123459876L;
+    int32_t hi = x / 127773L;
+    int32_t lo = x % 127773L;
+    x = 16807L * lo - 2836L * hi;
+    if (x < 0) x += 0x7FFFFFFFL;
+    randomState = x;
+    return x;
+    }
+
+long random()
+    {
+    return nextRandom();
+    }
+
+long random(long howbig)
+    {
+    if (howbig == 0) return 0;
+    return (int32_t)((uint32_t) nextRandom() % (uint32_t)(int32_t) howbig);
+    }
+
+long random(long howsmall, long howbig)
+    {
+    if (howsmall >= howbig) return howsmall;
+    return random((int32_t)(howbig - howsmall)) + howsmall;
+    }
+
+void randomSeed(unsigned long seed)
+    {
+    if (seed != 0) randomState = (int32_t)(uint32_t) seed;
+    }
+
+
+
+//// EEPROM
+
+uint8_t simEEPROMRead(uint16_t address)
+    {
+    simAdvanceTo(eepromBusy);
+    return simEEPROM[address % SIM_EEPROM_SIZE];
+    }
+
+void simEEPROMWrite(uint16_t address, uint8_t val)
+    {
+    simAdvanceTo(eepromBusy);
+    simEEPROM[address % SIM_EEPROM_SIZE] = val;
+    eepromBusy = simTime + 3400;
+    }
+
+uint16_t simEEPROMLength()
+    {
+    return SIM_EEPROM_SIZE;
+    }
+
+bool simLoadEEPROM(const char* filename)
+    {
+    FILE* f = fopen(filename, "rb");
+    if (f == NULL) return false;
+    size_t n = fread(simEEPROM, 1, SIM_EEPROM_SIZE, f);
+    fclose(f);
+    return (n == SIM_EEPROM_SIZE);
+    }
+
+bool simSaveEEPROM(const char* filename)
+    {
+    FILE* f = fopen(filename, "wb");
+    if (f == NULL) return false;
+    size_t n = fwrite(simEEPROM, 1, SIM_EEPROM_SIZE, f);
+    fclose(f);
+    return (n == SIM_EEPROM_SIZE);
+    }
+
+
+
+//// SOFT RESET
+
+void simSoftRestart()
+    {
+    throw SimSoftRestart();
+    }
+
+
+
+//// RUNNING
+
+static uint8_t eepromErased = false;
+
+void simPowerOn()
+    {
+    if (!eepromErased)
+        {
+        memset(simEEPROM, 0xFF, SIM_EEPROM_SIZE);           // a new chip
+        eepromErased = true;
+        }
+    simTime = 0;
+    sreg = _BV(SREG_I);                                     // the Arduino core turns interrupts on before setup()
+    inInterrupt = false;
+    adcsra = adcsrb = admux = 0; adc = 0; adcDone = SIM_NEVER;
+    twcr = twsr = twbr = twdr = 0; twint = false; twiDone = SIM_NEVER;
+    twiBusHeld = twiAddressNext = twiAddressed = twiFirstData = twiRamWritten = false;
+    ucsr0b = 0; udrFull = false; shiftDone = SIM_NEVER;
+    txHead = txTail = rxHead = rxTail = 0;
+    midiInHead = midiInCount = 0;
+    tccr3a = tccr3b = timsk3 = tifr3 = 0; ocr3a = 0; timer3Base = 0; timer3Match = SIM_NEVER;
+    eepromBusy = 0;
+    memset(&simErrors, 0, sizeof(simErrors));
+    memset(&simDisplay, 0, sizeof(simDisplay));
+    memset((void*)simPins, HIGH, sizeof(simPins));
+    for(uint8_t i = 0; i < 16; i++)
+        simAnalog[i] = 512;
+    randomState = 1;
+    }
+
+void simBoot()
+    {
+    setup();
+    }
+
+void simRunUntil(uint64_t time)
+    {
+    while(simTime < time)
+        loop();
+    }
@@ -0,0 +1,104 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __SIMULATOR_H__
+#define __SIMULATOR_H__
+
+#include <Arduino.h>
+
+
+/////// THE HOST SIMULATOR
+///////
+/////// Gizmo runs unmodified on the host against the shims in host/shim.  Time is virtual:
+/////// simTime counts microseconds since power-on, and only moves when the firmware waits
+/////// (delay(), delayMicroseconds(), a full serial buffer, the EEPROM) or when a harness
+/////// calls simAdvance().  Since go() takes no virtual time at all, every tick starts exactly
+/////// when updateTicksAndWait() says it should, and a run is completely deterministic.
+///////
+/////// The simulator models the hardware Gizmo drives directly, closely enough that
+/////// interrupts come in when they would on the board:
+///////
+/////// ADC         Conversions take 104us, then ADC_vect.  Pot values come from simPotHook.
+/////// TWI         400KHz I2C to an HT16K33, whose display RAM is handed to simFrameHook
+///////             at every STOP after it changes.
+/////// USART       31250 baud.  Bytes are handed to simMIDIOutHook as their start bit goes
+///////             out.  Incoming bytes are queued with simMIDIIn().  HardwareSerial has the
+///////             Arduino core's 64-byte buffers and UDRE interrupt.
+/////// TIMER3      Prescaler 64 (4us per count), compare match A and TIMER3_COMPA_vect (Mega only).
+/////// EEPROM      A write takes 3.4ms, during which EEPE is set in EECR.
+///////
+/////// Interrupts are prioritized as on the chip, run only when the I bit in SREG is set, and
+/////// take no time.  They're checked whenever time moves and whenever a register write
+/////// might raise one.
+
+/// Microseconds since power-on
+extern uint64_t simTime;
+
+/// The EEPROM
+#if defined(__AVR_ATmega2560__)
+#define SIM_EEPROM_SIZE 4096
+#else
+#define SIM_EEPROM_SIZE 1024
+#endif
+extern uint8_t simEEPROM[SIM_EEPROM_SIZE];
+
+/// Called with each outgoing MIDI byte, at the time its start bit goes out
+extern void (*simMIDIOutHook)(uint64_t time, uint8_t b);
+
+/// Called with the HT16K33's display RAM at the end of every I2C transaction which changed it
+extern void (*simFrameHook)(uint64_t time, const uint8_t* ram);
+
+/// Returns the value (0...1023) on the given ADC channel.  If NULL, simAnalog[] is used.
+extern uint16_t (*simPotHook)(uint8_t channel);
+extern uint16_t simAnalog[16];
+
+/// Counts of things which went wrong in the hardware
+struct _simErrors
+    {
+    uint32_t rxOverruns;            // incoming bytes dropped because the receive buffer was full
+    uint32_t udrOverwrites;         // bytes written to UDR0 while it was still full
+    uint32_t i2cNacks;              // I2C transactions to the wrong address
+    };
+extern struct _simErrors simErrors;
+
+/// Resets the chip (but not the EEPROM) and the simulated time, as at power-on
+void simPowerOn();
+
+/// Lets the given number of microseconds pass, as if the firmware were busy computing
+void simAdvance(uint32_t us);
+
+/// Lets time pass until the given time
+void simAdvanceTo(uint64_t time);
+
+/// Calls setup(), then loop() until simTime reaches the given time
+void simBoot();
+void simRunUntil(uint64_t time);
+
+/// Queues an incoming byte, which finishes arriving at the given time.  Bytes must be
+/// queued in order, and at least 320us apart to be realistic.
+void simMIDIIn(uint64_t time, uint8_t b);
+
+/// Number of incoming bytes queued with simMIDIIn() which haven't arrived yet
+uint32_t simMIDIInPending();
+
+/// Thrown by soft_restart()
+struct SimSoftRestart { };
+
+/// The HT16K33's state
+struct _simDisplay
+    {
+    uint8_t ram[16];
+    uint8_t oscillatorOn;
+    uint8_t displaySetup;           // the last display setup command (0x80 ... 0x87)
+    uint8_t dimming;                // the last dimming command (0xE0 ... 0xEF)
+    uint32_t frames;                // transactions which wrote to display RAM
+    uint32_t bytes;                 // bytes sent over I2C, including addresses
+    };
+extern struct _simDisplay simDisplay;
+
+/// Loads or saves the EEPROM image.  Returns false on failure.
+bool simLoadEEPROM(const char* filename);
+bool simSaveEEPROM(const char* filename);
+
+#endif __SIMULATOR_H__
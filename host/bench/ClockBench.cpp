@@ -0,0 +1,188 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// CLOCK BENCHMARK
+//////
+////// Feeds Gizmo an external MIDI clock through simMIDIIn and measures how well
+////// Timing.cpp's updateExternalClock() tracks it.  The sender's pulses are perfectly
+////// regular, plus Gaussian jitter on each one; Gizmo only sees them at the start of the
+////// tick after they arrive.  After every pulse Gizmo sees we compare two estimates of the
+////// microseconds per pulse against the sender's true period:
+//////
+//////     - RAW: the time between the last two pulses, as Gizmo saw them.  This is what
+//////       externalMicrosecsPerPulse used to be.
+//////
+//////     - FILTERED: externalMicrosecsPerPulse, from the alpha-beta filter.
+//////
+////// Gate lengths, swing, and arpeggiator note offs are all proportional to the estimate,
+////// so their error is the same.
+//////
+//////     - Steady: a fixed tempo for 5000 pulses, ignoring the first 100.  We report the
+//////       mean and worst error of each estimate, as a percentage of the true period.
+//////
+//////     - Steps: 200 pulses at 120 BPM, then a jump to another tempo.  We report how many
+//////       pulses it takes until the filtered estimate is within 0.5% of the new period
+//////       and stays there (for at least the next 100 pulses).
+//////
+////// Timing.cpp quotes the steady figures at 120 BPM with no jitter and with jitter of
+////// 1ms (one standard deviation), and the steps from 120 to 90, 130, and 240 BPM without
+////// jitter.  We exit nonzero if those don't hold, or if the filter does worse than raw.
+
+#include "Harness.h"
+#include <math.h>
+
+// Timing.cpp doesn't declare these in Timing.h
+extern uint32_t lastExternalPulseTime;
+extern uint32_t externalMicrosecsPerPulse;
+
+#define WARMUP 100
+#define STEADY_PULSES 5000
+#define STEP_BEFORE 200
+#define STEP_AFTER 300
+#define SETTLED 0.5                     // percent, without jitter
+#define SETTLED_JITTER 2.0              // percent, with 1ms jitter
+#define STAY_SETTLED 100
+
+static uint32_t noiseState = 1;
+
+// Our own generator, so as not to disturb Gizmo's
+static double uniform()
+    {
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return (noiseState + 0.5) / 4294967296.0;
+    }
+
+static double gaussian()
+    {
+    return sqrt(-2 * log(uniform())) * cos(2 * M_PI * uniform());
+    }
+
+static double period(double bpm)
+    {
+    return 60000000.0 / (bpm * 24);
+    }
+
+// The sender
+static double senderTime;               // when the sender's next pulse is due, without jitter
+static double senderPeriod;
+static double jitter;                   // standard deviation, in microseconds
+static uint64_t lastArrival;
+
+// Queues the sender's next pulse if the last one has arrived
+static void send()
+    {
+    if (simMIDIInPending() > 0) return;
+    double t = senderTime + jitter * gaussian();
+    uint64_t arrival = (t < lastArrival + 320 ? lastArrival + 320 : (uint64_t) t);
+    simMIDIIn(arrival, MIDIClock);
+    lastArrival = arrival;
+    senderTime += senderPeriod;
+    }
+
+// Runs until Gizmo has seen the next pulse.  Returns the raw and filtered errors, in
+// percent of the sender's period.
+static void nextPulse(double* raw, double* filtered)
+    {
+    uint32_t last = lastExternalPulseTime;
+    while(lastExternalPulseTime == last)
+        {
+        send();
+        harnessTick();
+        }
+    *raw = 100.0 * fabs((double)(lastExternalPulseTime - last) - senderPeriod) / senderPeriod;
+    *filtered = 100.0 * fabs((double) externalMicrosecsPerPulse - senderPeriod) / senderPeriod;
+    }
+
+// Sends a MIDI start, then the first pulse at the given tempo
+static void start(double bpm, double j)
+    {
+    harnessRunUntil(simTime + 100000);
+    simMIDIIn(simTime + 320, MIDIStart);
+    lastArrival = simTime + 320;
+    harnessRunUntil(simTime + 1000);
+    jitter = j;
+    senderPeriod = period(bpm);
+    senderTime = simTime + 1000;
+    double raw, filtered;
+    nextPulse(&raw, &filtered);
+    }
+
+static void steady(double bpm, double j, double* meanRaw, double* meanFiltered)
+    {
+    double raw, filtered, worstRaw = 0, worstFiltered = 0;
+    *meanRaw = *meanFiltered = 0;
+    start(bpm, j);
+    for(uint16_t i = 0; i < WARMUP; i++)
+        nextPulse(&raw, &filtered);
+    for(uint16_t i = 0; i < STEADY_PULSES; i++)
+        {
+        nextPulse(&raw, &filtered);
+        *meanRaw += raw;
+        *meanFiltered += filtered;
+        if (raw > worstRaw) worstRaw = raw;
+        if (filtered > worstFiltered) worstFiltered = filtered;
+        }
+    *meanRaw /= STEADY_PULSES;
+    *meanFiltered /= STEADY_PULSES;
+    printf("    %5.1f   %6.2f   %8.3f   %9.3f   %8.3f   %9.3f\n", bpm, j / 1000, *meanRaw, worstRaw, *meanFiltered, worstFiltered);
+    }
+
+// Returns the number of pulses after the step until the filter settled, or -1 if it didn't
+static int16_t step(double from, double to, double j, double within)
+    {
+    double raw, filtered;
+    start(from, j);
+    for(uint16_t i = 0; i < STEP_BEFORE; i++)
+        nextPulse(&raw, &filtered);
+    // the first pulse at the new tempo is one new period after the last one at the old
+    senderTime += period(to) - senderPeriod;
+    senderPeriod = period(to);
+    int16_t settled = -1;
+    for(uint16_t i = 1; i <= STEP_AFTER; i++)
+        {
+        nextPulse(&raw, &filtered);
+        if (filtered > within) settled = -1;
+        else if (settled == -1) settled = i;
+        }
+    if (settled > STEP_AFTER - STAY_SETTLED) settled = -1;
+    return settled;
+    }
+
+int main()
+    {
+    static const double tempos[] = { 60, 120, 240 };
+    static const double jitters[] = { 0, 250, 500, 1000, 2000 };
+    static const double steps[] = { 90, 110, 130, 180, 240, 60 };
+    harnessBoot();
+    options.clock = CONSUME_MIDI_CLOCK;
+
+    printf("period error (%% of the true period) at a steady tempo\n");
+    printf("      bpm   jitter   raw mean   raw worst   filt mean   filt worst\n");
+    printf("             (ms)\n");
+    for(uint8_t i = 0; i < sizeof(tempos) / sizeof(tempos[0]); i++)
+        for(uint8_t k = 0; k < sizeof(jitters) / sizeof(jitters[0]); k++)
+            {
+            double raw, filtered;
+            steady(tempos[i], jitters[k], &raw, &filtered);
+            CHECK(filtered < raw);
+            if (tempos[i] == 120 && jitters[k] == 0) CHECK(filtered < 0.025);
+            if (tempos[i] == 120 && jitters[k] == 1000) CHECK(filtered < 0.2);
+            }
+
+    printf("pulses until within %.1f%% (no jitter) or %.1f%% (1ms jitter) after a step from 120 BPM\n", SETTLED, SETTLED_JITTER);
+    printf("      bpm   no jitter   1ms jitter\n");
+    for(uint8_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+        {
+        int16_t clean = step(120, steps[i], 0, SETTLED);
+        int16_t noisy = step(120, steps[i], 1000, SETTLED_JITTER);
+        printf("    %5.1f   %9d   %10d\n", steps[i], clean, noisy);
+        CHECK(clean != -1);
+        if (steps[i] == 90 || steps[i] == 130) CHECK(clean <= 4);
+        if (steps[i] == 240) CHECK(clean <= 13);
+        }
+
+    return harnessDone("ClockBench");
+    }
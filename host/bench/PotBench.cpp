@@ -0,0 +1,123 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// POT BENCHMARK
+//////
+////// Feeds the pots noisy traces through simPotHook and watches pot[LEFT_POT], to measure
+////// the filter in TopLevel.cpp's updatePot(): how much it jitters when the pot is left
+////// alone, and how far it lags behind when the pot is turned.  Each ADC reading is the
+////// pot's true (real-valued) position plus Gaussian noise, rounded and clamped to 0...1023.
+//////
+//////     - Still: the pot sits at each of a range of positions for 10 seconds after
+//////       settling for half a second.  We count how often pot[] changes.
+//////
+//////     - Sweep: the pot is turned end to end, up and then down, in the given time.
+//////       We record the worst distance between pot[] and the true position, and check
+//////       that pot[] reaches both ends (with noise up to 3).
+//////
+////// TopLevel.cpp quotes the figures for noise of 2 (one standard deviation) and a one
+////// second sweep: no changes at all when still, and a lag of at most 10.  We exit nonzero
+////// if those don't hold.
+
+#include "Harness.h"
+#include <math.h>
+
+static double potPosition;             // where the pot really is, 0...1023
+static double noise;                   // standard deviation of the noise on each reading
+static uint32_t noiseState = 1;
+
+// Our own generator, so as not to disturb Gizmo's
+static double uniform()
+    {
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return (noiseState + 0.5) / 4294967296.0;
+    }
+
+static double gaussian()
+    {
+    return sqrt(-2 * log(uniform())) * cos(2 * M_PI * uniform());
+    }
+
+static uint16_t readPot(uint8_t channel)
+    {
+    double v = floor(potPosition + noise * gaussian() + 0.5);
+    return (uint16_t)(v < 0 ? 0 : v > 1023 ? 1023 : v);
+    }
+
+// Runs for the given time with the pot still, and returns how often pot[LEFT_POT] changed
+static uint32_t still(double position, uint64_t time)
+    {
+    potPosition = position;
+    harnessRunUntil(simTime + 500000);
+    uint16_t last = pot[LEFT_POT];
+    uint32_t changes = 0;
+    uint64_t end = simTime + time;
+    while(simTime < end)
+        {
+        harnessTick();
+        if (pot[LEFT_POT] != last) changes++;
+        last = pot[LEFT_POT];
+        }
+    return changes;
+    }
+
+// Sweeps the pot from one end to the other in the given time, then holds it at the far
+// end for a moment.  Returns the worst lag, and whether pot[LEFT_POT] got to the far end.
+static double sweep(double from, double to, uint64_t time, uint8_t* reached)
+    {
+    potPosition = from;
+    harnessRunUntil(simTime + 500000);
+    uint64_t start = simTime;
+    double worst = 0;
+    while(simTime < start + time)
+        {
+        potPosition = from + (to - from) * (simTime - start) / time;
+        harnessTick();
+        double lag = (to > from ? potPosition - pot[LEFT_POT] : pot[LEFT_POT] - potPosition);
+        if (lag > worst) worst = lag;
+        }
+    potPosition = to;
+    harnessRunUntil(simTime + 100000);
+    *reached = (pot[LEFT_POT] == (uint16_t) to);
+    return worst;
+    }
+
+int main()
+    {
+    static const double noises[] = { 0, 1, 2, 3, 4 };
+    static const uint64_t sweeps[] = { 250000, 1000000, 4000000 };
+    harnessBoot();
+    simPotHook = readPot;
+
+    printf("changes in 10 seconds with the pot still, at positions 0, 100.5, ..., 1000.5, 1023\n");
+    printf("    noise   changes\n");
+    for(uint8_t i = 0; i < sizeof(noises) / sizeof(noises[0]); i++)
+        {
+        noise = noises[i];
+        uint32_t changes = still(0, 10000000) + still(1023, 10000000);
+        for(double position = 100.5; position < 1023; position += 100)
+            changes += still(position, 10000000);
+        printf("    %5.1f   %7lu\n", noise, (unsigned long) changes);
+        if (noise == 2) CHECK_EQUAL(changes, 0);
+        }
+
+    printf("worst lag while sweeping end to end, up then down\n");
+    printf("    noise   sweep (s)   lag up   lag down\n");
+    for(uint8_t i = 0; i < sizeof(noises) / sizeof(noises[0]); i++)
+        for(uint8_t j = 0; j < sizeof(sweeps) / sizeof(sweeps[0]); j++)
+            {
+            noise = noises[i];
+            uint8_t reachedTop, reachedBottom;
+            double up = sweep(0, 1023, sweeps[j], &reachedTop);
+            double down = sweep(1023, 0, sweeps[j], &reachedBottom);
+            printf("    %5.1f   %9.2f   %6.1f   %8.1f\n", noise, sweeps[j] / 1000000.0, up, down);
+            if (noise <= 3) CHECK(reachedTop && reachedBottom);
+            if (!reachedTop || !reachedBottom) printf("            (didn't reach the end)\n");
+            if (noise == 2 && sweeps[j] == 1000000) CHECK(up <= 10 && down <= 10);
+            }
+
+    return harnessDone("PotBench");
+    }
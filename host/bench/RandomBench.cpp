@@ -0,0 +1,131 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// RANDOM BENCHMARK
+//////
+////// Compares Random.h's xorshift generator against avr-libc's random(), which Gizmo
+////// used to call (the simulator has a copy of it):
+//////
+//////     - How long each takes per call, in host nanoseconds.  This understates the
+//////       difference on the AVR, where random() does 32-bit multiplies and divides in
+//////       software and random(min, max) adds a 32-bit modulo.
+//////
+//////     - Whether randomBelow(n) is biased.  This is exact: we run every one of the
+//////       65536 outputs of random16() through randomBelow()'s accept/reject step and
+//////       count how many land on each of 0...n-1.  For comparison we do the same for
+//////       random16() % n, the obvious cheap alternative.
+//////
+//////     - How well the random patterns' probability thresholds hold up over a few
+//////       million draws.
+//////
+////// Exits nonzero if randomBelow() turns out to be biased.
+
+#include "Harness.h"
+#include <time.h>
+
+#define CALLS 10000000
+
+static uint64_t hostNanos()
+    {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+static volatile uint32_t sink;
+
+static void speed()
+    {
+    printf("nanoseconds per call (host)\n");
+
+    uint64_t start = hostNanos();
+    for(uint32_t i = 0; i < CALLS; i++) sink += random(RANDOM_MAX);
+    double libc = (double)(hostNanos() - start) / CALLS;
+    start = hostNanos();
+    for(uint32_t i = 0; i < CALLS; i++) sink += random16();
+    double xorshift = (double)(hostNanos() - start) / CALLS;
+    printf("    random()            %6.2f    random16()          %6.2f\n", libc, xorshift);
+
+    start = hostNanos();
+    for(uint32_t i = 0; i < CALLS; i++) sink += random(0, 12);
+    libc = (double)(hostNanos() - start) / CALLS;
+    start = hostNanos();
+    for(uint32_t i = 0; i < CALLS; i++) sink += randomBelow(12);
+    xorshift = (double)(hostNanos() - start) / CALLS;
+    printf("    random(0, 12)       %6.2f    randomBelow(12)     %6.2f\n", libc, xorshift);
+
+    start = hostNanos();
+    for(uint32_t i = 0; i < CALLS; i++) sink += (random() < RANDOM_MAX / 4);
+    libc = (double)(hostNanos() - start) / CALLS;
+    start = hostNanos();
+    for(uint32_t i = 0; i < CALLS; i++) sink += (random16() < RANDOM_PROBABILITY_1_4);
+    xorshift = (double)(hostNanos() - start) / CALLS;
+    printf("    random() < 1/4      %6.2f    random16() < 1/4    %6.2f\n", libc, xorshift);
+    }
+
+// Counts how many of random16()'s outputs randomBelow(n) (or random16() % n) maps to
+// each value, and returns the ratio of the most common to the least common
+static double spread(uint16_t n, uint8_t modulo, uint32_t* rejected)
+    {
+    static uint32_t counts[65536];
+    memset(counts, 0, sizeof(counts));
+    uint16_t threshold = ((uint16_t)(0 - n)) % n;
+    *rejected = 0;
+    for(uint32_t r = 0; r < 65536; r++)
+        {
+        if (modulo)
+            counts[r % n]++;
+        else
+            {
+            uint32_t m = r * n;
+            if ((uint16_t) m < threshold) (*rejected)++;
+            else counts[m >> 16]++;
+            }
+        }
+    uint32_t lo = 0xFFFFFFFF, hi = 0;
+    for(uint32_t i = 0; i < n; i++)
+        {
+        if (counts[i] < lo) lo = counts[i];
+        if (counts[i] > hi) hi = counts[i];
+        }
+    return (double) hi / lo;
+    }
+
+static void bias()
+    {
+    static const uint16_t ns[] = { 3, 7, 12, 100, 1000, 12345, 40000 };
+    printf("most common / least common value, over all 65536 outputs of random16()\n");
+    printf("        n    randomBelow(n)   rejected    random16() %% n\n");
+    for(uint8_t i = 0; i < sizeof(ns) / sizeof(ns[0]); i++)
+        {
+        uint32_t rejected, unused;
+        double below = spread(ns[i], false, &rejected);
+        double modulo = spread(ns[i], true, &unused);
+        printf("    %5u    %14.6f   %8lu    %14.6f\n", ns[i], below, (unsigned long) rejected, modulo);
+        CHECK(below == 1.0);
+        }
+    }
+
+static void probabilities()
+    {
+    static const uint16_t thresholds[] = { RANDOM_PROBABILITY_1_8, RANDOM_PROBABILITY_1_4, RANDOM_PROBABILITY_1_2, RANDOM_PROBABILITY_3_4 };
+    static const char* names[] = { "1/8", "1/4", "1/2", "3/4" };
+    printf("fraction of %u draws of random16() under each threshold\n", CALLS);
+    seedRandom(1);
+    for(uint8_t i = 0; i < 4; i++)
+        {
+        uint32_t hits = 0;
+        for(uint32_t j = 0; j < CALLS; j++)
+            hits += (random16() < thresholds[i]);
+        printf("    %s    %.5f\n", names[i], (double) hits / CALLS);
+        }
+    }
+
+int main()
+    {
+    speed();
+    bias();
+    probabilities();
+    return harnessDone("RandomBench");
+    }
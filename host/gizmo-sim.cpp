@@ -0,0 +1,252 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// GIZMO-SIM
+//////
+////// Runs Gizmo on the host against a file of timestamped input, and prints its MIDI
+////// output (and optionally its display) with timestamps.  See host/README.
+//////
+////// Each line of the input file is a time in microseconds since power-on followed by
+//////
+//////     hex bytes                   MIDI bytes, sent back to back starting then
+//////     pot <n> <value>             pot n (0...3) moves to value (0...1023)
+//////     button <name> down|up       name is back, middle, or select
+//////
+////// Everything after a # is a comment.  Input must be in time order.
+
+#include "Simulator.h"
+#include "All.h"
+#include <stdio.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+
+struct Event
+    {
+    uint64_t time;
+    uint8_t type;                   // EVENT_POT or EVENT_BUTTON
+    uint8_t which;
+    uint16_t value;
+    };
+
+#define EVENT_POT 0
+#define EVENT_BUTTON 1
+#define MAX_EVENTS 65536
+
+static Event events[MAX_EVENTS];
+static uint32_t numEvents;
+static uint64_t lastInput;
+
+#if defined(__AVR_ATmega2560__)
+static const uint8_t potChannels[4] = { 0, 1, 14, 15 };
+#else
+static const uint8_t potChannels[4] = { 0, 1, 2, 3 };
+#endif
+static const uint8_t buttonPins[3] = { PIN_BACK_BUTTON, PIN_MIDDLE_BUTTON, PIN_SELECT_BUTTON };
+
+static uint8_t printMIDI = true;
+static uint8_t printFrames = false;
+
+static void midiOut(uint64_t time, uint8_t b)
+    {
+    if (printMIDI)
+        printf("%llu %02X\n", (unsigned long long) time, b);
+    }
+
+// Draws the 16x8 display: each byte of display RAM is one row of 8 LEDs of one matrix,
+// the even bytes are the left matrix and the odd bytes the right
+static void frame(uint64_t time, const uint8_t* ram)
+    {
+    if (!printFrames) return;
+    printf("%llu display\n", (unsigned long long) time);
+    for(uint8_t row = 0; row < 8; row++)
+        {
+        printf("    ");
+        for(uint8_t m = 0; m < 2; m++)
+            for(uint8_t col = 0; col < 8; col++)
+                putchar((ram[row * 2 + m] >> col) & 1 ? '#' : '.');
+        putchar('\n');
+        }
+    }
+
+static bool readInput(const char* filename)
+    {
+    FILE* f = fopen(filename, "r");
+    if (f == NULL) return false;
+    char line[1024];
+    int lineNumber = 0;
+    while(fgets(line, sizeof(line), f))
+        {
+        lineNumber++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        char* p = line;
+        while(isspace(*p)) p++;
+        if (*p == 0) continue;
+
+        char* end;
+        uint64_t time = strtoull(p, &end, 10);
+        if (end == p) { fprintf(stderr, "%s:%d: expected a time\n", filename, lineNumber); return false; }
+        p = end;
+        while(isspace(*p)) p++;
+
+        char name[32];
+        unsigned int which, value;
+        if (sscanf(p, "pot %u %u", &which, &value) == 2 && which < 4)
+            {
+            events[numEvents].time = time;
+            events[numEvents].type = EVENT_POT;
+            events[numEvents].which = which;
+            events[numEvents].value = value;
+            numEvents++;
+            }
+        else if (sscanf(p, "button %31s", name) == 1)
+            {
+            uint8_t b = (!strcmp(name, "back") ? 0 : !strcmp(name, "middle") ? 1 : !strcmp(name, "select") ? 2 : 3);
+            if (b == 3) { fprintf(stderr, "%s:%d: unknown button %s\n", filename, lineNumber, name); return false; }
+            events[numEvents].time = time;
+            events[numEvents].type = EVENT_BUTTON;
+            events[numEvents].which = b;
+            events[numEvents].value = (strstr(p, "down") != NULL);
+            numEvents++;
+            }
+        else
+            {
+            // MIDI bytes, back to back, each taking 320us to arrive
+            while(*p)
+                {
+                unsigned long b = strtoul(p, &end, 16);
+                if (end == p) { fprintf(stderr, "%s:%d: can't read %s\n", filename, lineNumber, p); return false; }
+                p = end;
+                while(isspace(*p)) p++;
+                time += 320;
+                simMIDIIn(time, (uint8_t) b);
+                }
+            }
+        if (numEvents == MAX_EVENTS) { fprintf(stderr, "%s: too many events\n", filename); return false; }
+        if (time > lastInput) lastInput = time;
+        }
+    fclose(f);
+    return true;
+    }
+
+//// Host time spent in go(), by state
+struct Profile
+    {
+    uint64_t calls;
+    uint64_t total;
+    uint64_t worst;
+    };
+
+static Profile profile[256];
+
+static uint64_t hostNanos()
+    {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+static void usage()
+    {
+    fprintf(stderr,
+        "usage: gizmo-sim [options] [input]\n"
+        "    -t seconds      run this long (default: 2 seconds past the end of the input)\n"
+        "    -e file         load the EEPROM from file first, if it exists\n"
+        "    -E file         save the EEPROM to file at the end\n"
+        "    -d              print the display whenever it changes\n"
+        "    -q              don't print MIDI output\n"
+        "    -p              print the host time spent in go() in each state\n"
+        "    -s factor       charge go() factor times its host time in simulated time\n");
+    exit(1);
+    }
+
+int main(int argc, char** argv)
+    {
+    double seconds = -1;
+    const char* eepromIn = NULL;
+    const char* eepromOut = NULL;
+    uint8_t doProfile = false;
+    double slowdown = 0;
+    int c;
+    while((c = getopt(argc, argv, "t:e:E:dqps:")) != -1)
+        {
+        switch(c)
+            {
+            case 't': seconds = atof(optarg); break;
+            case 'e': eepromIn = optarg; break;
+            case 'E': eepromOut = optarg; break;
+            case 'd': printFrames = true; break;
+            case 'q': printMIDI = false; break;
+            case 'p': doProfile = true; break;
+            case 's': slowdown = atof(optarg); break;
+            default: usage();
+            }
+        }
+    if (optind + 1 < argc) usage();
+
+    simPowerOn();
+    if (eepromIn) simLoadEEPROM(eepromIn);
+    if (optind < argc && !readInput(argv[optind]))
+        {
+        fprintf(stderr, "gizmo-sim: couldn't read %s\n", argv[optind]);
+        return 1;
+        }
+    uint64_t end = (seconds >= 0 ? (uint64_t)(seconds * 1000000) : lastInput + 2000000);
+
+    simMIDIOutHook = midiOut;
+    simFrameHook = frame;
+
+    try
+        {
+        simBoot();
+        uint32_t next = 0;
+        while(simTime < end)
+            {
+            while(next < numEvents && events[next].time <= simTime)
+                {
+                if (events[next].type == EVENT_POT)
+                    simAnalog[potChannels[events[next].which]] = events[next].value;
+                else
+                    simPins[buttonPins[events[next].which]] = (events[next].value ? LOW : HIGH);
+                next++;
+                }
+            updateTicksAndWait();
+            uint8_t s = state;
+            uint64_t start = hostNanos();
+            go();
+            uint64_t elapsed = hostNanos() - start;
+            if (slowdown > 0)
+                simAdvance((uint32_t)(elapsed * slowdown / 1000));
+            profile[s].calls++;
+            profile[s].total += elapsed;
+            if (elapsed > profile[s].worst) profile[s].worst = elapsed;
+            }
+        }
+    catch (SimSoftRestart)
+        {
+        fprintf(stderr, "gizmo-sim: soft restart at %llu\n", (unsigned long long) simTime);
+        }
+
+    if (eepromOut && !simSaveEEPROM(eepromOut))
+        fprintf(stderr, "gizmo-sim: couldn't write %s\n", eepromOut);
+
+    if (doProfile)
+        {
+        fprintf(stderr, "state      ticks    mean ns   worst ns\n");
+        for(int s = 0; s < 256; s++)
+            if (profile[s].calls)
+                fprintf(stderr, "%5d %10llu %10llu %10llu\n", s, (unsigned long long) profile[s].calls,
+                    (unsigned long long)(profile[s].total / profile[s].calls), (unsigned long long) profile[s].worst);
+#ifdef INCLUDE_PROFILER
+        fprintf(stderr, "late ticks %lu (worst %lu us), late pulses %lu (worst %lu us), dropped %lu us, drift %ld us\n",
+            (unsigned long) tickStats.lateTicks, (unsigned long) tickStats.worstTickLateness,
+            (unsigned long) tickStats.latePulses, (unsigned long) tickStats.worstPulseLateness,
+            (unsigned long) tickStats.droppedTime, (long) tickStats.drift);
+#endif INCLUDE_PROFILER
+        fprintf(stderr, "display frames %lu, receive overruns %lu\n",
+            (unsigned long) simDisplay.frames, (unsigned long) simErrors.rxOverruns);
+        }
+    return 0;
+    }
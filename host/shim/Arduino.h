@@ -0,0 +1,124 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HOST_ARDUINO_H__
+#define __HOST_ARDUINO_H__
+
+//// HOST SHIM: ARDUINO CORE
+////
+//// Just enough of the Arduino core to compile and run Gizmo on the host.  Time is
+//// virtual: micros() and millis() read the simulator's clock, and delay() and
+//// delayMicroseconds() advance it, running whatever interrupts come due in the
+//// meantime.  Everything here is implemented in host/Simulator.cpp.
+////
+//// Note that on the host an int is 32 bits and a long is 64, where on the AVR they're
+//// 16 and 32.  Gizmo mostly uses the <stdint.h> types, so this rarely matters.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#if defined(__AVR_ATmega2560__)
+#define NUM_DIGITAL_PINS 70
+#define A0 54
+#define SDA 20
+#define SCL 21
+#else
+#define NUM_DIGITAL_PINS 20
+#define A0 14
+#define SDA 18
+#define SCL 19
+#endif
+#define A1 (A0 + 1)
+#define A2 (A0 + 2)
+#define A3 (A0 + 3)
+#define A4 (A0 + 4)
+#define A5 (A0 + 5)
+#if defined(__AVR_ATmega2560__)
+#define A6 (A0 + 6)
+#define A7 (A0 + 7)
+#define A8 (A0 + 8)
+#define A9 (A0 + 9)
+#define A10 (A0 + 10)
+#define A11 (A0 + 11)
+#define A12 (A0 + 12)
+#define A13 (A0 + 13)
+#define A14 (A0 + 14)
+#define A15 (A0 + 15)
+#endif
+
+#define F(s) (s)
+
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+#define abs(x) ((x)>0?(x):-(x))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+
+// Each pin is its own "port" with a mask of 1, so *portInputRegister(digitalPinToPort(pin))
+// is just the state of the pin.  Buttons are pulled up, so a pressed button is LOW.
+extern volatile uint8_t simPins[NUM_DIGITAL_PINS];
+#define digitalPinToBitMask(pin) ((uint8_t) 1)
+#define digitalPinToPort(pin) (pin)
+#define portOutputRegister(port) (&simPins[(port)])
+#define portInputRegister(port) (&simPins[(port)])
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+void delayMicroseconds(unsigned int us);
+
+#define RANDOM_MAX 0x7FFFFFFF
+long random();                          // avr-libc's, 0...RANDOM_MAX
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+//// The USART, with a 64-byte transmit and receive buffer like the Arduino core's
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SERIAL_RX_BUFFER_SIZE 64
+class HardwareSerial
+    {
+    public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    int availableForWrite();
+    size_t write(uint8_t b);
+    };
+
+extern HardwareSerial Serial;
+
+void setup();
+void loop();
+
+#endif __HOST_ARDUINO_H__
@@ -0,0 +1,28 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HOST_EEPROM_H__
+#define __HOST_EEPROM_H__
+
+#include <stdint.h>
+
+//// HOST SHIM: EEPROM
+//// Like the real library, read() and write() wait for a write that's still going on,
+//// and a write keeps the EEPROM busy (EEPE in EECR) for 3.3ms of simulated time.
+
+uint8_t simEEPROMRead(uint16_t address);
+void simEEPROMWrite(uint16_t address, uint8_t val);
+uint16_t simEEPROMLength();
+
+struct EEPROMClass
+    {
+    uint8_t read(int address) { return simEEPROMRead(address); }
+    void write(int address, uint8_t val) { simEEPROMWrite(address, val); }
+    void update(int address, uint8_t val) { if (simEEPROMRead(address) != val) simEEPROMWrite(address, val); }
+    uint16_t length() { return simEEPROMLength(); }
+    };
+
+extern EEPROMClass EEPROM;
+
+#endif __HOST_EEPROM_H__
@@ -0,0 +1,14 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HOST_SOFTRESET_H__
+#define __HOST_SOFTRESET_H__
+
+//// HOST SHIM: SOFT RESET
+//// The simulator stops the run (see simSoftRestart() in host/Simulator.h).
+
+void simSoftRestart();
+#define soft_restart() simSoftRestart()
+
+#endif __HOST_SOFTRESET_H__
@@ -0,0 +1,23 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HOST_AVR_INTERRUPT_H__
+#define __HOST_AVR_INTERRUPT_H__
+
+#include <avr/io.h>
+
+//// HOST SHIM: INTERRUPTS
+////
+//// An ISR is an ordinary function which the simulator calls when the hardware it
+//// models raises the interrupt, so long as interrupts are on (the I bit of SREG).
+
+#define ISR(vector) extern "C" void vector(void)
+
+void simInterruptsOn();
+void simInterruptsOff();
+
+#define sei() simInterruptsOn()
+#define cli() simInterruptsOff()
+
+#endif __HOST_AVR_INTERRUPT_H__
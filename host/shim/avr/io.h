@@ -0,0 +1,110 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HOST_AVR_IO_H__
+#define __HOST_AVR_IO_H__
+
+#include <stdint.h>
+
+
+//// HOST SHIM: AVR REGISTERS
+////
+//// On the host, each hardware register Gizmo touches is a SimRegister.  Reading or
+//// writing it calls into the simulator (see host/Simulator.cpp), which models the
+//// hardware behind it: the ADC, the TWI (I2C) bus to the LED backpack, the USART,
+//// Timer3, and the EEPROM.  Only the registers and bits Gizmo uses are here.
+
+enum
+    {
+    SIM_SREG,
+    SIM_ADCSRA, SIM_ADCSRB, SIM_ADMUX, SIM_ADC,
+    SIM_TWCR, SIM_TWSR, SIM_TWBR, SIM_TWDR,
+    SIM_UCSR0A, SIM_UCSR0B, SIM_UDR0,
+    SIM_TCCR3A, SIM_TCCR3B, SIM_TIMSK3, SIM_TIFR3, SIM_OCR3A, SIM_TCNT3,
+    SIM_EECR,
+    SIM_NUM_REGISTERS
+    };
+
+uint16_t simReadRegister(uint8_t reg);
+void simWriteRegister(uint8_t reg, uint16_t val);
+
+template <class T> class SimRegister
+    {
+    uint8_t reg;
+    public:
+    SimRegister(uint8_t r) : reg(r) { }
+    operator T() const { return (T) simReadRegister(reg); }
+    SimRegister& operator=(T val) { simWriteRegister(reg, val); return *this; }
+    SimRegister& operator=(const SimRegister& other) { simWriteRegister(reg, (T) other); return *this; }
+    SimRegister& operator|=(T val) { simWriteRegister(reg, (T)(simReadRegister(reg) | val)); return *this; }
+    SimRegister& operator&=(T val) { simWriteRegister(reg, (T)(simReadRegister(reg) & val)); return *this; }
+    SimRegister& operator^=(T val) { simWriteRegister(reg, (T)(simReadRegister(reg) ^ val)); return *this; }
+    SimRegister& operator+=(T val) { simWriteRegister(reg, (T)(simReadRegister(reg) + val)); return *this; }
+    };
+
+extern SimRegister<uint8_t> SREG;
+extern SimRegister<uint8_t> ADCSRA, ADCSRB, ADMUX;
+extern SimRegister<uint16_t> ADC;
+extern SimRegister<uint8_t> TWCR, TWSR, TWBR, TWDR;
+extern SimRegister<uint8_t> UCSR0A, UCSR0B, UDR0;
+extern SimRegister<uint8_t> EECR;
+#if defined(__AVR_ATmega2560__)
+extern SimRegister<uint8_t> TCCR3A, TCCR3B, TIMSK3, TIFR3;
+extern SimRegister<uint16_t> OCR3A, TCNT3;
+#endif
+
+#define _BV(bit) (1 << (bit))
+
+// SREG
+#define SREG_I 7
+
+// ADC
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+#if defined(__AVR_ATmega2560__)
+#define MUX5 3
+#endif
+
+// TWI
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+
+// USART
+#define RXC0 7
+#define TXC0 6
+#define UDRE0 5
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0 4
+#define TXEN0 3
+
+// Timer3
+#define OCIE3A 1
+#define OCF3A 1
+#define CS32 2
+#define CS31 1
+#define CS30 0
+
+// EEPROM
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+
+#endif __HOST_AVR_IO_H__
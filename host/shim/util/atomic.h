@@ -0,0 +1,18 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HOST_UTIL_ATOMIC_H__
+#define __HOST_UTIL_ATOMIC_H__
+
+#include <avr/interrupt.h>
+
+//// HOST SHIM: ATOMIC BLOCKS
+//// Interrupts only happen when the simulator advances time, never in the middle of
+//// the firmware's code, so atomic blocks don't need to do anything.
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for(uint8_t __done = 0; !__done; __done = 1)
+
+#endif __HOST_UTIL_ATOMIC_H__
@@ -0,0 +1,24 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+#ifndef __HOST_UTIL_TWI_H__
+#define __HOST_UTIL_TWI_H__
+
+#include <avr/io.h>
+
+//// HOST SHIM: TWI STATUS CODES (master transmitter only)
+
+#define TW_STATUS (TWSR & 0xF8)
+#define TW_START 0x08
+#define TW_REP_START 0x10
+#define TW_MT_SLA_ACK 0x18
+#define TW_MT_SLA_NACK 0x20
+#define TW_MT_DATA_ACK 0x28
+#define TW_MT_DATA_NACK 0x30
+#define TW_MT_ARB_LOST 0x38
+#define TW_BUS_ERROR 0x00
+#define TW_WRITE 0
+#define TW_READ 1
+
+#endif __HOST_UTIL_TWI_H__
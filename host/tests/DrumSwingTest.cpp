@@ -0,0 +1,198 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// DRUM SWING TEST
+//////
+////// Checks that the drum sequencer swings at every group speed, and never moves the note
+////// pulse (see SPEEDS in DrumSequencer.h).  We play eighth notes with swing, and check when
+////// each note goes out: every other step, starting with the second, should be held back
+////// by the swing's fraction of a step.
+//////
+//////     - A group at 1x steps on the note pulse, and swings with it.  Groups at 2x, 4x
+//////       and 1/2x are clocked, and swing on their own.
+//////
+//////     - In performance mode, a 2x group three steps long, played once, leaves the 1x
+//////       group after it starting off the note pulse.  It's clocked too, and swings on
+//////       its own from where it started.  Seeking into it doesn't move the note
+//////       pulse either.
+//////
+////// All along, the note pulse must keep the phase it had when the clock started.
+
+#include "Harness.h"
+
+#ifndef INCLUDE_DRUM_SEQUENCER
+
+int main()
+    {
+    printf("DrumSwingTest: nothing to test without INCLUDE_DRUM_SEQUENCER\n");
+    return 0;
+    }
+
+#else
+
+// DrumSequencer.cpp doesn't declare these in DrumSequencer.h
+void initDrumSequencer(uint8_t format);
+void setNote(uint8_t group, uint8_t track, uint8_t note, uint8_t val);
+void setNoteSpeed(uint8_t group, uint8_t noteSpeed);
+void setGroupLengthData(uint8_t group, uint8_t groupLength);
+
+#define TEMPO 1200
+#define SWING 40
+#define PITCH DRUM_SEQUENCER_INITIAL_NOTE_PITCH              // track 0
+#define MAX_NOTES 64
+#define TOLERANCE 1500                                      // microseconds: a few ticks, and a few bytes ahead in the queue
+
+static uint64_t noteTimes[MAX_NOTES];
+static uint8_t numNotes;
+
+// Finds the Note Ons for PITCH among the bytes sent, minding running status
+static void findNotes()
+    {
+    uint8_t status = harnessStatus;
+    uint8_t count = 0;
+    uint8_t pitch = 0;
+    numNotes = 0;
+    for(uint32_t i = 0; i < harnessNumOut; i++)
+        {
+        uint8_t b = harnessOut[i].b;
+        if (b >= 0xF8) continue;                            // real time
+        if (b >= 0x80) { status = (b < 0xF0 ? b : 0); count = 0; continue; }
+        if (count == 0) { pitch = b; count = 1; continue; }
+        count = 0;
+        if ((status & 0xF0) == MIDINoteOn && pitch == PITCH && b > 0 && numNotes < MAX_NOTES)
+            noteTimes[numNotes++] = harnessOut[i].time;
+        }
+    }
+
+// The note pulse's phase: which pulses it falls on
+static uint8_t notePulsePhase()
+    {
+    return (uint8_t)((pulseCount + notePulseCountdown) % notePulseRate);
+    }
+
+// Starts the sequence as the Select button does, and plays it for the given number of
+// pulses.  The note pulse's phase mustn't change once the clock has started.
+static void play(uint32_t pulses)
+    {
+    stopDrumSequencer();
+    stopClock(true);
+    harnessRunUntil(simTime + 100000);
+    harnessClearOut();
+    local.drumSequencer.playState = PLAY_STATE_WAITING;
+    startClock(true);
+    harnessTick();
+    uint8_t phase = notePulsePhase();
+    uint32_t end = pulseCount + pulses;
+    while(pulseCount != end)
+        {
+        harnessTick();
+        CHECK_EQUAL(notePulsePhase(), phase);
+        }
+    findNotes();
+    }
+
+// Checks that note n went out AT[n] pulses after the first, plus the swing's fraction of
+// LATE[n] pulses if it's held back
+static void checkNotes(const uint16_t* at, const uint8_t* late, uint8_t count)
+    {
+    CHECK(numNotes >= count);
+    for(uint8_t n = 1; n < numNotes && n < count; n++)
+        {
+        uint64_t due = noteTimes[0] + (uint64_t) at[n] * 25000000ULL / TEMPO + div100(late[n] * getMicrosecsPerPulse() * SWING);
+        int64_t error = (int64_t)(noteTimes[n] - due);
+        if (error < -TOLERANCE || error > TOLERANCE)
+            {
+            fprintf(stderr, "    note %u is %lld us off\n", n, (long long) error);
+            CHECK(false);
+            }
+        }
+    }
+
+static void create()
+    {
+    initDrumSequencer(DRUM_SEQUENCER_DEFAULT_FORMAT);
+    for(uint8_t g = 0; g < 2; g++)
+        for(uint8_t n = 0; n < local.drumSequencer.numNotes; n++)
+            setNote(g, 0, n, 1);
+    application = STATE_DRUM_SEQUENCER;
+    state = STATE_DRUM_SEQUENCER_PLAY;
+    entry = true;
+    }
+
+// A group playing forever at each speed: every other step is held back
+static void speeds()
+    {
+    static const uint8_t twelfths[] = { 12, 6, 3, 24 };     // default, 2x, 4x, 1/2x
+    uint16_t at[MAX_NOTES];
+    uint8_t late[MAX_NOTES];
+    for(uint8_t speed = 0; speed < 4; speed++)
+        {
+        create();
+        setNoteSpeed(0, speed);
+        uint8_t step = notePulseRate * twelfths[speed] / 12;
+        for(uint8_t n = 0; n < 32; n++)
+            {
+            at[n] = n * step;
+            late[n] = (n & 1 ? step : 0);
+            }
+        play((uint32_t) step * 32);
+        checkNotes(at, late, 32);
+        }
+    }
+
+// A 2x group three steps long, played once, then a 1x group: it starts half a note off
+// the note pulse, and swings every other step from there
+static void offTheNotePulse()
+    {
+    uint16_t at[MAX_NOTES];
+    uint8_t late[MAX_NOTES];
+    create();
+    setNoteSpeed(0, 1);
+    setGroupLengthData(0, 3);
+    local.drumSequencer.performanceMode = true;
+    local.drumSequencer.transitionGroup[0] = 0;
+    local.drumSequencer.transitionRepeat[0] = 1;
+    local.drumSequencer.transitionGroup[1] = 1;
+    local.drumSequencer.transitionRepeat[1] = DRUM_SEQUENCER_TRANSITION_REPEAT_LOOP;
+
+    uint8_t half = notePulseRate / 2;
+    for(uint8_t n = 0; n < 3; n++)
+        {
+        at[n] = n * half;
+        late[n] = (n & 1 ? half : 0);
+        }
+    for(uint8_t n = 3; n < 23; n++)
+        {
+        at[n] = 3 * half + (n - 3) * notePulseRate;
+        late[n] = ((n - 3) & 1 ? notePulseRate : 0);
+        }
+    play(3 * half + 20 * notePulseRate);
+    checkNotes(at, late, 23);
+
+    // seeking leaves the note pulse where setSongPosition() put it, too
+    for(uint32_t position = 1; position < 3 * half + 4 * (uint32_t) notePulseRate; position++)
+        {
+        uint8_t countdown = notePulseCountdown;
+        seekDrumSequencer(position);
+        CHECK_EQUAL(notePulseCountdown, countdown);
+        }
+    }
+
+int main()
+    {
+    harnessBoot();
+    options.clock = IGNORE_MIDI_CLOCK;
+    options.tempo = TEMPO;
+    setPulseRate(options.tempo);
+    options.noteSpeedType = NOTE_SPEED_EIGHTH;
+    setNotePulseRate(options.noteSpeedType);
+    options.swing = SWING;
+
+    speeds();
+    offTheNotePulse();
+
+    return harnessDone("DrumSwingTest");
+    }
+
+#endif INCLUDE_DRUM_SEQUENCER
@@ -0,0 +1,84 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// OPTIONS TEST
+//////
+////// Checks that loadOptions() copes with a board upgraded without a factory reset, whose
+////// EEPROM holds options saved by an older Gizmo (see Options.cpp):
+//////
+//////     - An option added since then reads back as 0xFF, the EEPROM's erased value, and
+//////       must be brought back into range before a menu uses it as an item index.
+//////
+//////     - Its tempo is in whole BPM, not tenths, and it has no OPTIONS_MAGIC.  It's
+//////       multiplied by 10 and saved with the magic, once: booting again leaves it alone.
+//////
+//////     - A tempo out of range, saved or upgraded, is clamped to MINIMUM_TEMPO..MAXIMUM_TEMPO.
+
+#include "Harness.h"
+
+// Writes the given byte over the saved option at the given offset in struct _options, then
+// reboots
+static void corrupt(uint16_t offset, uint8_t b)
+    {
+    simEEPROM[OPTIONS_OFFSET + offset] = b;
+    simPowerOn();
+    simBoot();
+    }
+
+// Writes the given tempo over the saved one, as a Gizmo from before OPTIONS_MAGIC would
+// have if old is true, then reboots
+static void saveTempo(uint16_t tempo, uint8_t old)
+    {
+    simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, tempo)] = tempo & 0xFF;
+    simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, tempo) + 1] = tempo >> 8;
+    if (old)
+        {
+        simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, magic)] = 0xFF;
+        simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, version)] = 0xFF;
+        simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, midiOutRunningStatus)] = 0xFF;
+        }
+    simPowerOn();
+    simBoot();
+    }
+
+static uint16_t savedTempo()
+    {
+    return simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, tempo)] |
+        ((uint16_t) simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, tempo) + 1] << 8);
+    }
+
+int main()
+    {
+    harnessBoot();
+
+    corrupt(offsetof(struct _options, midiOutRunningStatus), 0xFF);
+    CHECK_EQUAL(options.midiOutRunningStatus, MIDI_OUT_RUNNING_STATUS);
+
+    // the ones in range are left alone
+    corrupt(offsetof(struct _options, midiOutRunningStatus), MIDI_OUT_NO_RUNNING_STATUS);
+    CHECK_EQUAL(options.midiOutRunningStatus, MIDI_OUT_NO_RUNNING_STATUS);
+
+    // an old board's 120 BPM is upgraded to 120.0 once, and saved
+    saveTempo(120, true);
+    CHECK_EQUAL(options.tempo, 1200);
+    CHECK_EQUAL(options.midiOutRunningStatus, MIDI_OUT_RUNNING_STATUS);
+    CHECK_EQUAL(simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, magic)], OPTIONS_MAGIC);
+    CHECK_EQUAL(simEEPROM[OPTIONS_OFFSET + offsetof(struct _options, version)], OPTIONS_VERSION);
+    CHECK_EQUAL(savedTempo(), 1200);
+    simPowerOn();
+    simBoot();
+    CHECK_EQUAL(options.tempo, 1200);
+
+    // out of range
+    saveTempo(0, false);
+    CHECK_EQUAL(options.tempo, MINIMUM_TEMPO);
+    saveTempo(65535, false);
+    CHECK_EQUAL(options.tempo, MAXIMUM_TEMPO);
+    saveTempo(0, true);
+    CHECK_EQUAL(options.tempo, MINIMUM_TEMPO);
+    saveTempo(6554, true);
+    CHECK_EQUAL(options.tempo, MAXIMUM_TEMPO);
+
+    return harnessDone("OptionsTest");
+    }
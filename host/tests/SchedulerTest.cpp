@@ -0,0 +1,132 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// SCHEDULER TEST
+//////
+////// Checks the note off entries (see Scheduler.h):
+//////
+//////     - Each step sequencer track and the click only ever cancel their own note offs,
+//////       and every track plus the click can have a note off pending at once.
+//////
+//////     - NOTE_OFF_ANY note offs use the entries nobody reserved, as many at once as
+//////       there are.  One more sends the one due soonest early, and nothing else.
+//////
+//////     - Once the pool is reserved, reserveNoteOffs() gives NOTE_OFF_ANY, and a
+//////       NOTE_OFF_ANY note off with nowhere to go is sent at once.
+
+#include "Harness.h"
+
+// The times at which note offs for the given note went out.  Gizmo uses running status,
+// so a note off needn't have its own status byte, even the first one after harnessClearOut().
+static uint32_t noteOffsFor(uint8_t note, uint64_t* times)
+    {
+    uint32_t n = 0;
+    uint8_t status = harnessStatus;
+    for(uint32_t i = 0; i < harnessNumOut; i++)
+        {
+        uint8_t b = harnessOut[i].b;
+        if (b >= 0xF8) continue;                        // realtime bytes can come anywhere
+        if (b & 0x80) { status = b; continue; }
+        if ((status & 0xF0) == 0x80 && b == note)
+            times[n++] = harnessOut[i].time;
+        i++;                                            // skip the velocity
+        }
+    return n;
+    }
+
+int main()
+    {
+    uint64_t times[64];
+    harnessBoot();
+    harnessTick();
+
+    // the tracks' entries and the click's are all different
+    uint8_t owned = MAX_STEP_SEQUENCER_TRACKS + 1;
+    uint8_t entries[MAX_STEP_SEQUENCER_TRACKS + 1];
+    for(uint8_t i = 0; i < MAX_STEP_SEQUENCER_TRACKS; i++)
+        entries[i] = NOTE_OFF_ENTRY(stepSequencerNoteOffs, i);
+    entries[MAX_STEP_SEQUENCER_TRACKS] = clickNoteOff;
+    for(uint8_t i = 0; i < owned; i++)
+        {
+        CHECK(entries[i] < NUM_NOTE_OFFS);
+        for(uint8_t j = 0; j < i; j++)
+            CHECK(entries[i] != entries[j]);
+        }
+
+    // a track and the click with a note off for the same note and channel
+    uint64_t start = simTime;
+    scheduleNoteOff(entries[0], 60, 1, currentTime + 10000);
+    scheduleNoteOff(clickNoteOff, 60, 1, currentTime + 20000);
+    CHECK(cancelNoteOff(entries[0]));
+    CHECK(!cancelNoteOff(entries[0]));
+    harnessRunUntil(start + 40000);
+    CHECK_EQUAL(noteOffsFor(60, times), 1);
+    CHECK(times[0] >= start + 20000 && times[0] < start + 20000 + NOTE_OFF_BUCKET_WIDTH + TARGET_TICK_TIMESTEP * 2);
+    CHECK(!cancelNoteOff(clickNoteOff));            // it's gone out
+
+    // every track and the click at once, and none of them is sent early
+    harnessClearOut();
+    start = simTime;
+    for(uint8_t i = 0; i < owned; i++)
+        scheduleNoteOff(entries[i], 40 + i, 1, currentTime + 5000 + i * 1000);
+    harnessRunUntil(start + 4000);
+    CHECK_EQUAL(harnessNumOut, 0);
+    harnessRunUntil(start + 40000);
+    for(uint8_t i = 0; i < owned; i++)
+        {
+        CHECK_EQUAL(noteOffsFor(40 + i, times), 1);
+        CHECK(times[0] >= start + 5000 + i * 1000);
+        }
+
+    // the rest of the pool for NOTE_OFF_ANY, alongside the owners, then one more
+    uint8_t free = NUM_NOTE_OFFS - owned;
+    CHECK(free > 0);
+    harnessClearOut();
+    start = simTime;
+    for(uint8_t i = 0; i < owned; i++)
+        scheduleNoteOff(entries[i], 20 + i, 2, currentTime + 30000);
+    for(uint8_t i = 0; i < free; i++)
+        scheduleNoteOff(NOTE_OFF_ANY, 40 + i, 1, currentTime + 10000 + i * 1000);
+    CHECK(!cancelNoteOff(NOTE_OFF_ANY));
+    harnessTick();
+    CHECK_EQUAL(harnessNumOut, 0);
+    scheduleNoteOff(NOTE_OFF_ANY, 39, 1, currentTime + 50000);
+    harnessTick();
+    CHECK_EQUAL(noteOffsFor(40, times), 1);         // the soonest, early
+    CHECK(times[0] < start + 10000);
+    for(uint8_t i = 1; i < free; i++)
+        CHECK_EQUAL(noteOffsFor(40 + i, times), 0);
+    harnessRunUntil(start + 100000);
+    for(uint8_t i = 1; i < free; i++)
+        {
+        CHECK_EQUAL(noteOffsFor(40 + i, times), 1);
+        CHECK(times[0] >= start + 10000 + i * 1000);
+        }
+    CHECK_EQUAL(noteOffsFor(39, times), 1);
+    CHECK(times[0] >= start + 50000);
+    for(uint8_t i = 0; i < owned; i++)
+        CHECK_EQUAL(noteOffsFor(20 + i, times), 1);
+
+    // rescheduling a pending entry sends its old note off right away
+    harnessClearOut();
+    scheduleNoteOff(entries[3], 70, 1, currentTime + 100000);
+    scheduleNoteOff(entries[3], 71, 1, currentTime + 10000);
+    harnessTick();
+    CHECK_EQUAL(noteOffsFor(70, times), 1);
+    harnessRunUntil(simTime + 200000);
+    CHECK_EQUAL(noteOffsFor(70, times), 1);
+    CHECK_EQUAL(noteOffsFor(71, times), 1);
+
+    // a full pool
+    CHECK(reserveNoteOffs(free) != NOTE_OFF_ANY);
+    uint8_t none = reserveNoteOffs(1);
+    CHECK_EQUAL(none, NOTE_OFF_ANY);
+    CHECK_EQUAL(NOTE_OFF_ENTRY(none, 5), NOTE_OFF_ANY);
+    harnessClearOut();
+    scheduleNoteOff(NOTE_OFF_ANY, 80, 1, currentTime + 100000);
+    harnessTick();
+    CHECK_EQUAL(noteOffsFor(80, times), 1);
+
+    return harnessDone("SchedulerTest");
+    }
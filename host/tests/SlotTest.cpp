@@ -0,0 +1,265 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// SLOT TEST
+//////
+////// Checks the compressed slots (see Storage.h):
+//////
+//////     - The old nine-slot layout is upgraded in place, and a slot which can't be
+//////       moved without writing over one which hasn't been moved yet is emptied.
+//////
+//////     - If the power goes out at any point during a save, the slot is either as it
+//////       was or as it was saved, or (only when its type is changing or there's no room
+//////       for a second copy) empty.  We check this by decoding the slot straight out of
+//////       the EEPROM after every byte the save writes, without going through Storage.cpp.
+//////
+//////     - A save which doesn't fit is refused, and leaves the slot as it was.
+
+#include "Harness.h"
+
+#ifndef INCLUDE_COMPRESSED_SLOTS
+
+int main()
+    {
+    printf("SlotTest: nothing to test without INCLUDE_COMPRESSED_SLOTS\n");
+    return 0;
+    }
+
+#else
+
+#define GARBAGE -1
+
+struct Contents
+    {
+    int type;
+    uint8_t bytes[SLOT_DATA_SIZE];
+    };
+
+// Mostly zeros, which packs to about 2/3 of a slot
+static void sparse(Contents* c, int type, uint8_t seed)
+    {
+    c->type = type;
+    for(uint16_t i = 0; i < SLOT_DATA_SIZE; i++)
+        c->bytes[i] = (i % 5 == 0 ? (uint8_t)(i * 7 + seed) | 1 : 0);
+    }
+
+// No zeros at all, which doesn't pack
+static void dense(Contents* c, int type, uint32_t seed)
+    {
+    c->type = type;
+    for(uint16_t i = 0; i < SLOT_DATA_SIZE; i++)
+        {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        c->bytes[i] = (uint8_t) seed | 1;
+        }
+    }
+
+static void empty(Contents* c)
+    {
+    c->type = SLOT_TYPE_EMPTY;
+    memset(c->bytes, 0, SLOT_DATA_SIZE);
+    }
+
+// Decodes a slot straight from the EEPROM.  Returns the type, or GARBAGE.
+static int decode(uint8_t index, uint8_t* out)
+    {
+    const uint8_t* e = simEEPROM;
+    if (e[SLOT_DIRECTORY_OFFSET] != SLOT_MAGIC_0 || e[SLOT_DIRECTORY_OFFSET + 1] != SLOT_MAGIC_1)
+        return GARBAGE;
+    uint8_t type = e[SLOT_ENTRY_OFFSET + index * 2];
+    uint8_t block = e[SLOT_ENTRY_OFFSET + index * 2 + 1];
+    if (type == SLOT_TYPE_EMPTY) return type;
+    if (type != SLOT_TYPE_STEP_SEQUENCER && type != SLOT_TYPE_DRUM_SEQUENCER && type != SLOT_TYPE_RECORDER)
+        return GARBAGE;
+
+    uint16_t pos = SLOT_BLOCK_SIZE;
+    uint16_t at = 0;
+    uint8_t blocks = 0;
+    uint16_t o = 0;
+    while(o < SLOT_DATA_SIZE)
+        {
+        uint8_t b[2];
+        for(uint8_t k = 0; k < 2; k++)
+            {
+            if (k == 1 && b[0] >= 128) break;            // a run of zeros has no byte to follow
+            if (pos == SLOT_BLOCK_SIZE)
+                {
+                if (block >= NUM_SLOT_BLOCKS || blocks == SLOT_MAX_BLOCKS) return GARBAGE;
+                at = SLOT_OFFSET + block * SLOT_BLOCK_SIZE;
+                block = e[SLOT_BLOCK_TABLE_OFFSET + block];
+                blocks++;
+                pos = 0;
+                }
+            b[k] = e[at + pos++];
+            }
+        if (b[0] >= 128)
+            {
+            for(uint8_t z = 0; z < b[0] - 127; z++)
+                {
+                if (o == SLOT_DATA_SIZE) return GARBAGE;
+                out[o++] = 0;
+                }
+            }
+        else
+            {
+            // a literal run: the first byte's in b[1], the rest follow
+            uint8_t count = b[0] + 1;
+            for(uint8_t l = 0; l < count; l++)
+                {
+                if (o == SLOT_DATA_SIZE) return GARBAGE;
+                if (l > 0)
+                    {
+                    if (pos == SLOT_BLOCK_SIZE)
+                        {
+                        if (block >= NUM_SLOT_BLOCKS || blocks == SLOT_MAX_BLOCKS) return GARBAGE;
+                        at = SLOT_OFFSET + block * SLOT_BLOCK_SIZE;
+                        block = e[SLOT_BLOCK_TABLE_OFFSET + block];
+                        blocks++;
+                        pos = 0;
+                        }
+                    b[1] = e[at + pos++];
+                    }
+                out[o++] = b[1];
+                }
+            }
+        }
+    return type;
+    }
+
+static uint8_t matches(uint8_t index, Contents* c)
+    {
+    uint8_t out[SLOT_DATA_SIZE];
+    int type = decode(index, out);
+    if (type != c->type) return false;
+    return (type == SLOT_TYPE_EMPTY || !memcmp(out, c->bytes, SLOT_DATA_SIZE));
+    }
+
+// Checks the slot through Storage.cpp: its type, and what loadSlot() gives us
+static uint8_t loads(uint8_t index, Contents* c)
+    {
+    if (getSlotType(index) != c->type) return false;
+    if (c->type == SLOT_TYPE_EMPTY) return true;
+    loadSlot(index);
+    return (data.slot.type == c->type && !memcmp(data.slot.data.buffer, c->bytes, SLOT_DATA_SIZE));
+    }
+
+// Writes old-layout slots into the EEPROM, then boots
+static void bootOldLayout(Contents* old)
+    {
+    for(uint8_t i = 0; i < OLD_NUM_SLOTS; i++)
+        {
+        simEEPROM[SLOT_OFFSET + i * SLOT_SIZE] = (uint8_t) old[i].type;
+        memcpy(&simEEPROM[SLOT_OFFSET + i * SLOT_SIZE + 1], old[i].bytes, SLOT_DATA_SIZE);
+        }
+    CHECK(simEEPROM[SLOT_DIRECTORY_OFFSET] != SLOT_MAGIC_0);
+    simPowerOn();
+    simBoot();
+    }
+
+// Saves a slot, checking after each byte written that the power could go out then
+static uint8_t save(uint8_t index, Contents* before, Contents* after, uint8_t mayEmpty, uint8_t* wasEmpty)
+    {
+    data.slot.type = (uint8_t) after->type;
+    memcpy(data.slot.data.buffer, after->bytes, SLOT_DATA_SIZE);
+    if (!saveSlot(index)) return false;
+    *wasEmpty = false;
+    while(isSaving())
+        {
+        simAdvance(4000);
+        updateSaving();
+        Contents nothing;
+        empty(&nothing);
+        uint8_t isEmpty = matches(index, &nothing);
+        if (isEmpty) *wasEmpty = true;
+        CHECK(matches(index, before) || matches(index, after) || (mayEmpty && isEmpty));
+        }
+    CHECK(matches(index, after));
+    return true;
+    }
+
+int main()
+    {
+    static Contents old[OLD_NUM_SLOTS];
+    static Contents slots[NUM_SLOTS];
+    Contents nothing;
+    empty(&nothing);
+    harnessBoot();
+
+    // 1. Upgrading.  The dense slot packs to 13 blocks, more than it had before, but
+    // the sparse slots before it leave it room.
+    sparse(&old[0], SLOT_TYPE_STEP_SEQUENCER, 1);
+    empty(&old[1]);
+    sparse(&old[2], SLOT_TYPE_DRUM_SEQUENCER, 2);
+    dense(&old[3], SLOT_TYPE_DRUM_SEQUENCER, 3);
+    empty(&old[4]);
+    old[4].type = 0xFF;                                 // as on a new board
+    for(uint8_t i = 5; i < OLD_NUM_SLOTS; i++)
+        sparse(&old[i], SLOT_TYPE_STEP_SEQUENCER, i);
+    bootOldLayout(old);
+    for(uint8_t i = 0; i < NUM_SLOTS; i++)
+        {
+        if (i < OLD_NUM_SLOTS && old[i].type != 0xFF) slots[i] = old[i];
+        else empty(&slots[i]);
+        CHECK(matches(i, &slots[i]));
+        CHECK(loads(i, &slots[i]));
+        }
+
+    // Saving into free blocks: the old copy survives until the new one is complete
+    uint8_t wasEmpty;
+    Contents next;
+    sparse(&next, SLOT_TYPE_STEP_SEQUENCER, 100);
+    CHECK(save(0, &slots[0], &next, false, &wasEmpty));
+    slots[0] = next;
+
+    // Changing type may pass through empty, but never garbage
+    sparse(&next, SLOT_TYPE_STEP_SEQUENCER, 101);
+    CHECK(save(2, &slots[2], &next, true, &wasEmpty));
+    slots[2] = next;
+
+    // Fill up the blocks until there isn't room for a second copy of a dense slot
+    for(uint8_t i = 9; i < 12; i++)
+        {
+        dense(&next, SLOT_TYPE_DRUM_SEQUENCER, 1000 + i);
+        CHECK(save(i, &slots[i], &next, false, &wasEmpty));
+        slots[i] = next;
+        }
+    dense(&next, SLOT_TYPE_DRUM_SEQUENCER, 2000);
+    CHECK(save(11, &slots[11], &next, true, &wasEmpty));
+    CHECK(wasEmpty);                                    // it had to reuse its own blocks, so it emptied the slot first
+    slots[11] = next;
+
+    // and no room at all
+    dense(&next, SLOT_TYPE_DRUM_SEQUENCER, 3000);
+    CHECK(!save(12, &slots[12], &next, false, &wasEmpty));
+    CHECK(matches(12, &slots[12]));
+
+    // Everything's still there after a reboot
+    simPowerOn();
+    simBoot();
+    for(uint8_t i = 0; i < NUM_SLOTS; i++)
+        {
+        CHECK(matches(i, &slots[i]));
+        CHECK(loads(i, &slots[i]));
+        }
+
+    // 2. Upgrading, when a slot doesn't fit: a dense first slot would need 13 blocks,
+    // which would write over the start of the second slot before it's been moved
+    dense(&old[0], SLOT_TYPE_DRUM_SEQUENCER, 4000);
+    sparse(&old[1], SLOT_TYPE_STEP_SEQUENCER, 5);
+    for(uint8_t i = 2; i < OLD_NUM_SLOTS; i++)
+        empty(&old[i]);
+    bootOldLayout(old);
+    CHECK(matches(0, &nothing));
+    CHECK(loads(0, &nothing));
+    CHECK(matches(1, &old[1]));
+    CHECK(loads(1, &old[1]));
+    for(uint8_t i = 2; i < NUM_SLOTS; i++)
+        CHECK(loads(i, &nothing));
+
+    return harnessDone("SlotTest");
+    }
+
+#endif INCLUDE_COMPRESSED_SLOTS
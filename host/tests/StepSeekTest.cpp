@@ -0,0 +1,115 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// STEP SEEK TEST
+//////
+////// Checks seekStepSequencer() against playing the sequence from the start: after each
+////// step we seek to the same position and compare the play position, the countdown and
+////// countup, and whether we've stopped.  We try every repeat count, both stopping at the
+////// end and chaining back to the same sequence, which seek follows by looping.
+//////
+////// Until the sequence would be reloaded (forever, or before the countdown runs out)
+////// we also compare the mutes and solo, with one track in each scheduled state.
+
+#include "Harness.h"
+
+#define PASSES 300
+#define SLOT 0
+
+static const uint8_t mutes[] =
+    {
+    STEP_SEQUENCER_NOT_MUTED, STEP_SEQUENCER_MUTED,
+    STEP_SEQUENCER_MUTE_ON_SCHEDULED, STEP_SEQUENCER_MUTE_OFF_SCHEDULED,
+    STEP_SEQUENCER_MUTE_ON_SCHEDULED_ONCE, STEP_SEQUENCER_MUTE_OFF_SCHEDULED_ONCE
+    };
+
+// The mutes and solo as they were at the start
+static void schedule()
+    {
+    memcpy(local.stepSequencer.muted, mutes, sizeof(mutes));
+    local.stepSequencer.solo = STEP_SEQUENCER_SOLO_ON_SCHEDULED;
+    }
+
+// An empty 16 note sequence in performance mode, saved in SLOT so it can chain to itself
+static void create(uint8_t repeat)
+    {
+    data.slot.type = SLOT_TYPE_STEP_SEQUENCER;
+    data.slot.data.stepSequencer.format = STEP_SEQUENCER_FORMAT_16x12_;
+    data.slot.data.stepSequencer.repeat = repeat;
+    memset(data.slot.data.stepSequencer.buffer, 0, STEP_SEQUENCER_BUFFER_SIZE);
+    CHECK(saveSlot(SLOT));
+#ifdef INCLUDE_BACKGROUND_SAVE
+    finishSaving();
+#endif INCLUDE_BACKGROUND_SAVE
+    for(uint8_t i = 0; i < GET_NUM_TRACKS(); i++)
+        {
+        local.stepSequencer.data[i] = STEP_SEQUENCER_DATA_NOTE;
+        local.stepSequencer.pattern[i] = STEP_SEQUENCER_PATTERN_ALL;
+        local.stepSequencer.muted[i] = STEP_SEQUENCER_NOT_MUTED;
+        local.stepSequencer.noteOff[i] = NO_NOTE;
+        local.stepSequencer.tied[i] = false;
+        }
+    schedule();
+    local.stepSequencer.performanceMode = 1;
+    local.stepSequencer.goNextSequence = 0;
+    local.stepSequencer.transpose = 0;
+    resetStepSequencer();
+    local.stepSequencer.playState = PLAY_STATE_PLAYING;
+    }
+
+// Seeks from the start to just after the given step, and compares with where playing got to
+static void compare(uint32_t step, uint8_t mutesToo)
+    {
+    static _local played;
+    static union _data playedData;
+    memcpy(&played, &local, sizeof(local));
+    memcpy(&playedData, &data, sizeof(data));
+
+    schedule();
+    seekStepSequencer(step * notePulseRate + 1);
+    CHECK_EQUAL(local.stepSequencer.playState, played.stepSequencer.playState);
+    CHECK_EQUAL(local.stepSequencer.currentPlayPosition, played.stepSequencer.currentPlayPosition);
+    if (played.stepSequencer.playState != PLAY_STATE_STOPPED)
+        {
+        CHECK_EQUAL(local.stepSequencer.countdown, played.stepSequencer.countdown);
+        CHECK_EQUAL(local.stepSequencer.countup, played.stepSequencer.countup);
+        }
+    if (mutesToo)
+        {
+        CHECK(!memcmp(local.stepSequencer.muted, played.stepSequencer.muted, MAX_STEP_SEQUENCER_TRACKS));
+        CHECK_EQUAL(local.stepSequencer.solo, played.stepSequencer.solo);
+        }
+
+    memcpy(&local, &played, sizeof(local));
+    memcpy(&data, &playedData, sizeof(data));
+    }
+
+static void play(uint8_t repeat)
+    {
+    create(repeat);
+    uint8_t initial = local.stepSequencer.countdown;
+    uint8_t trackLen = GET_TRACK_LENGTH();
+    for(uint32_t step = 0; step < PASSES * (uint32_t) trackLen; step++)
+        {
+        notePulse = 1;
+        playStepSequencer();
+        compare(step, initial == COUNTDOWN_INFINITE || step / trackLen < initial);
+        if (local.stepSequencer.playState == PLAY_STATE_STOPPED)
+            break;
+        }
+    }
+
+int main()
+    {
+    harnessBoot();
+    options.clock = IGNORE_MIDI_CLOCK;
+
+    for(uint8_t count = 0; count < 16; count++)
+        {
+        play(count);                                    // then STOP
+        play(count | ((SLOT + 1) << 4));                // then this sequence again
+        }
+
+    return harnessDone("StepSeekTest");
+    }
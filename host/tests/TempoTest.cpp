@@ -0,0 +1,94 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// TEMPO TEST
+//////
+////// Checks that the internal clock doesn't drift (see setPulseRate() and updateTimers() in
+////// Timing.cpp).  A tempo is in tenths of a BPM, so pulse k after the first should be
+////// due exactly k * 25000000 / tempo microseconds after it, rounded down.  In 24 hours
+////// that's 3456 * tempo pulses, landing exactly on the 24 hour mark.
+//////
+//////     - For ten minutes we run Gizmo tick by tick, and check that it saw every pulse
+//////       and that the next one is due exactly when it should be.
+//////
+//////     - For 24 hours that would take too long, so we call updateTimers() directly at
+//////       each pulse, a little late as if at the next tick, and check that the pulse
+//////       at the 24 hour mark is due exactly then.
+//////
+////// For comparison we print how far a clock which rounds each pulse to a whole
+////// microsecond would gain after 24 hours.
+
+#include "Harness.h"
+
+#define DAY 86400000000ULL
+#define TEN_MINUTES 600000000ULL
+
+static uint64_t idealDue(uint16_t tempo, uint64_t k)
+    {
+    return k * 25000000ULL / tempo;
+    }
+
+// Sets the tempo, and returns when the first pulse at that tempo is due
+static uint64_t begin(uint16_t tempo)
+    {
+    harnessRunUntil(simTime + 100000);
+    options.tempo = tempo;
+    setPulseRate(tempo);
+    return simTime + (uint32_t)(targetNextPulseTime - (uint32_t) simTime);
+    }
+
+static void ticks(uint16_t tempo)
+    {
+    uint64_t first = begin(tempo);
+    uint32_t start = pulseCount;
+    uint64_t pulses = TEN_MINUTES * tempo / 25000000ULL;              // after the first
+    harnessRunUntil(first + idealDue(tempo, pulses) + TARGET_TICK_TIMESTEP);
+    CHECK_EQUAL(pulseCount - start, pulses + 1);
+    CHECK_EQUAL(targetNextPulseTime, (uint32_t)(first + idealDue(tempo, pulses + 1)));
+    }
+
+static void day(uint16_t tempo)
+    {
+    uint64_t due = begin(tempo);
+    uint64_t first = due;
+    uint64_t pulses = DAY * tempo / 25000000ULL;
+    uint32_t start = pulseCount;
+    uint32_t late = 0;
+    uint64_t wrong = 0;
+    for(uint64_t k = 0; k <= pulses; k++)
+        {
+        if (due != first + idealDue(tempo, k)) wrong++;
+        late = (late + 97) % TARGET_TICK_TIMESTEP;
+        currentTime = (uint32_t)(due + late);
+        pulse = 0;
+        updateTimers();
+        due += (uint32_t)(targetNextPulseTime - (uint32_t) due);
+        }
+    CHECK_EQUAL(wrong, 0);
+    CHECK_EQUAL(pulseCount - start, pulses + 1);
+    CHECK_EQUAL(pulses, 3456ULL * tempo);
+    CHECK_EQUAL(due, first + DAY + idealDue(tempo, 1));
+
+    // a whole number of microseconds per pulse
+    uint32_t rounded = 25000000UL / tempo;
+    double gained = (double) DAY / rounded - pulses;
+    printf("    %5u.%u   %8llu   %16.1f\n", tempo / 10, tempo % 10, (unsigned long long) pulses, gained);
+    }
+
+int main()
+    {
+    static const uint16_t tempos[] = { 10, 333, 1200, 1275, 1337, 9990, 9999 };
+    harnessBoot();
+    options.clock = IGNORE_MIDI_CLOCK;
+
+    for(uint8_t i = 0; i < sizeof(tempos) / sizeof(tempos[0]); i++)
+        ticks(tempos[i]);
+
+    printf("pulses in 24 hours\n");
+    printf("        bpm     pulses   gained if rounded\n");
+    for(uint8_t i = 0; i < sizeof(tempos) / sizeof(tempos[0]); i++)
+        day(tempos[i]);
+
+    return harnessDone("TempoTest");
+    }
@@ -0,0 +1,138 @@
+////// Copyright 2016 by Sean Luke
+////// Licensed under the Apache 2.0 License
+
+
+////// TIMED CLOCK TEST
+//////
+////// Checks the clock bytes Timer3 sends when we generate the clock (see Timing.h):
+//////
+//////     - A Start goes out ahead of the first clock byte, even when the serial port's
+//////       transmit buffer is backed up and the Start has to wait in it.
+//////
+//////     - Changing options.clock from GENERATE to BLOCK in the menu stops the clock
+//////       bytes at once: Timer3 doesn't send one it was waiting to send, so there's one
+//////       clock byte for each pulse before the change and none after.  We can't know
+//////       whether Timer3 is waiting at the moment the option changes, so we try it at
+//////       a range of moments during a pulse.
+//////
+////// 999 BPM makes a pulse only 2.5ms long, so there's a clock byte waiting a good part of
+////// the time.
+
+#include "Harness.h"
+
+#ifndef INCLUDE_TIMED_CLOCK
+
+int main()
+    {
+    printf("TimedClockTest: nothing to test without INCLUDE_TIMED_CLOCK\n");
+    return 0;
+    }
+
+#else
+
+static uint16_t potValue;
+
+static uint16_t readPot(uint8_t channel)
+    {
+    return potValue;
+    }
+
+// Returns the index of the first byte sent equal to b, or harnessNumOut if there isn't one
+static uint32_t firstOut(uint8_t b)
+    {
+    for(uint32_t i = 0; i < harnessNumOut; i++)
+        if (harnessOut[i].b == b) return i;
+    return harnessNumOut;
+    }
+
+// Back to the root menu with the clock stopped, generating, and the pots at zero
+static void reset()
+    {
+    stopClock(false);
+    state = STATE_ROOT;
+    entry = true;
+    options.clock = GENERATE_MIDI_CLOCK;
+    options.clockDivisor = 1;
+    bypass = false;
+    potValue = 0;
+    harnessRunUntil(simTime + 200000);
+    harnessClearOut();
+    }
+
+static void startBehindNotes()
+    {
+    reset();
+    // fill the transmit buffer, and some of the outgoing queue
+    for(uint8_t i = 0; i < 40; i++)
+        queueMIDI(MIDINoteOn, 40 + i, 100, 1);
+    startClock(true);
+    harnessRunUntil(simTime + 100000);
+    CHECK(harnessCountOut(MIDIClock) > 0);
+    CHECK(firstOut(MIDIStart) < firstOut(MIDIClock));
+    }
+
+static uint8_t generating()
+    {
+    return (options.clock == GENERATE_MIDI_CLOCK || options.clock == MERGE_MIDI_CLOCK);
+    }
+
+// Runs one tick, and returns the number of pulses in it for which we should have sent a
+// clock byte.  updateTimers() runs before the menu, so it's the option as the tick starts.
+static uint32_t tickPulses()
+    {
+    uint8_t wasGenerating = generating();
+    uint32_t count = pulseCount;
+    harnessTick();
+    return (wasGenerating ? pulseCount - count : 0);
+    }
+
+// Returns the number of clock bytes sent, less the number of pulses we were generating the
+// clock for, when the menu changes options.clock to BLOCK after the given offset
+static int32_t blockInMenu(uint32_t offset)
+    {
+    reset();
+    startClock(true);
+    uint32_t pulses = 0;
+    uint64_t end = simTime + 10000 + offset;
+    while(simTime < end)
+        pulses += tickPulses();
+    goDownState(STATE_OPTIONS_MIDI_CLOCK);
+    pulses += tickPulses();
+    potValue = 1023;                    // the last item, BLOCK
+
+    // The tick in which the option changes may run late enough that the next pulse is
+    // already due, and Timer3 may rightly have sent its byte before the change.
+    uint32_t due = targetNextPulseTime;
+    uint32_t count = pulseCount;
+    while(generating())
+        {
+        due = targetNextPulseTime;
+        count = pulseCount;
+        pulses += tickPulses();
+        }
+    if (pulseCount == count && TIME_GREATER_THAN_OR_EQUAL((uint32_t) simTime, due))
+        pulses++;
+
+    end = simTime + 100000;
+    while(simTime < end)
+        pulses += tickPulses();
+    CHECK(options.clock == BLOCK_MIDI_CLOCK);
+    return (int32_t) harnessCountOut(MIDIClock) - (int32_t) pulses;
+    }
+
+int main()
+    {
+    harnessBoot();
+    simPotHook = readPot;
+    options.tempo = 9990;
+    setPulseRate(options.tempo);
+
+    startBehindNotes();
+
+    for(uint32_t offset = 0; offset < 2500; offset += 100)
+        CHECK_EQUAL(blockInMenu(offset), 0);
+
+    return harnessDone("TimedClockTest");
+    }
+
+#endif INCLUDE_TIMED_CLOCK